@@ -0,0 +1,18 @@
+#include <stdexcept>
+#include "bench_helpers.h"
+#include "fastaq_handler.h"
+
+std::vector<std::string> load_reads(const std::string& filepath)
+{
+    std::vector<std::string> reads;
+    FastaqHandler fh(filepath);
+    while (not fh.eof()) {
+        try {
+            fh.get_next();
+        } catch (std::out_of_range& err) {
+            break;
+        }
+        reads.push_back(fh.read);
+    }
+    return reads;
+}
@@ -0,0 +1,20 @@
+#ifndef PANDORA_BENCH_HELPERS_H
+#define PANDORA_BENCH_HELPERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// the directory of the test cases, defined by the build
+#ifndef PANDORA_TEST_CASES_DIR
+#define PANDORA_TEST_CASES_DIR "../test/test_cases"
+#endif
+
+// parameters used by pandora by default
+constexpr uint32_t bench_w { 14 };
+constexpr uint32_t bench_k { 15 };
+
+// the reads of a fasta/fastq file
+std::vector<std::string> load_reads(const std::string& filepath);
+
+#endif // PANDORA_BENCH_HELPERS_H
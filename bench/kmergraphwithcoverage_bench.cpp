@@ -0,0 +1,37 @@
+#include <cmath>
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "localPRG.h"
+#include "index.h"
+#include "kmergraphwithcoverage.h"
+#include "simulate.h"
+
+// finds the maximum likelihood path through the kmer graph of a synthetic PRG with the
+// given number of sites, with random coverages
+static void BM_KmerGraphWithCoverageFindMaxPath(benchmark::State& state)
+{
+    Simulator simulator(0);
+    const std::string synthetic_prg
+        = simulator.random_prg(state.range(0), 50, 10, 2, 1);
+    auto index = std::make_shared<Index>();
+    LocalPRG prg(0, "prg", synthetic_prg);
+    prg.minimizer_sketch(index, bench_w, bench_k);
+
+    KmerGraphWithCoverage kmer_graph_with_coverage(&prg.kmer_prg);
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<uint16_t> covg(0, 20);
+    for (uint32_t node_id = 0; node_id < prg.kmer_prg.nodes.size(); ++node_id) {
+        kmer_graph_with_coverage.set_forward_covg(node_id, covg(rng), 0);
+        kmer_graph_with_coverage.set_reverse_covg(node_id, covg(rng), 0);
+    }
+    kmer_graph_with_coverage.set_num_reads(20);
+    kmer_graph_with_coverage.set_binomial_parameter_p(1 / exp(0.11 * bench_k));
+
+    std::vector<KmerNodePtr> max_path;
+    for (auto _ : state) {
+        max_path.clear();
+        benchmark::DoNotOptimize(
+            kmer_graph_with_coverage.find_max_path(max_path, "bin", 100, 0));
+    }
+}
+BENCHMARK(BM_KmerGraphWithCoverageFindMaxPath)->Arg(10)->Arg(30)->Arg(100);
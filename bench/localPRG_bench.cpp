@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "localPRG.h"
+#include "index.h"
+#include "simulate.h"
+#include "utils.h"
+
+// sketches a synthetic PRG with the given number of sites and nesting depth
+static void BM_LocalPRGMinimizerSketch(benchmark::State& state)
+{
+    Simulator simulator(0);
+    const std::string synthetic_prg
+        = simulator.random_prg(state.range(0), 50, 10, 2, state.range(1));
+    auto index = std::make_shared<Index>();
+    for (auto _ : state) {
+        state.PauseTiming();
+        index->clear();
+        LocalPRG prg(0, "prg", synthetic_prg);
+        state.ResumeTiming();
+        prg.minimizer_sketch(index, bench_w, bench_k);
+        benchmark::DoNotOptimize(prg.kmer_prg.nodes.size());
+    }
+}
+BENCHMARK(BM_LocalPRGMinimizerSketch)
+    ->Args({ 10, 0 })
+    ->Args({ 100, 0 })
+    ->Args({ 10, 2 })
+    ->Args({ 100, 2 })
+    ->Unit(benchmark::kMillisecond);
+
+// sketches the PRGs of a test case
+static void BM_LocalPRGMinimizerSketchTestPRGs(benchmark::State& state)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    auto index = std::make_shared<Index>();
+    for (auto _ : state) {
+        state.PauseTiming();
+        prgs.clear();
+        index->clear();
+        read_prg_file(prgs, PANDORA_TEST_CASES_DIR "/prg0123.fa");
+        state.ResumeTiming();
+        for (const auto& prg : prgs) {
+            prg->minimizer_sketch(index, bench_w, bench_k);
+        }
+        benchmark::DoNotOptimize(index->minhash.size());
+    }
+}
+BENCHMARK(BM_LocalPRGMinimizerSketchTestPRGs)->Unit(benchmark::kMillisecond);
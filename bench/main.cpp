@@ -0,0 +1,17 @@
+#include <benchmark/benchmark.h>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+
+int main(int argc, char** argv)
+{
+    // the benchmarked functions log at info level, which would be timed otherwise
+    boost::log::core::get()->set_filter(
+        boost::log::trivial::severity >= boost::log::trivial::warning);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
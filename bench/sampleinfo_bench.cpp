@@ -0,0 +1,27 @@
+#include <random>
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "OptionsAggregator.h"
+#include "sampleinfo.h"
+
+// genotypes a biallelic site whose alleles have the given number of kmers
+static void BM_SampleInfoGenotypeFromCoverage(benchmark::State& state)
+{
+    GenotypingOptions genotyping_options({ 30 }, 0.01, 1, 0, 0, 0, 0, 0, false);
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<uint32_t> covg(0, 30);
+    std::vector<std::vector<uint32_t>> forward_coverages(2), reverse_coverages(2);
+    for (uint32_t allele = 0; allele < 2; ++allele) {
+        for (uint32_t i = 0; i < state.range(0); ++i) {
+            forward_coverages[allele].push_back(covg(rng));
+            reverse_coverages[allele].push_back(covg(rng));
+        }
+    }
+    SampleInfo sample_info(0, 2, &genotyping_options);
+    sample_info.set_coverage_information(forward_coverages, reverse_coverages);
+    for (auto _ : state) {
+        sample_info.genotype_from_coverage();
+        benchmark::DoNotOptimize(sample_info.is_gt_from_coverages_valid());
+    }
+}
+BENCHMARK(BM_SampleInfoGenotypeFromCoverage)->Arg(1)->Arg(10)->Arg(100);
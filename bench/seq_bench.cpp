@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "seq.h"
+#include "simulate.h"
+
+// sketches a random read of the given length
+static void BM_SeqMinimizerSketch(benchmark::State& state)
+{
+    Simulator simulator(0);
+    const std::string read = simulator.random_sequence(state.range(0));
+    Seq sequence;
+    for (auto _ : state) {
+        sequence.initialize(0, "read", read, bench_w, bench_k);
+        benchmark::DoNotOptimize(sequence.sketch.size());
+    }
+    state.SetBytesProcessed(state.iterations() * read.size());
+}
+BENCHMARK(BM_SeqMinimizerSketch)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// sketches the gene sequences of a test case
+static void BM_SeqMinimizerSketchTestSequences(benchmark::State& state)
+{
+    const std::vector<std::string> reads
+        = load_reads(PANDORA_TEST_CASES_DIR "/updatevcf_test.fa");
+    size_t nb_bases = 0;
+    for (const auto& read : reads) {
+        nb_bases += read.size();
+    }
+    Seq sequence;
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < reads.size(); ++i) {
+            sequence.initialize(i, "read", reads[i], bench_w, bench_k);
+            benchmark::DoNotOptimize(sequence.sketch.size());
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * nb_bases);
+}
+BENCHMARK(BM_SeqMinimizerSketchTestSequences);
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "localPRG.h"
+#include "index.h"
+#include "minihits.h"
+#include "seq.h"
+#include "simulate.h"
+#include "utils.h"
+
+// synthetic PRGs, their index, and reads made of random paths through a few
+// consecutive PRGs, with 5% of errors
+struct MappingFixture {
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    std::shared_ptr<Index> index { std::make_shared<Index>() };
+    std::vector<Seq> reads;
+
+    MappingFixture()
+    {
+        Simulator simulator(0);
+        std::vector<std::string> sequences;
+        for (uint32_t i = 0; i < 200; ++i) {
+            const std::string synthetic_prg = simulator.random_prg(10, 50, 10);
+            prgs.push_back(std::make_shared<LocalPRG>(
+                i, "prg" + std::to_string(i), synthetic_prg));
+            prgs.back()->minimizer_sketch(index, bench_w, bench_k);
+            sequences.push_back(simulator.random_path(synthetic_prg));
+        }
+        for (uint32_t i = 0; i + 5 <= sequences.size(); i += 5) {
+            std::string read;
+            for (uint32_t j = i; j < i + 5; ++j) {
+                read += simulator.add_errors(sequences[j], 0.03, 0.01, 0.01);
+            }
+            reads.emplace_back(reads.size(), "read", read, bench_w, bench_k);
+        }
+    }
+
+    static const MappingFixture& get()
+    {
+        static const MappingFixture fixture;
+        return fixture;
+    }
+};
+
+// looks up the hits of the reads in the index
+static void BM_AddReadHits(benchmark::State& state)
+{
+    const MappingFixture& fixture = MappingFixture::get();
+    auto minimizer_hits = std::make_shared<MinimizerHits>();
+    for (auto _ : state) {
+        for (const auto& read : fixture.reads) {
+            minimizer_hits->clear();
+            add_read_hits(read, minimizer_hits, *fixture.index);
+            benchmark::DoNotOptimize(minimizer_hits->hits.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.reads.size());
+}
+BENCHMARK(BM_AddReadHits);
+
+// defines and filters the clusters of hits of the reads, with chaining if the argument
+// is 1. Chaining reorders the hits, so they are restored before each iteration
+static void BM_DefineAndFilterClusters(benchmark::State& state)
+{
+    const MappingFixture& fixture = MappingFixture::get();
+    const bool chain = state.range(0);
+    std::vector<std::shared_ptr<MinimizerHits>> hits_of_reads;
+    std::vector<std::vector<MinimizerHit>> sorted_hits_of_reads;
+    for (const auto& read : fixture.reads) {
+        hits_of_reads.push_back(std::make_shared<MinimizerHits>());
+        add_read_hits(read, hits_of_reads.back(), *fixture.index);
+        sorted_hits_of_reads.push_back(hits_of_reads.back()->hits);
+    }
+    std::vector<MinimizerHitClusterRange> clusters_of_hits;
+    for (auto _ : state) {
+        if (chain) {
+            state.PauseTiming();
+            for (uint32_t i = 0; i < hits_of_reads.size(); ++i) {
+                hits_of_reads[i]->hits = sorted_hits_of_reads[i];
+            }
+            state.ResumeTiming();
+        }
+        for (uint32_t i = 0; i < hits_of_reads.size(); ++i) {
+            clusters_of_hits.clear();
+            define_clusters(clusters_of_hits, fixture.prgs, hits_of_reads[i], 8, 0.1,
+                10, fixture.reads[i].sketch.size(), chain);
+            filter_clusters(clusters_of_hits);
+            benchmark::DoNotOptimize(clusters_of_hits.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.reads.size());
+}
+BENCHMARK(BM_DefineAndFilterClusters)->Arg(0)->Arg(1);
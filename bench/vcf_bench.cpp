@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+#include "bench_helpers.h"
+#include "OptionsAggregator.h"
+#include "vcf.h"
+
+// adds the given number of records to a VCF
+static void BM_VCFAddRecord(benchmark::State& state)
+{
+    GenotypingOptions genotyping_options({ 30 }, 0.01, 1, 0, 0, 0, 0, 0, false);
+    for (auto _ : state) {
+        VCF vcf(&genotyping_options);
+        vcf.add_samples({ "sample" });
+        for (uint32_t position = 0; position < state.range(0); ++position) {
+            vcf.add_record("chrom", position, "A", "G");
+        }
+        benchmark::DoNotOptimize(vcf.get_VCF_size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VCFAddRecord)->Arg(100)->Arg(1000)->Arg(10000);
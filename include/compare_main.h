@@ -12,8 +12,11 @@
 #include <map>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
+#include <boost/algorithm/string/join.hpp>
 
 #include "utils.h"
+#include "run_stats.h"
+#include "trace.h"
 #include "localPRG.h"
 #include "localgraph.h"
 #include "pangenome/pangraph.h"
@@ -36,6 +39,8 @@ struct CompareOptions {
     uint32_t kmer_size { 15 };
     uint32_t threads { 1 };
     fs::path vcf_refs_file;
+    fs::path trace_file;
+    bool mapping_histograms { false };
     uint8_t verbosity { 0 };
     float error_rate { 0.11 };
     uint32_t genome_size { 5000000 };
@@ -48,6 +53,10 @@ struct CompareOptions {
     bool genotype { false };
     bool local_genotype { false };
     uint32_t min_cluster_size { 10 };
+    bool chain_hits { false };
+    bool subsample { false };
+    uint32_t max_read_hits { 0 };
+    uint32_t max_read_prgs { 0 };
     uint32_t max_num_kmers_to_avg { 100 };
     uint32_t min_allele_covg_gt { 0 };
     uint32_t min_total_covg_gt { 0 };
@@ -57,7 +66,7 @@ struct CompareOptions {
     uint16_t confidence_threshold { 1 };
 };
 
-std::vector<std::pair<SampleIdText, SampleFpath>> load_read_index(
+std::vector<std::pair<SampleIdText, SampleFpaths>> load_read_index(
     const fs::path& read_index_fpath);
 void setup_compare_subcommand(CLI::App& app);
 int pandora_compare(CompareOptions& opt);
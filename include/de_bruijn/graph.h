@@ -7,9 +7,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
+#include <vector>
 #include <iostream>
 #include "de_bruijn/ns.cpp"
 #include "de_bruijn/node.h"
+#include "de_bruijn/packed_node_ids.h"
 
 class debruijn::Graph {
 protected:
@@ -17,7 +19,9 @@ protected:
 
 public:
     uint8_t size;
-    sequence_of_genes_to_data_map<std::deque<uint_least32_t>, uint32_t> node_hash;
+    // the id of each node, by its packed hashed node ids (at most
+    // PackedNodeIds::max_size of them, which bounds the size of the graph)
+    PackedNodeIdsMap node_hash;
     std::unordered_map<uint32_t, NodePtr> nodes;
 
     Graph(uint8_t);
@@ -28,6 +32,16 @@ public:
 
     void add_edge(OrientedNodePtr, OrientedNodePtr);
 
+    // Builds the graph from the sequences of hashed pangraph node ids of the reads with
+    // the given ids, with the same nodes, node ids and edges as calling add_node() and
+    // add_edge() along each sequence in turn. The sequences are stored one after the
+    // other, the i-th from sequence_starts[i] to sequence_starts[i + 1]. The nodes are
+    // found in parallel, in a hash table per thread holding a shard of them. The graph
+    // must be empty
+    void build(const std::vector<uint32_t>& read_ids,
+        const std::vector<uint_least32_t>& hashed_node_ids,
+        const std::vector<size_t>& sequence_starts, const uint32_t threads = 1);
+
     void remove_node(const uint32_t);
 
     void remove_read_from_node(const uint32_t, const uint32_t);
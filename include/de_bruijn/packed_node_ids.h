@@ -0,0 +1,122 @@
+#ifndef PANDORA_PACKED_NODE_IDS_H
+#define PANDORA_PACKED_NODE_IDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace debruijn {
+/**
+ * The hashed pangraph node ids (oriented pangraph node ids, see
+ * node_plus_orientation_to_num()) of a de Bruijn graph node packed in 128 bits, 32 bits
+ * per id with the first id in the highest bits, so that they are hashed and compared as
+ * two integers instead of as a std::deque, and comparing them compares the ids
+ * lexicographically. A dbg node has at most max_size ids, the unused slots are 0.
+ */
+struct PackedNodeIds {
+    static constexpr uint32_t max_size = 4;
+
+    uint64_t high;
+    uint64_t low;
+
+    PackedNodeIds()
+        : high(0)
+        , low(0)
+    {
+    }
+
+    PackedNodeIds(const uint64_t high, const uint64_t low)
+        : high(high)
+        , low(low)
+    {
+    }
+
+    inline uint_least32_t get(const uint32_t i) const
+    {
+        const uint64_t word = i < 2 ? high : low;
+        return (uint_least32_t)(word >> (32 * (1 - i % 2)));
+    }
+
+    inline void set(const uint32_t i, const uint_least32_t id)
+    {
+        uint64_t& word = i < 2 ? high : low;
+        const uint32_t shift = 32 * (1 - i % 2);
+        word = (word & ~((uint64_t)UINT32_MAX << shift)) | ((uint64_t)id << shift);
+    }
+
+    inline bool operator==(const PackedNodeIds& other) const
+    {
+        return high == other.high and low == other.low;
+    }
+    inline bool operator!=(const PackedNodeIds& other) const
+    {
+        return !(*this == other);
+    }
+    inline bool operator<(const PackedNodeIds& other) const
+    {
+        return high < other.high or (high == other.high and low < other.low);
+    }
+};
+
+// packs the hashed node ids, of which there must be at most PackedNodeIds::max_size
+PackedNodeIds pack_node_ids(const std::deque<uint_least32_t>& hashed_node_ids);
+PackedNodeIds pack_node_ids(const uint_least32_t* hashed_node_ids, const uint32_t size);
+
+// the reverse complement of the size packed ids, as rc_hashed_node_ids() computes it:
+// the ids in reverse order, each in the other orientation (the lowest bit flipped)
+PackedNodeIds rc_packed_node_ids(const PackedNodeIds& ids, const uint32_t size);
+
+struct PackedNodeIdsHash {
+    size_t operator()(const PackedNodeIds& ids) const;
+};
+
+/**
+ * Hash table from packed node ids to a uint32_t (e.g. the id of their dbg node), with
+ * open addressing and linear probing in a single vector of slots, so that lookups and
+ * insertions do not allocate (but when the table grows). Entries can not be erased, as
+ * the ids of the dbg nodes are never reused.
+ */
+class PackedNodeIdsMap {
+private:
+    struct Slot {
+        PackedNodeIds ids;
+        uint32_t value;
+    };
+    // the value of the free slots, which can not be inserted
+    static constexpr uint32_t free_slot_value = UINT32_MAX;
+
+    // a power of two of them, at most half of them used
+    std::vector<Slot> slots;
+    size_t number_of_entries { 0 };
+
+    // the slot holding the ids, or the free slot where they would be inserted
+    size_t find_slot(const PackedNodeIds& ids) const;
+
+    void rehash(const size_t number_of_slots);
+
+public:
+    inline size_t size() const { return number_of_entries; }
+    inline bool empty() const { return number_of_entries == 0; }
+
+    // removes all entries, keeping the slots
+    void clear();
+
+    void reserve(const size_t entries);
+
+    bool contains(const PackedNodeIds& ids) const;
+
+    // throws std::out_of_range if the ids are not in the table
+    uint32_t at(const PackedNodeIds& ids) const;
+
+    // inserts the entry if the ids are not in the table yet, and returns the value of
+    // the ids in the table and whether it was inserted
+    std::pair<uint32_t, bool> emplace(const PackedNodeIds& ids, const uint32_t value);
+
+    // the slots, in bytes
+    uint64_t estimate_heap_memory_usage() const;
+};
+}
+
+#endif // PANDORA_PACKED_NODE_IDS_H
@@ -10,6 +10,7 @@
 #include <set>
 #include <vector>
 #include <sstream>
+#include <boost/utility/string_view.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/map.hpp>
@@ -101,7 +102,7 @@ public:
     std::string get_max_likelihood_sequence_with_flanks() const;
 
     void add_pileup_entry(
-        const std::string& read, const ReadCoordinate& read_coordinate);
+        const boost::string_view read, const ReadCoordinate& read_coordinate);
 
     virtual std::vector<std::string> get_variants(const string& denovo_sequence) const;
 
@@ -148,6 +149,10 @@ public:
 
     PileupConstructionMap pileup_construction_map(CandidateRegions& candidate_regions);
 
+    void load_candidate_region_pileups(const std::vector<std::string>& reads_filepaths,
+        const CandidateRegions& candidate_regions,
+        const PileupConstructionMap& pileup_construction_map, uint32_t threads = 1);
+
     void load_candidate_region_pileups(const fs::path& reads_filepath,
         const CandidateRegions& candidate_regions,
         const PileupConstructionMap& pileup_construction_map, uint32_t threads = 1);
@@ -1,18 +1,22 @@
 #ifndef PANDORA_DISCOVER_MAIN_H
 #define PANDORA_DISCOVER_MAIN_H
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string/join.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/setup/console.hpp>
 #include "CLI11.hpp"
 #include "utils.h"
+#include "run_stats.h"
+#include "trace.h"
 #include "index.h"
 #include "pangenome/pangraph.h"
 #include "noise_filtering.h"
 #include "estimate_parameters.h"
 #include "denovo_discovery/candidate_region.h"
 #include "denovo_discovery/denovo_discovery.h"
+#include "fastaq_handler.h"
 
 constexpr auto MAX_DENOVO_K { 32 };
 namespace fs = boost::filesystem;
@@ -25,6 +29,8 @@ struct DiscoverOptions {
     uint32_t window_size { 14 };
     uint32_t kmer_size { 15 };
     uint32_t threads { 1 };
+    fs::path trace_file;
+    bool mapping_histograms { false };
     uint8_t verbosity { 0 };
     float error_rate { 0.11 };
     uint32_t genome_size { 5000000 };
@@ -44,6 +50,10 @@ struct DiscoverOptions {
     int max_num_candidate_paths { 25 };
     uint32_t merge_dist { 15 };
     uint32_t min_cluster_size { 10 };
+    bool chain_hits { false };
+    bool subsample { false };
+    uint32_t max_read_hits { 0 };
+    uint32_t max_read_prgs { 0 };
     uint32_t max_num_kmers_to_avg { 100 };
     bool clean_dbg { false };
 };
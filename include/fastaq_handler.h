@@ -2,6 +2,9 @@
 #define __FASTAQ_HANDLER_H_INCLUDED__
 
 #include <string>
+#include <vector>
+#include <future>
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <sstream>
@@ -13,17 +16,43 @@
 #include <cstdio>
 #include <zlib.h>
 #include "kseq.h"
+#include "read_batch.h"
 KSEQ_INIT(gzFile, gzread)
 
 namespace logging = boost::log;
 
+/**
+ * Reads one or several fasta/fastq files (optionally gzipped) as a single stream of
+ * reads, i.e. read ids continue from one file to the next. The filepath "-" denotes the
+ * standard input. While a file is being read, the next one is opened in the background.
+ * All files are checked to be readable when the handler is constructed.
+ */
 struct FastaqHandler {
 private:
     bool closed;
     kseq_t* inbuf;
+    std::vector<std::string> filepaths;
+    size_t current_file_index;
+    std::future<gzFile> next_fastaq_file; // the next file, opened in the background
+
+    static gzFile open_fastaq_file(const std::string& filepath);
+
+    void open_file(const size_t file_index, gzFile fastaq_file);
+
+    void close_current_file();
+
+    void close_prefetched_file();
+
+    bool move_to_next_file();
+
+    void read_next_record();
+
+    void rewind();
 
 public:
-    const std::string filepath;
+    static const std::string stdin_filepath;
+
+    std::string filepath; // the file currently being read
     gzFile fastaq_file;
     std::string name;
     std::string read;
@@ -31,12 +60,18 @@ public:
 
     FastaqHandler(const std::string);
 
+    FastaqHandler(const std::vector<std::string>&);
+
     ~FastaqHandler();
 
     bool eof() const;
 
     void get_next();
 
+    // appends the next read to the batch with the given id, without copying it into
+    // name and read
+    void get_next(ReadBatch& batch, const uint32_t read_id);
+
     void get_nth_read(const uint32_t& idx);
 
     void close();
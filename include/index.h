@@ -41,6 +41,9 @@ public:
 
     void clear();
 
+    // estimated bytes used by the index: the hash table and the minimizer records
+    uint64_t estimate_memory_usage() const;
+
     bool operator==(const Index& other) const;
 
     bool operator!=(const Index& other) const;
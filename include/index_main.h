@@ -15,6 +15,7 @@
 
 #include "utils.h"
 #include "localPRG.h"
+#include "trace.h"
 #include "CLI11.hpp"
 
 /// Collection of all options of index subcommand.
@@ -25,6 +26,7 @@ struct IndexOptions {
     uint32_t threads { 1 };
     uint32_t id_offset { 0 };
     fs::path outfile;
+    fs::path trace_file;
     uint8_t verbosity { 0 };
 };
 
@@ -98,6 +98,9 @@ public:
     uint32_t get_num_reads() const { return num_reads; }
     uint32_t get_total_number_samples() const { return total_number_samples; }
 
+    // bytes allocated for the coverages (the kmer graph itself is not owned)
+    uint64_t estimate_heap_memory_usage() const;
+
     // setters
     void increment_forward_covg(uint32_t node_id, uint32_t sample_id)
     {
@@ -10,12 +10,15 @@
 #include <boost/filesystem.hpp>
 
 #include "utils.h"
+#include "run_stats.h"
+#include "trace.h"
 #include "localPRG.h"
 #include "localgraph.h"
 #include "pangenome/pangraph.h"
 #include "pangenome/pannode.h"
 #include "index.h"
 #include "estimate_parameters.h"
+#include "fastaq_handler.h"
 #include "noise_filtering.h"
 
 #include "denovo_discovery/denovo_utils.h"
@@ -30,12 +33,14 @@ namespace fs = boost::filesystem;
 /// Collection of all options of map subcommand.
 struct MapOptions {
     fs::path prgfile;
-    fs::path readsfile;
+    std::vector<std::string> readsfiles;
     fs::path outdir { "pandora" };
     uint32_t window_size { 14 };
     uint32_t kmer_size { 15 };
     uint32_t threads { 1 };
     fs::path vcf_refs_file;
+    fs::path trace_file;
+    bool mapping_histograms { false };
     uint8_t verbosity { 0 };
     float error_rate { 0.11 };
     uint32_t genome_size { 5000000 };
@@ -52,6 +57,11 @@ struct MapOptions {
     bool local_genotype { false };
     bool snps_only { false };
     uint32_t min_cluster_size { 10 };
+    bool chain_hits { false };
+    bool subsample { false };
+    uint32_t max_read_hits { 0 };
+    uint32_t max_read_prgs { 0 };
+    bool coverage_only { false };
     uint32_t max_num_kmers_to_avg { 100 };
     uint32_t min_allele_covg_gt { 0 };
     uint32_t min_total_covg_gt { 0 };
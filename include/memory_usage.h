@@ -0,0 +1,65 @@
+#ifndef PANDORA_MEMORY_USAGE_H
+#define PANDORA_MEMORY_USAGE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Estimates of the memory used by the main data structures of a run (the index, the
+ * pangraph, the kmer graph coverages, the VCF records), to attribute the resident set
+ * size to them without an external heap profiler. They are computed from the sizes and
+ * capacities of the containers, so they do not account for allocator overheads.
+ */
+
+// name of a data structure and its estimated memory, in bytes
+using MemoryBreakdown = std::vector<std::pair<std::string, uint64_t>>;
+
+// the buffer of a std::vector
+template <class T> inline uint64_t estimate_heap_memory_usage(const std::vector<T>& v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+// the buffer of a std::string, if it is longer than the 15 characters stored inline by
+// the small string optimisation of libstdc++
+inline uint64_t estimate_heap_memory_usage(const std::string& str)
+{
+    return str.capacity() > 15 ? str.capacity() + 1 : 0;
+}
+
+// the buckets and the nodes (the next pointer, the cached hash and the value) of a
+// std::unordered_map, std::unordered_set, etc
+template <class HashTable>
+inline uint64_t estimate_hash_table_heap_memory_usage(const HashTable& table)
+{
+    return table.bucket_count() * sizeof(void*)
+        + table.size() * (2 * sizeof(void*) + sizeof(typename HashTable::value_type));
+}
+
+// the nodes (the colour, three pointers and the value) of a std::map, std::set, etc
+template <class Tree> inline uint64_t estimate_tree_heap_memory_usage(const Tree& tree)
+{
+    return tree.size() * (4 * sizeof(void*) + sizeof(typename Tree::value_type));
+}
+
+// the control block of a std::shared_ptr (the vtable pointer and the two counts)
+constexpr uint64_t shared_ptr_control_block_bytes = sizeof(void*) + 2 * sizeof(int);
+
+// current resident set size of this process, or 0 if it can not be read
+uint64_t get_current_rss_bytes();
+
+// installs a handler of SIGUSR1 that requests a report of the memory breakdown, which
+// is logged at the next point where the data structures can safely be inspected (the
+// end of a phase of the run stats, and after each batch of reads is added to the
+// pangraph when mapping)
+void install_memory_report_signal_handler();
+
+// whether a memory report was requested by a SIGUSR1 since the last call
+bool memory_report_requested();
+
+// logs the breakdown, with the current and peak resident set sizes
+void log_memory_breakdown(const std::string& when, const MemoryBreakdown& breakdown);
+
+#endif // PANDORA_MEMORY_USAGE_H
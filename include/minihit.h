@@ -8,7 +8,10 @@
 #include "fatal_error.h"
 
 /**
- * Describes a hit between a read an a minimizer from the PRG
+ * Describes a hit between a read an a minimizer from the PRG.
+ * This is a small trivially copyable struct, so that the hits of a read can be stored
+ * by value in a flat vector (see MinimizerHits): the fields used to sort and cluster
+ * hits are copied from the MiniRecord, which is only pointed to for its path.
  * TODO: Possible improvement (memory): here we have one MinimizerHit for each (read_id,
  * read_start_position, read_strand) and MiniRecord
  * TODO: Possible improvement (memory): we could make one (read_id, read_start_position,
@@ -21,18 +24,20 @@ private:
     uint32_t
         read_start_position; // TODO: Possible improvement (memory): this can be made a
                              // template and change depending on the maximum read length
-    bool read_strand;
-    const MiniRecord& minimizer_from_PRG;
+    uint32_t prg_id;
+    uint32_t kmer_node_id;
+    bool same_strands; // whether the read and the PRG minimizers are on the same strand
+    const MiniRecord* minimizer_from_PRG; // not owned: it lives in the Index
 
 public:
     inline uint32_t get_read_id() const { return read_id; }
     inline uint32_t get_read_start_position() const { return read_start_position; }
-    inline uint32_t get_prg_id() const { return minimizer_from_PRG.prg_id; }
-    inline const prg::Path& get_prg_path() const { return minimizer_from_PRG.path; }
-    inline uint32_t get_kmer_node_id() const { return minimizer_from_PRG.knode_id; }
+    inline uint32_t get_prg_id() const { return prg_id; }
+    inline const prg::Path& get_prg_path() const { return minimizer_from_PRG->path; }
+    inline uint32_t get_kmer_node_id() const { return kmer_node_id; }
     inline bool is_forward() const
     {
-        return read_strand == minimizer_from_PRG.strand;
+        return same_strands;
     } // TODO: the name of this method is very misleading, should be same_strands() or
       // sth like this
 
@@ -4,13 +4,16 @@
 #include <set>
 #include <unordered_set>
 #include <memory>
+#include <vector>
 #include "minimizer.h"
 #include "minirecord.h"
+#include "minihit.h"
 
 struct MinimizerHit;
 struct pComp;
 typedef std::shared_ptr<MinimizerHit> MinimizerHitPtr;
 typedef std::set<MinimizerHitPtr, pComp> MinimizerHitCluster;
+typedef std::vector<MinimizerHit>::const_iterator MinimizerHitIterator;
 
 struct pComp {
     bool operator()(const MinimizerHitPtr& lhs, const MinimizerHitPtr& rhs);
@@ -36,16 +39,98 @@ struct clusterComp_size {
     bool operator()(const MinimizerHitCluster lhs, const MinimizerHitCluster rhs);
 };
 
+/**
+ * A cluster of hits, described as the [begin, end) range of its hits in the sorted
+ * MinimizerHits::hits: all hits of a cluster are on the same read, PRG and strand, so
+ * they are contiguous there. The fields used to order and filter clusters are cached
+ * in the range, so that clusters are filtered without copying or touching their hits.
+ */
+struct MinimizerHitClusterRange {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t read_id;
+    uint32_t prg_id;
+    bool is_forward;
+    uint32_t first_read_start_position;
+    uint32_t last_read_start_position;
+
+    MinimizerHitClusterRange(const std::vector<MinimizerHit>& hits,
+        const uint32_t begin, const uint32_t end);
+
+    inline uint32_t size() const { return end - begin; }
+};
+
+// same order as clusterComp, for cluster ranges over the given hits
+struct clusterRangeComp {
+    const std::vector<MinimizerHit>& hits;
+    bool operator()(
+        const MinimizerHitClusterRange& lhs, const MinimizerHitClusterRange& rhs) const;
+};
+
+// same order as clusterComp_size, for cluster ranges over the given hits
+struct clusterRangeComp_size {
+    const std::vector<MinimizerHit>& hits;
+    bool operator()(
+        const MinimizerHitClusterRange& lhs, const MinimizerHitClusterRange& rhs) const;
+};
+
+/**
+ * Clusters of hits which own a copy of their hits, e.g. the clusters of all reads of a
+ * batch, staged by a mapping thread until they are added to the pangraph in bulk.
+ */
+struct MinimizerHitClusters {
+    std::vector<MinimizerHit> hits;
+    std::vector<MinimizerHitClusterRange> clusters;
+
+    // copies the given clusters and only the hits they contain
+    void add(const std::vector<MinimizerHitClusterRange>& clusters_to_add,
+        const std::vector<MinimizerHit>& hits_of_clusters);
+
+    void clear()
+    {
+        hits.clear();
+        clusters.clear();
+    }
+
+    inline bool empty() const { return clusters.empty(); }
+};
+
+/**
+ * The hits of a read against the index, stored by value in a flat vector.
+ * Hits are appended in any order by add_hit(), and sort() must be called once all of
+ * them are added: it orders them as MinimizerHit::operator< (i.e. as the clustering
+ * in define_clusters() expects) and removes duplicated hits.
+ * The buffers are kept by clear(), so a MinimizerHits can be reused for many reads
+ * without allocating.
+ */
 class MinimizerHits {
+private:
+    // buffers used by sort(), kept to avoid reallocating them for each read
+    struct SortEntry {
+        uint64_t key; // prg id, strand and read position
+        uint32_t read_id;
+        uint32_t hit_index;
+    };
+    std::vector<SortEntry> sort_entries;
+    std::vector<SortEntry> sort_entries_buffer;
+    std::vector<MinimizerHit> hits_buffer;
+
+    void radix_sort_entries();
+
 public:
+    // sort() keys the hits by their prg id on 31 bits
+    static constexpr uint32_t max_sortable_prg_id { (uint32_t)1 << 31 };
+
     MinimizerHits() = default;
     ~MinimizerHits() = default;
 
-    std::set<MinimizerHitPtr, pComp> hits;
+    std::vector<MinimizerHit> hits;
 
     void add_hit(const uint32_t i, const Minimizer& minimizer_from_read,
         const MiniRecord& minimizer_from_PRG);
 
+    void sort();
+
     void clear() { hits.clear(); }
 
     // friend std::ostream &operator<<(std::ostream &out, const MinimizerHits &m);
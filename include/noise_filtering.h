@@ -24,23 +24,29 @@ bool overlap_backwards(
 
 std::deque<uint_least32_t> rc_hashed_node_ids(const std::deque<uint_least32_t>&);
 
+// the i-th hashed node id in the given orientation, i.e. of rc_hashed_node_ids() if not
+// forward, without building the reverse complement
+uint_least32_t oriented_hashed_node_id(
+    const std::deque<uint_least32_t>&, const uint32_t i, const bool forward);
+
 void dbg_node_ids_to_ids_and_orientations(const debruijn::Graph&,
     const std::deque<uint32_t>&, std::vector<uint_least32_t>&, std::vector<bool>&);
 
-void construct_debruijn_graph(
-    std::shared_ptr<pangenome::Graph> pangraph, debruijn::Graph& dbg);
+void construct_debruijn_graph(std::shared_ptr<pangenome::Graph> pangraph,
+    debruijn::Graph& dbg, const uint32_t threads = 1);
 
 void remove_leaves(std::shared_ptr<pangenome::Graph>, debruijn::Graph&,
     uint_least32_t covg_thresh = 1);
 
-void filter_unitigs(
-    std::shared_ptr<pangenome::Graph>, debruijn::Graph&, const uint_least32_t&);
+void filter_unitigs(std::shared_ptr<pangenome::Graph>, debruijn::Graph&,
+    const uint_least32_t&, const uint32_t threads = 1);
 
 void detangle_pangraph_with_debruijn_graph(
     std::shared_ptr<pangenome::Graph>, debruijn::Graph&);
 
 void clean_pangraph_with_debruijn_graph(std::shared_ptr<pangenome::Graph>,
-    const uint_least32_t, const uint_least32_t, const bool illumina = false);
+    const uint_least32_t, const uint_least32_t, const bool illumina = false,
+    const uint32_t threads = 1);
 
 void write_pangraph_gfa(
     const fs::path& filepath, std::shared_ptr<pangenome::Graph> pangraph);
@@ -0,0 +1,190 @@
+#ifndef PANDORA_DENSE_ID_MAP_H
+#define PANDORA_DENSE_ID_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Map from dense ids (e.g. the ids of the pangraph nodes, which are the PRG ids) to
+ * values, stored in a vector indexed by id: a lookup or an insertion is an array
+ * access, and the entries are iterated in id order. It has the interface of a std::map
+ * (find, at, operator[], erase, etc), and its entries can also be visited by id from a
+ * parallel loop over [0, id_bound()), without copying them. Its memory grows with the
+ * largest id, not with the number of entries, so the ids must be dense.
+ */
+template <class Value> class DenseIdMap {
+public:
+    using key_type = uint32_t;
+    using mapped_type = Value;
+    // the id of an entry must not be modified through an iterator
+    using value_type = std::pair<uint32_t, Value>;
+
+private:
+    // slot i holds the entry with id i, if it is occupied
+    std::vector<value_type> slots;
+    std::vector<bool> occupied;
+    size_t number_of_entries { 0 };
+
+    template <bool is_const> class Iterator {
+    private:
+        using Map =
+            typename std::conditional<is_const, const DenseIdMap, DenseIdMap>::type;
+        Map* map;
+        uint32_t id;
+
+        void skip_free_slots()
+        {
+            while (id < map->slots.size() and not map->occupied[id]) {
+                ++id;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = DenseIdMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = typename std::conditional<is_const, const value_type&,
+            value_type&>::type;
+        using pointer = typename std::conditional<is_const, const value_type*,
+            value_type*>::type;
+
+        Iterator(Map* map, const uint32_t id)
+            : map(map)
+            , id(id)
+        {
+            skip_free_slots();
+        }
+
+        // an iterator converts to a const iterator
+        operator Iterator<true>() const { return Iterator<true>(map, id); }
+
+        reference operator*() const { return map->slots[id]; }
+        pointer operator->() const { return &map->slots[id]; }
+
+        Iterator& operator++()
+        {
+            ++id;
+            skip_free_slots();
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return id == other.id; }
+        bool operator!=(const Iterator& other) const { return id != other.id; }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // one past the largest id that can be occupied
+    inline uint32_t id_bound() const { return slots.size(); }
+    inline bool contains(const uint32_t id) const
+    {
+        return id < slots.size() and occupied[id];
+    }
+
+    inline size_t size() const { return number_of_entries; }
+    inline bool empty() const { return number_of_entries == 0; }
+    inline size_t count(const uint32_t id) const { return contains(id) ? 1 : 0; }
+
+    // reserves the slots of the ids below the given bound
+    void reserve(const uint32_t id_bound)
+    {
+        slots.reserve(id_bound);
+        occupied.reserve(id_bound);
+    }
+
+    void clear()
+    {
+        slots.clear();
+        occupied.clear();
+        number_of_entries = 0;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, id_bound()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, id_bound()); }
+
+    iterator find(const uint32_t id)
+    {
+        return contains(id) ? iterator(this, id) : end();
+    }
+    const_iterator find(const uint32_t id) const
+    {
+        return contains(id) ? const_iterator(this, id) : end();
+    }
+
+    Value& at(const uint32_t id)
+    {
+        if (not contains(id)) {
+            throw std::out_of_range("DenseIdMap::at: no entry with this id");
+        }
+        return slots[id].second;
+    }
+    const Value& at(const uint32_t id) const
+    {
+        if (not contains(id)) {
+            throw std::out_of_range("DenseIdMap::at: no entry with this id");
+        }
+        return slots[id].second;
+    }
+
+    // as for a std::map, inserts a default constructed value if there is no entry with
+    // this id
+    Value& operator[](const uint32_t id)
+    {
+        if (id >= slots.size()) {
+            const uint32_t previous_bound = slots.size();
+            slots.resize((size_t)id + 1);
+            occupied.resize((size_t)id + 1, false);
+            for (uint32_t free_id = previous_bound; free_id < slots.size(); ++free_id) {
+                slots[free_id].first = free_id;
+            }
+        }
+        if (not occupied[id]) {
+            occupied[id] = true;
+            ++number_of_entries;
+        }
+        return slots[id].second;
+    }
+
+    // returns the number of entries erased (0 or 1)
+    size_t erase(const uint32_t id)
+    {
+        if (not contains(id)) {
+            return 0;
+        }
+        slots[id].second = Value();
+        occupied[id] = false;
+        --number_of_entries;
+        return 1;
+    }
+
+    // returns the iterator to the entry following the erased one
+    iterator erase(const iterator& it)
+    {
+        const uint32_t id = it->first;
+        erase(id);
+        return iterator(this, id + 1);
+    }
+
+    // the slots, in bytes (not what the values point to)
+    uint64_t estimate_heap_memory_usage() const
+    {
+        return slots.capacity() * sizeof(value_type) + occupied.capacity() / 8;
+    }
+};
+
+#endif // PANDORA_DENSE_ID_MAP_H
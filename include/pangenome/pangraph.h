@@ -10,6 +10,7 @@ class KmerNode;
 #include <string>
 #include <cstdint>
 #include <unordered_map>
+#include <map>
 #include <ostream>
 #include <vector>
 #include <boost/filesystem.hpp>
@@ -17,6 +18,7 @@ class KmerNode;
 #include "minihits.h"
 #include "localPRG.h"
 #include "pangenome/ns.cpp"
+#include "pangenome/dense_id_map.h"
 
 namespace fs = boost::filesystem;
 
@@ -32,8 +34,10 @@ protected:
 
 public:
     // TODO: move all attributes to private
+    // the reads are indexes over all the input reads, of which those mapped can be a
+    // small part, so they are kept in a tree. The nodes are indexed by PRG id
     std::map<ReadId, ReadPtr> reads;
-    std::unordered_map<NodeId, NodePtr> nodes;
+    DenseIdMap<NodePtr> nodes;
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // declares all default constructors, destructors and assignment operators
@@ -94,6 +98,25 @@ public:
         std::set<MinimizerHitPtr, pComp>& cluster // the cluster itself
     );
 
+    // Same as above, but for a cluster given as a range of sorted hits, which are not
+    // copied (e.g. a MinimizerHitClusterRange over MinimizerHits::hits)
+    void add_hits_between_PRG_and_read(const std::shared_ptr<LocalPRG>& prg,
+        const uint32_t read_id, const MinimizerHitIterator& cluster_begin,
+        const MinimizerHitIterator& cluster_end);
+
+    /**
+     * Same as add_hits_between_PRG_and_read(), but for a coverage-only pangraph: the
+     * hits directly add coverage to the kmergraph of the node (for sample 0), and the
+     * read is only counted in the coverage of the node, so neither the read nor its
+     * hits are stored. add_hits_to_kmergraphs() must not be called afterwards.
+     * To get the coverages add_hits_to_kmergraphs() would, the hits must be all the
+     * hits of the read on the PRG, and number_of_copies the number of clusters they
+     * come from: the read is counted, and its hits added, once per cluster.
+     */
+    void add_coverage_between_PRG_and_read(const std::shared_ptr<LocalPRG>& prg,
+        const uint32_t read_id, const MinimizerHitIterator& hits_begin,
+        const MinimizerHitIterator& hits_end, const uint32_t number_of_copies = 1);
+
     /**
      * Adds hits between the given PRG and sample described as a path of minimizer kmers
      * from the consensus path. This is just used in the global pangraph in pandora
@@ -129,7 +152,7 @@ public:
     void remove_low_covg_nodes(const uint32_t& thresh);
 
     // TODO: possibly refactor the methods below
-    std::unordered_map<uint32_t, NodePtr>::iterator remove_node(NodePtr);
+    DenseIdMap<NodePtr>::iterator remove_node(NodePtr);
     void remove_read(const uint32_t);
     std::vector<WeakNodePtr>::iterator remove_node_from_read(
         std::vector<WeakNodePtr>::iterator, ReadPtr);
@@ -137,7 +160,12 @@ public:
     void split_node_by_reads(std::unordered_set<ReadPtr>&, std::vector<uint_least32_t>&,
         const std::vector<bool>&, const uint_least32_t);
 
-    void add_hits_to_kmergraphs(const uint32_t& sample_id = 0);
+    // sorts the reads of each node by id, once they are all added (e.g. when mapping
+    // ends), so that looking up a read in a node is a binary search
+    void sort_node_reads(const uint32_t threads = 1);
+
+    void add_hits_to_kmergraphs(
+        const uint32_t& sample_id = 0, const uint32_t threads = 1);
 
     void copy_coverages_to_kmergraphs(const Graph&, const uint32_t&);
     std::vector<LocalNodePtr> infer_node_vcf_reference_path(const Node&,
@@ -146,12 +174,25 @@ public:
     std::vector<LocalNodePtr> get_node_closest_vcf_reference(const Node&,
         const uint32_t&, const LocalPRG&,
         const uint32_t& max_num_kmers_to_average) const;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // estimated memory usage, in bytes
+    // the reads, with their hits
+    uint64_t estimate_reads_memory_usage() const;
+    // the nodes, with the reads and samples covering them, but not their coverages
+    uint64_t estimate_nodes_memory_usage() const;
+    // the coverages of the kmer graphs of the nodes
+    uint64_t estimate_kmer_graph_coverages_memory_usage() const;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
     // graph comparison
     bool operator==(const Graph& y) const;
     bool operator!=(const Graph& y) const;
     // graph read/write
     void save_matrix(
         const fs::path& filepath, const std::vector<std::string>& sample_names);
+    // reads are fetched by index, so the read files are rewound and cannot be stdin
+    void save_mapped_read_strings(const std::vector<std::string>& readfilepaths,
+        const fs::path& outdir, int32_t buff = 0);
     void save_mapped_read_strings(
         const fs::path& readfilepath, const fs::path& outdir, int32_t buff = 0);
     friend std::ostream& operator<<(std::ostream& out, const Graph& m);
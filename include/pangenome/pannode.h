@@ -18,9 +18,68 @@ class LocalPRG;
 struct ReadCoordinate;
 using PanReadPtr = std::shared_ptr<pangenome::Read>;
 
+/**
+ * The reads covering a pangraph node, a read being there once for each cluster of its
+ * hits on the node. The reads are owned by the pangraph, so they are kept as plain
+ * pointers in a vector: adding a read to a node is an append, without allocating a
+ * hash node nor updating a reference count under the pangraph lock. A read must thus
+ * be removed from its nodes before it is erased from Graph::reads, as
+ * Graph::remove_read() does, or its pointers in the nodes dangle.
+ * Lookups are const: a binary search if the reads are sorted by id, else a linear
+ * scan. Mapping inserts the reads out of order, so they are sorted by sort_by_id()
+ * when mapping ends.
+ */
+class pangenome::NodeReads {
+public:
+    using iterator = std::vector<Read*>::iterator;
+    using const_iterator = std::vector<Read*>::const_iterator;
+
+private:
+    std::vector<Read*> reads;
+    bool sorted { true };
+
+    // the copies of the read, if the reads are sorted by id
+    std::pair<const_iterator, const_iterator> sorted_copies(const Read* read) const;
+
+public:
+    inline size_t size() const { return reads.size(); }
+    inline bool empty() const { return reads.empty(); }
+    inline iterator begin() { return reads.begin(); }
+    inline iterator end() { return reads.end(); }
+    inline const_iterator begin() const { return reads.begin(); }
+    inline const_iterator end() const { return reads.end(); }
+
+    void insert(Read* read);
+    void insert(const ReadPtr& read) { insert(read.get()); }
+
+    // sorts the reads by id if they are not, so that lookups are binary searches
+    void sort_by_id();
+    inline bool is_sorted_by_id() const { return sorted; }
+
+    // the first copy of the read, or end()
+    const_iterator find(const Read* read) const;
+    const_iterator find(const ReadPtr& read) const { return find(read.get()); }
+    iterator find(const Read* read);
+    iterator find(const ReadPtr& read) { return find(read.get()); }
+
+    // the number of copies of the read
+    size_t count(const Read* read) const;
+    size_t count(const ReadPtr& read) const { return count(read.get()); }
+
+    // removes a single copy of the read
+    iterator erase(const_iterator it) { return reads.erase(it); }
+    // removes all copies of the read, and returns their number
+    size_t erase(const ReadPtr& read);
+
+    inline uint64_t estimate_heap_memory_usage() const
+    {
+        return reads.capacity() * sizeof(Read*);
+    }
+};
+
 class pangenome::Node {
 public:
-    std::unordered_multiset<ReadPtr> reads;
+    NodeReads reads;
     std::set<SamplePtr, SamplePtrSorterBySampleId> samples;
     const uint32_t prg_id; // corresponding the the LocalPRG id - TODO: this is not
                            // needed - we point to the LocalPRG, which has this info
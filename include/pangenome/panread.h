@@ -14,7 +14,9 @@ class pangenome::Read {
 private:
     // TODO: derive this from MinimizerHits?
     // TODO: or maybe keep it here but without the read id, since it is duplicated?
-    std::vector<MinimizerHit*> hits; // store all Minimizer Hits mapping to this read
+    // all Minimizer Hits mapping to this read, sorted and stored by value in one
+    // contiguous buffer, so that adding hits does not allocate each hit on the heap
+    std::vector<MinimizerHit> hits;
     std::vector<WeakNodePtr> nodes;
 
 public:
@@ -23,7 +25,7 @@ public:
 
     // constructor/destructors
     Read(const uint32_t);
-    virtual ~Read();
+    virtual ~Read() = default;
 
     // TODO: this can be a source of time inneficiency at the cost of using less memory
     // TODO: check if we should fallback to representing hits as
@@ -31,6 +33,12 @@ public:
     std::unordered_map<uint32_t, std::vector<MinimizerHitPtr>>
     get_hits_as_unordered_map() const;
 
+    // the hits of this read on the given node, as a non-owning range over the hits of
+    // this read (hits are sorted by node), so no hit is copied
+    // NB: the range is invalidated by add_hits()
+    std::pair<MinimizerHitIterator, MinimizerHitIterator> get_hits_of_node(
+        const uint32_t node_id) const;
+
     const std::vector<WeakNodePtr>& get_nodes() const { return nodes; }
     // TODO: this getter allows the caller to the private attribute nodes, use with
     // care...
@@ -42,20 +50,17 @@ public:
 
     std::vector<WeakNodePtr>::iterator find_node_by_id(uint32_t node_id);
 
+    // bytes allocated for the hits, nodes and orientations of this read
+    uint64_t estimate_heap_memory_usage() const;
+
     // modifiers
-    void add_node(const NodePtr& nodePtr)
-    {
-        nodes.push_back(nodePtr);
-        nodes.shrink_to_fit();
-    }
-    void add_orientation(bool orientation)
-    {
-        node_orientations.push_back(orientation);
-        node_orientations.shrink_to_fit();
-    }
+    void add_node(const NodePtr& nodePtr) { nodes.push_back(nodePtr); }
+    void add_orientation(bool orientation) { node_orientations.push_back(orientation); }
 
     void add_hits(
         const NodePtr& node_ptr, const std::set<MinimizerHitPtr, pComp>& cluster);
+    void add_hits(const NodePtr& node_ptr, const MinimizerHitIterator& cluster_begin,
+        const MinimizerHitIterator& cluster_end);
 
     std::pair<uint32_t, uint32_t> find_position(const std::vector<uint_least32_t>&,
         const std::vector<bool>&, const uint16_t min_overlap = 1);
@@ -168,6 +168,13 @@ public:
 
     const std::vector<Interval>& getPath() const { return path; }
 
+    // bytes allocated by this path for its intervals and memoized local nodes
+    size_t estimate_heap_memory_usage() const
+    {
+        return path.capacity() * sizeof(Interval)
+            + memoizedLocalNodePath.capacity() * sizeof(LocalNodePtr);
+    }
+
     // some getters
     uint32_t get_start() const;
 
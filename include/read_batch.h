@@ -0,0 +1,91 @@
+#ifndef PANDORA_READ_BATCH_H
+#define PANDORA_READ_BATCH_H
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <boost/utility/string_view.hpp>
+
+/**
+ * A batch of reads stored in one contiguous arena: all names are concatenated in one
+ * buffer and all sequences in another, and each read is just a set of offsets into
+ * them. A batch is filled once (e.g. by FastaqHandler::get_next(ReadBatch&, ...)),
+ * and then its reads are accessed as non-owning views.
+ * NB: views returned by get_name()/get_sequence() are invalidated by add() and clear()
+ */
+class ReadBatch {
+private:
+    struct ReadRecord {
+        uint32_t id;
+        uint64_t name_offset;
+        uint32_t name_length;
+        uint64_t sequence_offset;
+        uint64_t sequence_length;
+    };
+
+    std::string names;
+    std::string sequences;
+    std::vector<ReadRecord> records;
+
+public:
+    ReadBatch() = default;
+
+    void add(const uint32_t id, const char* name, const size_t name_length,
+        const char* sequence, const size_t sequence_length);
+
+    // clears the batch but keeps the allocated memory, so it can be refilled without
+    // any allocation
+    void clear();
+
+    inline size_t size() const { return records.size(); }
+    inline bool empty() const { return records.empty(); }
+    inline uint64_t get_number_of_bases() const { return sequences.size(); }
+
+    inline uint32_t get_id(const size_t i) const { return records[i].id; }
+    inline boost::string_view get_name(const size_t i) const
+    {
+        return boost::string_view(
+            names.data() + records[i].name_offset, records[i].name_length);
+    }
+    inline boost::string_view get_sequence(const size_t i) const
+    {
+        return boost::string_view(sequences.data() + records[i].sequence_offset,
+            records[i].sequence_length);
+    }
+};
+
+/**
+ * Decides how many bases to load in the next ReadBatch. Batches are bounded by their
+ * number of bases rather than their number of reads, so that a batch of long reads and
+ * a batch of short reads take roughly the same time to process. The size is then
+ * adapted after each batch from the observed throughput, so that each batch takes
+ * around target_seconds_per_batch: big enough to amortize the read file lock, small
+ * enough to balance the load between threads and to bound memory.
+ * Not thread-safe: each thread is expected to keep its own ReadBatchSizer.
+ */
+class ReadBatchSizer {
+private:
+    const uint64_t min_nb_bases;
+    const uint64_t max_nb_bases;
+    const double target_seconds_per_batch;
+    uint64_t nb_bases;
+
+public:
+    static constexpr uint64_t default_initial_nb_bases { 1000000 };
+    static constexpr uint64_t default_min_nb_bases { 100000 };
+    static constexpr uint64_t default_max_nb_bases { 50000000 };
+    static constexpr double default_target_seconds_per_batch { 0.5 };
+
+    ReadBatchSizer(const uint64_t initial_nb_bases = default_initial_nb_bases,
+        const uint64_t min_nb_bases = default_min_nb_bases,
+        const uint64_t max_nb_bases = default_max_nb_bases,
+        const double target_seconds_per_batch = default_target_seconds_per_batch);
+
+    // number of bases to load in the next batch
+    inline uint64_t get_nb_bases() const { return nb_bases; }
+
+    // feedback from a processed batch
+    void update(const uint64_t nb_bases_processed, const double seconds_taken);
+};
+
+#endif // PANDORA_READ_BATCH_H
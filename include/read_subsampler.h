@@ -0,0 +1,44 @@
+#ifndef PANDORA_READ_SUBSAMPLER_H
+#define PANDORA_READ_SUBSAMPLER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <boost/utility/string_view.hpp>
+
+/**
+ * Randomly subsamples reads to a given fraction, e.g. to reach a target depth of
+ * coverage without only mapping the first reads of the files, which can be biased
+ * (e.g. towards the start of a flowcell run). A read is kept if the hash of its name
+ * falls below the fraction, so the decision is cheap, taken before the read is
+ * sketched, does not depend on the order in which threads process the reads, and is
+ * reproducible between runs.
+ */
+class ReadSubsampler {
+private:
+    double fraction;
+    uint64_t max_kept_hash;
+    bool keep_all;
+
+public:
+    explicit ReadSubsampler(const double fraction = 1.0);
+
+    // the fraction of reads to keep to get to target_covg, given the total number of
+    // bases of the reads; 1.0 if the reads do not exceed target_covg
+    static double fraction_for_target_covg(const uint64_t total_nb_bases,
+        const uint32_t genome_size, const uint32_t target_covg);
+
+    // estimates the total number of bases in the given read files without reading them
+    // in full: the bases of a prefix of each file (of about prefix_nb_bases) are scaled
+    // by the ratio of the file size to the (compressed) bytes read for that prefix.
+    // Files shorter than the prefix are counted exactly. The files can not be the
+    // standard input, whose size is unknown
+    static uint64_t estimate_number_of_bases(const std::vector<std::string>& filepaths,
+        const uint64_t prefix_nb_bases = 1 << 22);
+
+    inline double get_fraction() const { return fraction; }
+
+    bool keep(const boost::string_view read_name) const;
+};
+
+#endif // PANDORA_READ_SUBSAMPLER_H
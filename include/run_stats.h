@@ -0,0 +1,182 @@
+#ifndef PANDORA_RUN_STATS_H
+#define PANDORA_RUN_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "memory_usage.h"
+
+namespace fs = boost::filesystem;
+
+// user and system CPU time of this process and of its terminated and waited for
+// children (e.g. the processes forked by discover)
+double get_cpu_seconds();
+
+// peak resident set size of this process so far
+uint64_t get_peak_rss_bytes();
+
+// writes the given string as a JSON string, with quotes and escapes
+void write_json_string(std::ostream& out, const std::string& str);
+
+/**
+ * Distribution of non-negative values (e.g. the number of hits of each read) in power
+ * of two buckets: [0], [1], [2, 3], [4, 7], etc. Adding a value is a few instructions,
+ * so it can be done in hot loops, with a histogram per thread merged at the end.
+ */
+class Histogram {
+public:
+    static constexpr uint32_t number_of_buckets = 65;
+
+private:
+    std::array<uint64_t, number_of_buckets> bucket_counts {};
+    uint64_t count { 0 };
+    uint64_t sum { 0 };
+    uint64_t max { 0 };
+
+public:
+    static inline uint32_t bucket_of(const uint64_t value)
+    {
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+    }
+    static inline uint64_t bucket_min(const uint32_t bucket)
+    {
+        return bucket == 0 ? 0 : (uint64_t)1 << (bucket - 1);
+    }
+    static inline uint64_t bucket_max(const uint32_t bucket)
+    {
+        return bucket == 0 ? 0 : bucket_min(bucket) + (bucket_min(bucket) - 1);
+    }
+
+    inline void add(const uint64_t value)
+    {
+        ++bucket_counts[bucket_of(value)];
+        ++count;
+        sum += value;
+        max = std::max(max, value);
+    }
+
+    void merge(const Histogram& other);
+
+    inline uint64_t get_count() const { return count; }
+    inline uint64_t get_sum() const { return sum; }
+    inline uint64_t get_max() const { return max; }
+    inline double get_mean() const { return count == 0 ? 0 : (double)sum / count; }
+    inline uint64_t get_bucket_count(const uint32_t bucket) const
+    {
+        return bucket_counts[bucket];
+    }
+};
+
+/**
+ * Timing and memory report of a run: the phases of the run (e.g. loading the index,
+ * mapping the reads), which can be nested, with their wall time, CPU time and the peak
+ * resident set size of the process since it started, as of the end of the phase (the
+ * peak of a phase is only known when it exceeds those of the previous ones), plus
+ * counts of the items they processed (e.g. reads, bases) from which their throughput
+ * is computed, and the estimated memory of the tracked data structures when they end,
+ * and histograms of the items they processed (e.g. the number of hits per read). When
+ * the run is traced, the phases are also spans of the main thread in the trace.
+ * It is saved as pandora.stats.json, to attribute run time and memory without an
+ * external profiler. Phases are started and ended by the main thread only.
+ */
+class RunStats {
+public:
+    struct Phase {
+        std::string name;
+        double wall_seconds { 0 };
+        double cpu_seconds { 0 };
+        uint64_t process_peak_rss_bytes { 0 }; // since the process started
+        std::vector<std::pair<std::string, uint64_t>> counts;
+        MemoryBreakdown memory_bytes;
+        std::vector<std::pair<std::string, Histogram>> histograms;
+        std::vector<size_t> subphases; // indexes in RunStats::phases
+
+        // used to compute the times of the phase when it ends
+        std::chrono::steady_clock::time_point start_time;
+        double start_cpu_seconds { 0 };
+        double start_trace_us { 0 }; // when the run is traced
+    };
+
+private:
+    std::string command;
+    std::vector<Phase> phases;
+    std::vector<size_t> top_level_phases;
+    std::vector<size_t> open_phases;
+    std::chrono::steady_clock::time_point start_time;
+    double start_cpu_seconds;
+    std::vector<std::pair<std::string, std::function<uint64_t()>>> memory_estimators;
+
+    void write_phase(
+        std::ostream& out, const size_t phase_index, const uint32_t indent) const;
+
+    void end_innermost_phase();
+
+public:
+    explicit RunStats(const std::string& command);
+
+    // returns the index of the phase, to end it with end_phase(phase_index)
+    size_t start_phase(const std::string& name);
+
+    // ends the innermost phase
+    void end_phase();
+
+    // ends the given phase, and first the phases started in it which are still open.
+    // Does nothing if the phase is already ended (e.g. by save())
+    void end_phase(const size_t phase_index);
+
+    // adds a count of items processed by the innermost phase
+    void add_count(const std::string& item, const uint64_t count);
+
+    // adds a histogram of the items processed by the innermost phase
+    void add_histogram(const std::string& name, const Histogram& histogram);
+
+    // the memory of a data structure, computed by the given estimator, is recorded at
+    // the end of each phase until it is untracked, which must be done before the data
+    // structure is destroyed
+    void track_memory(const std::string& name, std::function<uint64_t()> estimator);
+    void untrack_memory(const std::string& name);
+
+    // the current estimated memory of each tracked data structure
+    MemoryBreakdown get_memory_breakdown() const;
+
+    inline const std::vector<Phase>& get_phases() const { return phases; }
+
+    // ends all phases, and writes the report as JSON
+    void save(const fs::path& filepath);
+};
+
+// starts a phase of the run stats, which ends when going out of scope
+class ScopedPhase {
+private:
+    RunStats& run_stats;
+    size_t phase_index;
+
+public:
+    ScopedPhase(RunStats& run_stats, const std::string& name)
+        : run_stats(run_stats)
+        , phase_index(run_stats.start_phase(name))
+    {
+    }
+
+    ~ScopedPhase()
+    {
+        // not throwing from the destructor: if ending the phase fails, it is left open
+        // and ended by RunStats::save()
+        try {
+            run_stats.end_phase(phase_index);
+        } catch (const std::exception& err) {
+        }
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+};
+
+#endif // PANDORA_RUN_STATS_H
@@ -267,6 +267,9 @@ public:
     virtual std::string to_string(bool genotyping_from_maximum_likelihood,
         bool genotyping_from_compatible_coverage) const;
 
+    // bytes allocated for the coverages of the alleles
+    virtual uint64_t estimate_heap_memory_usage() const;
+
 protected:
     uint32_t sample_index;
     uint32_t number_of_alleles;
@@ -5,22 +5,44 @@
 #include <cstdint>
 #include <set>
 #include <ostream>
+#include <boost/utility/string_view.hpp>
 #include "minimizer.h"
 
 class Seq {
+private:
+    // backing storage for name and seq when this Seq owns its data. When it is
+    // initialised as a view (e.g. over a ReadBatch), these are left empty.
+    std::string owned_name;
+    std::string owned_seq;
+    bool owns_data;
+
+    void bind_views_to_owned_data();
+
 public:
     uint32_t id;
-    std::string name;
-    std::string seq;
+    boost::string_view name;
+    boost::string_view seq;
     std::set<Minimizer> sketch;
 
+    Seq();
+
     Seq(uint32_t, const std::string&, const std::string&, uint32_t, uint32_t);
 
+    Seq(const Seq& other);
+
+    Seq& operator=(const Seq& other);
+
     ~Seq();
 
+    // copies the given name and sequence into this Seq and sketches it
     void initialize(
         uint32_t, const std::string&, const std::string&, uint32_t, uint32_t);
 
+    // makes this Seq a view over the given name and sequence (no copy) and sketches it.
+    // The caller must keep the viewed data alive while this Seq is used.
+    void initialize_view(
+        uint32_t, boost::string_view, boost::string_view, uint32_t, uint32_t);
+
     bool add_letter_to_get_next_kmer(const char&, const uint64_t&, const uint64_t&,
         uint32_t&, uint64_t (&)[2], uint64_t (&)[2]);
 
@@ -0,0 +1,65 @@
+#ifndef PANDORA_SIMULATE_H
+#define PANDORA_SIMULATE_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Generates synthetic data to benchmark pandora at a controlled scale: random PRG
+ * strings with a given number of variant sites, number of alleles and nesting depth,
+ * truth sequences sampled as random paths through PRGs, and reads sampled from a truth
+ * genome with substitution, insertion and deletion errors.
+ * All draws come from a single seeded generator, so a simulation is reproducible.
+ */
+class Simulator {
+private:
+    std::mt19937 rng;
+
+    // appends a site, whose first allele contains a nested site if nesting_depth > 0
+    void add_random_site(std::string& prg, uint32_t& next_site_id,
+        const uint32_t allele_length, const uint32_t nb_alleles,
+        const uint32_t nesting_depth);
+
+    // appends a random path through the PRG tokens starting at index i to path, until
+    // the end of the PRG or of the allele of the enclosing site; returns the index of
+    // the token ending the allele
+    size_t add_random_path(const std::vector<std::string>& prg_tokens, size_t i,
+        std::string& path, const uint32_t enclosing_site_id);
+
+public:
+    explicit Simulator(const uint32_t seed = 0);
+
+    std::string random_sequence(const size_t length);
+
+    // a PRG with nb_sites sites of nb_alleles alleles of allele_length bases, each
+    // preceded by site_spacing invariant bases, and followed by site_spacing invariant
+    // bases at the end of the PRG. Site and allele markers are separated from
+    // sequences by spaces, as in the PRGs built by make_prg
+    std::string random_prg(const uint32_t nb_sites, const uint32_t site_spacing,
+        const uint32_t allele_length, const uint32_t nb_alleles = 2,
+        const uint32_t nesting_depth = 0);
+
+    // the sequence of a path through the given PRG, choosing uniformly one allele of
+    // each site it goes through
+    std::string random_path(const std::string& prg);
+
+    // the sequence with, at each base, an inserted random base with probability
+    // insertion_rate, and then the base either deleted with probability deletion_rate
+    // or substituted by another base with probability substitution_rate
+    std::string add_errors(const std::string& sequence, const double substitution_rate,
+        const double insertion_rate, const double deletion_rate);
+
+    // a read of read_length bases (or the whole genome if it is shorter) at a random
+    // position and on a random strand of the genome, with errors as in add_errors()
+    std::string random_read(const std::string& genome, const uint32_t read_length,
+        const double substitution_rate, const double insertion_rate,
+        const double deletion_rate);
+
+    // number of reads of read_length bases to sample to cover the genome to depth
+    static uint64_t number_of_reads_for_depth(
+        const uint64_t genome_length, const uint32_t read_length, const double depth);
+};
+
+#endif // PANDORA_SIMULATE_H
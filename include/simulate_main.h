@@ -0,0 +1,37 @@
+#ifndef PANDORA_SIMULATE_MAIN_H
+#define PANDORA_SIMULATE_MAIN_H
+
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+
+#include "simulate.h"
+#include "utils.h"
+#include "CLI11.hpp"
+
+namespace fs = boost::filesystem;
+
+struct SimulateOptions {
+    fs::path outdir { "pandora_simulate" };
+    uint32_t num_loci { 100 };
+    uint32_t num_sites { 10 };
+    uint32_t site_spacing { 50 };
+    uint32_t allele_length { 10 };
+    uint32_t num_alleles { 2 };
+    uint32_t nesting_depth { 0 };
+    uint32_t intergenic_length { 100 };
+    uint32_t num_genomes { 1 };
+    double depth { 30.0 };
+    uint32_t read_length { 1000 };
+    double substitution_rate { 0.01 };
+    double insertion_rate { 0.005 };
+    double deletion_rate { 0.005 };
+    uint32_t seed { 0 };
+    bool compress { false };
+    uint8_t verbosity { 0 };
+};
+
+void setup_simulate_subcommand(CLI::App& app);
+int pandora_simulate(SimulateOptions const& opt);
+#endif // PANDORA_SIMULATE_MAIN_H
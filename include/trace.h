@@ -0,0 +1,143 @@
+#ifndef PANDORA_TRACE_H
+#define PANDORA_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+// the arguments of a span (e.g. the PRG and node ids), shown when selecting it
+using TraceArgs = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Timeline of the parallel tasks of a run, saved in the Chrome trace event format (to
+ * be opened with https://ui.perfetto.dev or chrome://tracing): a span for each task
+ * (e.g. the consensus of a pangraph node) on the OpenMP thread that ran it, for the
+ * waits to enter the critical sections, for the phases of the run and for the forked
+ * processes. This shows load imbalance and lock contention between the threads.
+ * Spans are recorded in a buffer per thread, so that tracing does not add contention.
+ */
+class Tracer {
+public:
+    struct Event {
+        std::string name;
+        std::string category;
+        double start_us;
+        double duration_us;
+        int32_t pid;
+        uint32_t tid;
+        TraceArgs args;
+    };
+
+private:
+    std::string process_name;
+    int32_t pid;
+    std::chrono::steady_clock::time_point start_time;
+
+    // the events of each OpenMP thread, indexed by thread number
+    std::vector<std::vector<Event>> events_per_thread;
+
+    // the events of nested parallel regions and of other processes, which can not use
+    // the buffers per thread
+    std::mutex shared_events_mutex;
+    std::vector<Event> shared_events;
+
+public:
+    Tracer(const std::string& process_name, const uint32_t threads);
+
+    // microseconds since the tracer was created
+    double now() const;
+
+    // records a span of the calling thread
+    void add_span(const std::string& name, const std::string& category,
+        const double start_us, const double end_us, TraceArgs args = {});
+
+    // records a span of another process (e.g. a forked worker)
+    void add_process_span(const std::string& name, const std::string& category,
+        const int32_t process_id, const double start_us, const double end_us,
+        TraceArgs args = {});
+
+    std::vector<Event> get_events() const;
+
+    void save(const fs::path& filepath) const;
+};
+
+// the tracer that records the spans of the functions below, which do nothing when it
+// is nullptr (the default, as tracing is opt-in)
+void set_run_tracer(Tracer* tracer);
+Tracer* get_run_tracer();
+
+// the current time of the run tracer, or 0 when not tracing
+double trace_timestamp();
+
+// records the wait of the calling thread to enter the given critical section, which
+// started at wait_start_us (from trace_timestamp()); waits under a microsecond are
+// not recorded, as these are uncontended
+void trace_lock_wait(const char* critical_section_name, const double wait_start_us);
+
+// a span of the run tracer from construction to destruction, on the calling thread
+class TraceSpan {
+private:
+    Tracer* tracer;
+    const char* name;
+    const char* category;
+    double start_us;
+    TraceArgs args;
+
+public:
+    TraceSpan(const char* name, const char* category)
+        : tracer(get_run_tracer())
+        , name(name)
+        , category(category)
+        , start_us(tracer ? tracer->now() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (tracer) {
+            tracer->add_span(name, category, start_us, tracer->now(), std::move(args));
+        }
+    }
+
+    void add_arg(const char* key, const std::string& value)
+    {
+        if (tracer) {
+            args.emplace_back(key, value);
+        }
+    }
+
+    void add_arg(const char* key, const uint64_t value)
+    {
+        if (tracer) {
+            args.emplace_back(key, std::to_string(value));
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// creates the run tracer if a trace file is given, and saves it when going out of
+// scope, also when the run fails
+class ScopedRunTracer {
+private:
+    fs::path filepath;
+    std::unique_ptr<Tracer> tracer;
+
+public:
+    ScopedRunTracer(
+        const fs::path& filepath, const std::string& command, const uint32_t threads);
+    ~ScopedRunTracer();
+
+    ScopedRunTracer(const ScopedRunTracer&) = delete;
+    ScopedRunTracer& operator=(const ScopedRunTracer&) = delete;
+};
+
+#endif // PANDORA_TRACE_H
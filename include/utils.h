@@ -14,6 +14,7 @@
 #include <boost/log/trivial.hpp>
 #include <sstream>
 #include "fatal_error.h"
+#include "run_stats.h"
 
 namespace fs = boost::filesystem;
 
@@ -76,29 +77,148 @@ void load_PRG_kmergraphs(std::vector<std::shared_ptr<LocalPRG>>& prgs,
 
 void load_vcf_refs_file(const fs::path& filepath, VCFRefs& vcf_refs);
 
-void add_read_hits(const Seq&, const std::shared_ptr<MinimizerHits>&, const Index&);
+// distributions of the hot path of mapping, to tune max_diff, min_cluster_size and the
+// error rate without trace logs. They are per read unless stated otherwise
+struct MappingHistograms {
+    Histogram sketch_size; // minimizers in the read sketch
+    Histogram index_hits; // hits of these minimizers in the index
+    // hits on each PRG hit by the read, for the reads with more than min_cluster_size
+    // hits and at most max_read_hits hits
+    Histogram hits_per_prg;
+    Histogram candidate_cluster_size; // hits in each cluster defined
+    Histogram clusters_before_filter; // clusters big enough to be kept
+    Histogram clusters_after_filter; // clusters left by filter_clusters()
+
+    // reasons of cluster rejections
+    uint64_t nb_clusters_below_min_cluster_size { 0 };
+    uint64_t nb_clusters_below_length_threshold { 0 }; // the fraction of kmers
+    uint64_t nb_clusters_overlapping { 0 }; // removed by filter_clusters()
+
+    void merge(const MappingHistograms& other);
+};
+
+// the outcome of looking up the hits of a read, see add_read_hits()
+enum class ReadHitsStatus {
+    Added,
+    TooFewHits, // no PRG with more than min_cluster_size hits
+    TooManyHits, // more than max_hits hits
+    TooManyPrgs, // hits on more than max_prgs PRGs
+};
 
-void define_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp>&,
+// the buffers of add_read_hits(), which a thread mapping many reads keeps to reuse them
+struct ReadHitsScratch {
+    // the index entries of the minimizers of the read
+    std::vector<std::pair<const Minimizer*, const std::vector<MiniRecord>*>>
+        index_entries;
+    // the PRG of each of the records of these entries
+    std::vector<uint32_t> hit_prg_ids;
+};
+
+// adds the hits of the read to the MinimizerHits, unless the read can not have any
+// cluster (no PRG with more than min_cluster_size hits) or exceeds the given limits on
+// its number of hits or of PRGs hit (0 means no limit): then no hit is added
+// If given, the sketch size, hits and hits per PRG of the read are added to histograms,
+// and the buffers of the scratch are used instead of allocating new ones
+ReadHitsStatus add_read_hits(const Seq&, const std::shared_ptr<MinimizerHits>&,
+    const Index&, const uint32_t min_cluster_size = 0, const uint32_t max_hits = 0,
+    const uint32_t max_prgs = 0, MappingHistograms* histograms = nullptr,
+    ReadHitsScratch* scratch = nullptr);
+
+// Chains the colinear hits of the cluster [begin, end) of the sorted hits. The hits of
+// the cluster are reordered so that each chain is a range of hits, and these ranges
+// are returned, best scoring chain first
+std::vector<std::pair<uint32_t, uint32_t>> chain_hits(std::vector<MinimizerHit>& hits,
+    const uint32_t begin, const uint32_t end, const int max_diff);
+
+// the clusters are ranges over the (sorted) hits, ordered as clusterRangeComp. If
+// chain is true, each cluster is split into its colinear chains of hits
+void define_clusters(std::vector<MinimizerHitClusterRange>&,
     const std::vector<std::shared_ptr<LocalPRG>>&, std::shared_ptr<MinimizerHits>,
-    const int, const float&, const uint32_t, const uint32_t);
+    const int, const float&, const uint32_t, const uint32_t, const bool chain = false,
+    MappingHistograms* histograms = nullptr);
+
+void filter_clusters(std::vector<MinimizerHitClusterRange>&);
+
+void filter_clusters2(std::vector<MinimizerHitClusterRange>&,
+    const std::vector<MinimizerHit>&, const uint32_t&);
 
-void filter_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp>&);
+// defines and filters the clusters of hits of a read, and appends them to the staged
+// clusters instead of adding them to the pangraph
+void stage_localPRG_order_for_read(const std::vector<std::shared_ptr<LocalPRG>>& prgs,
+    std::shared_ptr<MinimizerHits> minimizer_hits, MinimizerHitClusters&, const int,
+    const float&, const uint32_t min_cluster_size = 10,
+    const uint32_t expected_number_kmers_in_short_read_sketch
+    = std::numeric_limits<uint32_t>::max(),
+    const bool chain = false, MappingHistograms* histograms = nullptr);
+
+// adds the coverage of the clusters to a coverage-only pangraph, see
+// pangenome::Graph::add_coverage_between_PRG_and_read()
+void add_clusters_coverage_to_pangraph(const std::vector<MinimizerHitClusterRange>&,
+    const std::vector<MinimizerHit>&, std::shared_ptr<pangenome::Graph>,
+    const std::vector<std::shared_ptr<LocalPRG>>&);
 
-void filter_clusters2(
-    std::set<std::set<MinimizerHitPtr, pComp>, clusterComp>&, const uint32_t&);
+void add_clusters_to_pangraph(const std::vector<MinimizerHitClusterRange>&,
+    const std::vector<MinimizerHit>&, std::shared_ptr<pangenome::Graph>,
+    const std::vector<std::shared_ptr<LocalPRG>>&, const bool coverage_only = false);
 
 void infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>>& prgs,
     std::shared_ptr<MinimizerHits> minimizer_hits, std::shared_ptr<pangenome::Graph>,
     const int, const uint32_t&, const float&, const uint32_t min_cluster_size = 10,
     const uint32_t expected_number_kmers_in_short_read_sketch
-    = std::numeric_limits<uint32_t>::max());
+    = std::numeric_limits<uint32_t>::max(),
+    const bool chain = false);
+
+// counts of the reads processed by pangraph_from_read_file()
+struct MappingStats {
+    uint64_t nb_reads { 0 }; // reads read from the files
+    uint64_t nb_bases { 0 }; // bases of these reads
+    uint64_t nb_reads_sketched { 0 }; // reads whose hits were looked up
+    uint64_t nb_reads_rejected { 0 }; // too few hits to have a cluster
+    uint64_t nb_reads_with_too_many_hits { 0 };
+    uint64_t nb_reads_with_too_many_prgs { 0 };
+    bool has_histograms { false }; // if MappingOptions::mapping_histograms
+    MappingHistograms histograms;
+};
+
+// the options of pangraph_from_read_file(), as given to map, compare and discover
+struct MappingOptions {
+    uint32_t window_size { 14 };
+    uint32_t kmer_size { 15 };
+    int max_diff { 250 };
+    float error_rate { 0.11 };
+    uint32_t min_cluster_size { 10 };
+    uint32_t genome_size { 5000000 };
+    bool illumina { false };
+    bool clean { false };
+    uint32_t max_covg { 300 };
+    uint32_t threads { 1 };
+    bool chain_hits { false };
+    // randomly keep the reads to get to max_covg, instead of mapping the first ones
+    bool subsample { false };
+    // turn the hits into kmer coverage as they are added, without keeping the reads
+    bool coverage_only { false };
+    uint32_t max_read_hits { 0 }; // 0 means no limit
+    uint32_t max_read_prgs { 0 }; // 0 means no limit
+    // fill the histograms of the mapping stats, which prevents add_read_hits() from
+    // stopping early
+    bool mapping_histograms { false };
+};
+
+// the reads of all files are mapped as a single stream, "-" being the standard input
+// If given, mapping_stats is filled with counts of the reads processed
+uint32_t pangraph_from_read_file(const std::vector<std::string>& filepaths,
+    std::shared_ptr<pangenome::Graph>, std::shared_ptr<Index>,
+    const std::vector<std::shared_ptr<LocalPRG>>&, const MappingOptions& options,
+    MappingStats* mapping_stats = nullptr);
+
+uint32_t pangraph_from_read_file(const std::string& filepath,
+    std::shared_ptr<pangenome::Graph>, std::shared_ptr<Index>,
+    const std::vector<std::shared_ptr<LocalPRG>>&, const MappingOptions& options,
+    MappingStats* mapping_stats = nullptr);
 
-uint32_t pangraph_from_read_file(const std::string&, std::shared_ptr<pangenome::Graph>,
-    std::shared_ptr<Index>, const std::vector<std::shared_ptr<LocalPRG>>&,
-    const uint32_t, const uint32_t, const int, const float&,
-    const uint32_t min_cluster_size = 10, const uint32_t genome_size = 5000000,
-    const bool illumina = false, const bool clean = false,
-    const uint32_t max_covg = 300, uint32_t threads = 1);
+// adds the counts of the mapping stats, and its histograms if it has them, to the
+// innermost phase of the run stats
+void add_mapping_counts(RunStats& run_stats, const MappingStats& mapping_stats);
 
 void infer_most_likely_prg_path_for_pannode(
     const std::vector<std::shared_ptr<LocalPRG>>&, PanNode*, uint32_t, float);
@@ -124,8 +244,11 @@ std::string make_absolute(std::string);
 
 using SampleIdText = std::string;
 using SampleFpath = std::string;
+using SampleFpaths = std::vector<SampleFpath>;
 
-std::vector<std::pair<SampleIdText, SampleFpath>> load_read_index(
+// each line of the read index is a sample id followed by one or more read files
+// (tab-separated), all of which are read as a single stream of reads
+std::vector<std::pair<SampleIdText, SampleFpaths>> load_read_index(
     const fs::path& read_index_fpath);
 
 std::string remove_spaces_from_string(const std::string& str);
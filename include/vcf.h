@@ -76,6 +76,9 @@ public:
     virtual ptrdiff_t get_sample_index(const std::string&);
     virtual std::vector<VCFRecord*> get_all_records_overlapping_the_given_record(
         const VCFRecord& vcf_record);
+
+    // estimated bytes used by the records of this VCF
+    virtual uint64_t estimate_memory_usage() const;
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
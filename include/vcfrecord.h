@@ -94,6 +94,9 @@ public:
     // comparison operators
     virtual bool operator==(const VCFRecord& y) const;
     virtual bool operator!=(const VCFRecord& y) const;
+
+    // bytes allocated for the fields and the sample infos of this record
+    virtual uint64_t estimate_heap_memory_usage() const;
     virtual bool operator<(const VCFRecord& y) const;
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -17,7 +17,8 @@ void setup_compare_subcommand(CLI::App& app)
 
     std::string description
         = "A tab-delimited file where each line is a sample identifier followed by "
-          "the path to the fast{a,q} of reads for that sample";
+          "the path(s) to the fast{a,q} of reads for that sample (reads of several "
+          "files are used as if they were a single file)";
     compare_subcmd->add_option("<QUERY_IDX>", opt->reads_idx_file, description)
         ->required()
         ->transform(make_absolute)
@@ -57,6 +58,21 @@ void setup_compare_subcommand(CLI::App& app)
         ->check(CLI::ExistingFile.description(""))
         ->group("Input/Output");
 
+    description = "Write a timeline of the parallel tasks and of the waits for locks "
+                  "to this file, in Chrome trace event format (to open with "
+                  "https://ui.perfetto.dev)";
+    compare_subcmd->add_option("--trace", opt->trace_file, description)
+        ->type_name("FILE")
+        ->transform(make_absolute)
+        ->group("Input/Output");
+
+    description = "Add histograms of the hits and clusters of the reads to "
+                  "pandora.stats.json. Slows mapping down, as all the hits of each "
+                  "read are then counted";
+    compare_subcmd
+        ->add_flag("--mapping-histograms", opt->mapping_histograms, description)
+        ->group("Input/Output");
+
     compare_subcmd
         ->add_option(
             "-e,--error-rate", opt->error_rate, "Estimated error rate for reads")
@@ -105,6 +121,27 @@ void setup_compare_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Filtering");
 
+    description = "Randomly subsample the reads to --max-covg (hashing read names), "
+                  "instead of mapping the first reads up to --max-covg. The number "
+                  "of bases is estimated from the first reads and the file sizes";
+    compare_subcmd->add_flag("--subsample", opt->subsample, description)
+        ->group("Filtering");
+
+    description = "Skip reads with more than this number of hits, e.g. chimeric or "
+                  "low complexity reads which would stall a thread when clustering "
+                  "their hits (0 for no limit)";
+    compare_subcmd->add_option("--max-read-hits", opt->max_read_hits, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
+    description = "Skip reads with hits on more than this number of loci (0 for no "
+                  "limit)";
+    compare_subcmd->add_option("--max-read-loci", opt->max_read_prgs, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
     description = "Add extra step to carefully genotype sites.";
     auto* gt_opt = compare_subcmd->add_flag("--genotype", opt->genotype, description)
                        ->group("Consensus/Variant Calling");
@@ -124,6 +161,10 @@ void setup_compare_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Mapping");
 
+    description = "Split clusters of hits into chains of colinear hits (read and PRG "
+                  "positions both increasing) before filtering them";
+    compare_subcmd->add_flag("--chain", opt->chain_hits, description)->group("Mapping");
+
     description = "Maximum number of kmers to average over when selecting the maximum "
                   "likelihood path";
     compare_subcmd->add_option("--kmer-avg", opt->max_num_kmers_to_avg, description)
@@ -222,12 +263,23 @@ int pandora_compare(CompareOptions& opt)
         opt.min_allele_fraction_covg_gt, opt.min_total_covg_gt, opt.min_diff_covg_gt, 0,
         false);
 
+    // the timeline of the parallel tasks, saved when the run ends, if asked
+    ScopedRunTracer run_tracer(opt.trace_file, "compare", opt.threads);
+
+    // the run time and memory of each phase, saved when the run ends
+    RunStats run_stats("compare");
+    install_memory_report_signal_handler();
+
     BOOST_LOG_TRIVIAL(info) << "Loading Index and LocalPRGs from file...";
+    run_stats.start_phase("Loading index");
     auto index = std::make_shared<Index>();
     index->load(opt.prgfile, opt.window_size, opt.kmer_size);
     std::vector<std::shared_ptr<LocalPRG>> prgs;
     read_prg_file(prgs, opt.prgfile);
     load_PRG_kmergraphs(prgs, opt.window_size, opt.kmer_size, opt.prgfile);
+    run_stats.track_memory(
+        "index", [&index]() { return index->estimate_memory_usage(); });
+    run_stats.end_phase();
 
     BOOST_LOG_TRIVIAL(info) << "Loading read index file...";
     auto samples = load_read_index(opt.reads_idx_file);
@@ -237,29 +289,70 @@ int pandora_compare(CompareOptions& opt)
     }
 
     auto pangraph = std::make_shared<pangenome::Graph>(sample_names);
+    run_stats.track_memory("pangraph_nodes",
+        [&pangraph]() { return pangraph->estimate_nodes_memory_usage(); });
+    run_stats.track_memory("kmer_graph_coverages", [&pangraph]() {
+        return pangraph->estimate_kmer_graph_coverages_memory_usage();
+    });
+
+    MappingOptions mapping_options;
+    mapping_options.window_size = opt.window_size;
+    mapping_options.kmer_size = opt.kmer_size;
+    mapping_options.max_diff = opt.max_diff;
+    mapping_options.error_rate = opt.error_rate;
+    mapping_options.min_cluster_size = opt.min_cluster_size;
+    mapping_options.genome_size = opt.genome_size;
+    mapping_options.illumina = opt.illumina;
+    mapping_options.clean = opt.clean;
+    mapping_options.max_covg = opt.max_covg;
+    mapping_options.threads = opt.threads;
+    mapping_options.chain_hits = opt.chain_hits;
+    mapping_options.subsample = opt.subsample;
+    mapping_options.max_read_hits = opt.max_read_hits;
+    mapping_options.max_read_prgs = opt.max_read_prgs;
+    mapping_options.mapping_histograms = opt.mapping_histograms;
 
     // for each sample, run pandora to get the sample pangraph
     for (uint32_t sample_id = 0; sample_id < samples.size(); ++sample_id) {
         const auto& sample = samples[sample_id];
         auto pangraph_sample = std::make_shared<pangenome::Graph>();
+        // the estimators stay tracked after the sample pangraph is destroyed at the end
+        // of the iteration (after the sample phase ends), until the next sample tracks
+        // its own, so they only hold it weakly, and estimate 0 bytes once it is gone
+        std::weak_ptr<pangenome::Graph> tracked_pangraph_sample = pangraph_sample;
+        run_stats.track_memory("sample_pangraph_reads", [tracked_pangraph_sample]() {
+            const auto pangraph_sample = tracked_pangraph_sample.lock();
+            return pangraph_sample ? pangraph_sample->estimate_reads_memory_usage() : 0;
+        });
+        run_stats.track_memory("sample_pangraph_nodes", [tracked_pangraph_sample]() {
+            const auto pangraph_sample = tracked_pangraph_sample.lock();
+            return pangraph_sample ? pangraph_sample->estimate_nodes_memory_usage() : 0;
+        });
 
         const auto& sample_name = sample.first;
-        const auto& sample_fpath = sample.second;
+        const auto& sample_fpaths = sample.second;
 
         // make output dir for this sample
         const auto sample_outdir { opt.outdir / sample_name };
         fs::create_directories(sample_outdir);
 
-        BOOST_LOG_TRIVIAL(info) << "Constructing pangenome::Graph from read file "
-                                << sample_fpath << " (this will take a while)";
-        uint32_t covg = pangraph_from_read_file(sample_fpath, pangraph_sample, index,
-            prgs, opt.window_size, opt.kmer_size, opt.max_diff, opt.error_rate,
-            opt.min_cluster_size, opt.genome_size, opt.illumina, opt.clean,
-            opt.max_covg, opt.threads);
+        ScopedPhase sample_phase(run_stats, "Sample " + sample_name);
+
+        BOOST_LOG_TRIVIAL(info) << "Constructing pangenome::Graph from read file(s) "
+                                << boost::algorithm::join(sample_fpaths, ", ")
+                                << " (this will take a while)";
+        run_stats.start_phase("Mapping reads");
+        MappingStats mapping_stats;
+        uint32_t covg = pangraph_from_read_file(sample_fpaths, pangraph_sample, index,
+            prgs, mapping_options, &mapping_stats);
+        add_mapping_counts(run_stats, mapping_stats);
+        run_stats.end_phase();
 
         const auto pangraph_gfa { sample_outdir / "pandora.pangraph.gfa" };
         BOOST_LOG_TRIVIAL(info) << "Writing pangenome::Graph to file " << pangraph_gfa;
+        run_stats.start_phase("Writing pangraph");
         write_pangraph_gfa(pangraph_gfa, pangraph_sample);
+        run_stats.end_phase();
 
         if (pangraph_sample->nodes.empty()) {
             BOOST_LOG_TRIVIAL(warning)
@@ -267,9 +360,12 @@ int pandora_compare(CompareOptions& opt)
         }
 
         BOOST_LOG_TRIVIAL(info) << "Update LocalPRGs with hits";
-        pangraph_sample->add_hits_to_kmergraphs(0);
+        run_stats.start_phase("Adding hits to kmer graphs");
+        pangraph_sample->add_hits_to_kmergraphs(0, opt.threads);
+        run_stats.end_phase();
 
         BOOST_LOG_TRIVIAL(info) << "Estimate parameters for kmer graph model";
+        run_stats.start_phase("Estimating parameters");
         auto exp_depth_covg = estimate_parameters(pangraph_sample, sample_outdir,
             opt.kmer_size, opt.error_rate, covg, opt.binomial, 0);
         genotyping_options.add_exp_depth_covg(exp_depth_covg);
@@ -277,8 +373,10 @@ int pandora_compare(CompareOptions& opt)
         if (genotyping_options.get_min_kmer_covg() == 0) {
             genotyping_options.set_min_kmer_covg(exp_depth_covg / 10);
         }
+        run_stats.end_phase();
 
         BOOST_LOG_TRIVIAL(info) << "Find max likelihood PRG paths";
+        run_stats.start_phase("Finding paths");
         auto sample_pangraph_size = pangraph_sample->nodes.size();
         Fastaq consensus_fq(true, true);
         for (auto c = pangraph_sample->nodes.begin();
@@ -305,6 +403,8 @@ int pandora_compare(CompareOptions& opt)
 
         consensus_fq.save(sample_outdir / "pandora.consensus.fq.gz");
         consensus_fq.clear();
+        run_stats.add_count("loci", sample_pangraph_size);
+        run_stats.end_phase();
         if (pangraph_sample->nodes.empty() and sample_pangraph_size > 0) {
             BOOST_LOG_TRIVIAL(warning)
                 << "All LocalPRGs found were removed for sample " << sample_name
@@ -318,6 +418,8 @@ int pandora_compare(CompareOptions& opt)
         // in compare pangraph has just coverage information and the consensus path for
         // each sample and PRG
     }
+    run_stats.untrack_memory("sample_pangraph_reads");
+    run_stats.untrack_memory("sample_pangraph_nodes");
 
     // for each pannode in graph, find a best reference
     // and output a vcf and aligned fasta of sample paths through it
@@ -325,6 +427,7 @@ int pandora_compare(CompareOptions& opt)
                             << " nodes";
 
     // parallel region!
+    run_stats.start_phase("Writing multisample VCFs");
 
     // load vcf refs
     VCFRefs vcf_refs; // no need to control this variable - read only
@@ -364,22 +467,30 @@ int pandora_compare(CompareOptions& opt)
         }
     }
 
-    // transforms to a vector to parallelize this
-    // TODO: use OMP task instead?
-    std::vector<std::pair<NodeId, std::shared_ptr<pangenome::Node>>>
-        pangraphNodesAsVector;
-    pangraphNodesAsVector.reserve(pangraph->nodes.size());
-    for (auto pan_id_to_node_mapping = pangraph->nodes.begin();
-         pan_id_to_node_mapping != pangraph->nodes.end(); ++pan_id_to_node_mapping) {
-        // todo: use emplace_back?
-        pangraphNodesAsVector.push_back(*pan_id_to_node_mapping);
+    // the nodes are indexed by id, so the parallel loop runs over the ids and skips
+    // those without a node. The VCF of a node goes in the dir of its rank among the
+    // nodes, so that each dir is filled with nb_vcfs_per_dir VCFs
+    const uint32_t node_id_bound = pangraph->nodes.id_bound();
+    std::vector<uint32_t> node_ranks(node_id_bound);
+    uint32_t nb_nodes_before = 0;
+    for (uint32_t node_id = 0; node_id < node_id_bound; ++node_id) {
+        node_ranks[node_id] = nb_nodes_before;
+        if (pangraph->nodes.contains(node_id)) {
+            ++nb_nodes_before;
+        }
     }
-
 #pragma omp parallel for num_threads(opt.threads) schedule(dynamic, 1)
-    for (uint32_t pangraph_node_index = 0;
-         pangraph_node_index < pangraphNodesAsVector.size(); ++pangraph_node_index) {
-        const auto& pangraph_node_entry = pangraphNodesAsVector[pangraph_node_index];
-        pangenome::Node& pangraph_node = *pangraph_node_entry.second;
+    for (uint32_t node_id = 0; node_id < node_id_bound; ++node_id) {
+        if (not pangraph->nodes.contains(node_id)) {
+            continue;
+        }
+        pangenome::Node& pangraph_node = *pangraph->nodes.at(node_id);
+        TraceSpan span("multisample VCF", "compare");
+        span.add_arg("prg_id", pangraph_node.prg_id);
+        span.add_arg("node_id", pangraph_node.node_id);
+        if (get_run_tracer()) {
+            span.add_arg("node", pangraph_node.get_name());
+        }
 
         const auto& prg_id = pangraph_node.prg_id;
 
@@ -394,8 +505,10 @@ int pandora_compare(CompareOptions& opt)
             = pangraph->infer_node_vcf_reference_path(pangraph_node, prg_ptr,
                 opt.window_size, vcf_refs, opt.max_num_kmers_to_avg);
 
+        const double vcf_ref_fa_wait_start = trace_timestamp();
 #pragma omp critical(vcf_ref_fa)
         {
+            trace_lock_wait("vcf_ref_fa", vcf_ref_fa_wait_start);
             vcf_ref_fa.add_entry(
                 prg_ptr->name, prg_ptr->string_along_path(vcf_reference_path), "");
         }
@@ -411,15 +524,17 @@ int pandora_compare(CompareOptions& opt)
             vcf, vcf_reference_path, prg_ptr, opt.window_size);
 
         // save the vcf to disk
-        uint32_t dir = pangraph_node_index / nb_vcfs_per_dir
+        uint32_t dir = node_ranks[node_id] / nb_vcfs_per_dir
             + 1; // get the good dir for this sample vcf
         const auto vcf_path { vcfs_dir / int_to_string(dir)
             / (prg_ptr->name + ".vcf") };
         vcf.save(vcf_path, true, false);
 
+        const double vcf_paths_wait_start = trace_timestamp();
 // add the vcf path to VCFPathsToBeConcatenated to concatenate after
 #pragma omp critical(VCFPathsToBeConcatenated)
         {
+            trace_lock_wait("VCFPathsToBeConcatenated", vcf_paths_wait_start);
             VCFPathsToBeConcatenated.push_back(vcf_path);
         }
 
@@ -433,9 +548,12 @@ int pandora_compare(CompareOptions& opt)
                 / (prg_ptr->name + "_genotyped.vcf") };
             vcf.save(vcf_genotyped_path, false, true);
 
+            const double genotyped_paths_wait_start = trace_timestamp();
 // add the genotyped vcf path to VCFGenotypedPathsToBeConcatenated to concatenate after
 #pragma omp critical(VCFGenotypedPathsToBeConcatenated)
             {
+                trace_lock_wait(
+                    "VCFGenotypedPathsToBeConcatenated", genotyped_paths_wait_start);
                 VCFGenotypedPathsToBeConcatenated.push_back(vcf_genotyped_path);
             }
         }
@@ -449,10 +567,14 @@ int pandora_compare(CompareOptions& opt)
         VCF::concatenate_VCFs(VCFGenotypedPathsToBeConcatenated,
             opt.outdir / "pandora_multisample_genotyped.vcf");
     }
+    run_stats.add_count("loci", pangraph->nodes.size());
+    run_stats.end_phase();
 
     // output a matrix/vcf which has the presence/absence of each prg in each sample
     BOOST_LOG_TRIVIAL(info) << "Output matrix";
+    run_stats.start_phase("Writing matrix");
     pangraph->save_matrix(opt.outdir / "pandora_multisample.matrix", sample_names);
+    run_stats.end_phase();
 
     if (pangraph->nodes.empty()) {
         BOOST_LOG_TRIVIAL(error)
@@ -463,6 +585,9 @@ int pandora_compare(CompareOptions& opt)
 
     index->clear();
 
+    const auto run_stats_filepath { opt.outdir / "pandora.stats.json" };
+    run_stats.save(run_stats_filepath);
+    BOOST_LOG_TRIVIAL(info) << "Run stats written to " << run_stats_filepath;
     BOOST_LOG_TRIVIAL(info) << "Done!";
     return 0;
 }
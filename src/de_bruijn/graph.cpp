@@ -4,10 +4,13 @@
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <vector>
+#include <numeric>
 
 #include <boost/log/trivial.hpp>
 
 #include "de_bruijn/graph.h"
+#include "de_bruijn/packed_node_ids.h"
 #include "noise_filtering.h"
 
 using namespace debruijn;
@@ -17,6 +20,10 @@ debruijn::Graph::Graph(uint8_t s)
     : next_id(0)
     , size(s)
 {
+    if (size > PackedNodeIds::max_size) {
+        fatal_error("Error creating de Bruijn Graph: the size of its nodes (",
+            (uint32_t)size, ") can not be more than ", PackedNodeIds::max_size);
+    }
     nodes.reserve(200000);
 };
 
@@ -33,19 +40,23 @@ OrientedNodePtr debruijn::Graph::add_node(
             size, ", received node of size ", node_ids.size());
     }
 
-    if (node_hash.find(node_ids) != node_hash.end()) {
-        nodes[node_hash[node_ids]]->read_ids.insert(read_id);
-        return make_pair(nodes[node_hash[node_ids]], true);
-    } else if (node_hash.find(rc_hashed_node_ids(node_ids)) != node_hash.end()) {
-        auto rc = rc_hashed_node_ids(node_ids);
-        nodes[node_hash[rc]]->read_ids.insert(read_id);
-        return make_pair(nodes[node_hash[rc]], false);
+    const PackedNodeIds packed_node_ids = pack_node_ids(node_ids);
+    if (node_hash.contains(packed_node_ids)) {
+        const NodePtr& n = nodes[node_hash.at(packed_node_ids)];
+        n->read_ids.insert(read_id);
+        return make_pair(n, true);
+    }
+    const PackedNodeIds rc = rc_packed_node_ids(packed_node_ids, size);
+    if (node_hash.contains(rc)) {
+        const NodePtr& n = nodes[node_hash.at(rc)];
+        n->read_ids.insert(read_id);
+        return make_pair(n, false);
     }
 
     NodePtr n;
     n = std::make_shared<Node>(next_id, node_ids, read_id);
     nodes[next_id] = n;
-    node_hash[node_ids] = next_id;
+    node_hash.emplace(packed_node_ids, next_id);
 
     if (next_id % 1000 == 0) {
         BOOST_LOG_TRIVIAL(debug) << "added node " << next_id;
@@ -62,17 +73,22 @@ OrientedNodePtr debruijn::Graph::add_node(
 // in in the read allows the overlap
 bool edge_is_valid(OrientedNodePtr from, OrientedNodePtr to)
 {
-    std::deque<uint_least32_t> hashed_node_ids_from = from.first->hashed_node_ids;
-    std::deque<uint_least32_t> hashed_node_ids_to = to.first->hashed_node_ids;
-    if (!from.second) {
-        hashed_node_ids_from = rc_hashed_node_ids(hashed_node_ids_from);
+    const auto& hashed_node_ids_from = from.first->hashed_node_ids;
+    const auto& hashed_node_ids_to = to.first->hashed_node_ids;
+    if (hashed_node_ids_from.size() < hashed_node_ids_to.size()) {
+        fatal_error("Error on checking for overlaps in noise filtering: first node "
+                    "must be larger or have the same size as the second");
     }
 
-    if (!to.second) {
-        hashed_node_ids_to = rc_hashed_node_ids(hashed_node_ids_to);
+    // as overlap_forwards() on the ids in the orientations they were found in
+    const uint32_t shift = hashed_node_ids_from.size() - hashed_node_ids_to.size() + 1;
+    for (uint32_t j = 0; j + shift < hashed_node_ids_from.size(); ++j) {
+        if (oriented_hashed_node_id(hashed_node_ids_from, j + shift, from.second)
+            != oriented_hashed_node_id(hashed_node_ids_to, j, to.second)) {
+            return false;
+        }
     }
-
-    return overlap_forwards(hashed_node_ids_from, hashed_node_ids_to);
+    return true;
 }
 
 // Add directed edge between from and to
@@ -105,6 +121,204 @@ void debruijn::Graph::add_edge(OrientedNodePtr from, OrientedNodePtr to)
     }
 }
 
+// The windows of size consecutive hashed pangraph node ids along sequences, i.e. the
+// dbg nodes seen along them, numbered in the order of the sequences and then of their
+// positions. A window and its reverse complement are the same dbg node, so windows are
+// identified by their packed ids in canonical orientation (the smaller of the two)
+struct SequenceWindows {
+    // the first window of each sequence, followed by the number of windows
+    std::vector<size_t> first_window_of_sequence;
+    std::vector<uint32_t> sequence_of_window;
+    std::vector<PackedNodeIds> canonical_ids_of_window;
+    // whether the window is canonical as read along its sequence (not a vector<bool>,
+    // as the windows are set in parallel)
+    std::vector<uint8_t> is_canonical;
+
+    SequenceWindows(const std::vector<uint_least32_t>& hashed_node_ids,
+        const std::vector<size_t>& sequence_starts, const uint32_t size,
+        const uint32_t threads);
+
+    size_t number_of_windows() const { return sequence_of_window.size(); }
+};
+
+SequenceWindows::SequenceWindows(const std::vector<uint_least32_t>& hashed_node_ids,
+    const std::vector<size_t>& sequence_starts, const uint32_t size,
+    const uint32_t threads)
+{
+    const uint32_t number_of_sequences = sequence_starts.size() - 1;
+    first_window_of_sequence.reserve(sequence_starts.size());
+    size_t number_of_windows = 0;
+    for (uint32_t sequence = 0; sequence < number_of_sequences; ++sequence) {
+        first_window_of_sequence.push_back(number_of_windows);
+        const size_t length = sequence_starts[sequence + 1] - sequence_starts[sequence];
+        if (length >= size) {
+            number_of_windows += length - size + 1;
+        }
+    }
+    first_window_of_sequence.push_back(number_of_windows);
+    sequence_of_window.resize(number_of_windows);
+    canonical_ids_of_window.resize(number_of_windows);
+    is_canonical.resize(number_of_windows);
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (uint32_t sequence = 0; sequence < number_of_sequences; ++sequence) {
+        const uint_least32_t* window_start
+            = hashed_node_ids.data() + sequence_starts[sequence];
+        for (size_t window = first_window_of_sequence[sequence];
+             window < first_window_of_sequence[sequence + 1];
+             ++window, ++window_start) {
+            sequence_of_window[window] = sequence;
+            // a palindromic window is canonical in both orientations
+            const PackedNodeIds ids = pack_node_ids(window_start, size);
+            const PackedNodeIds rc = rc_packed_node_ids(ids, size);
+            is_canonical[window] = !(rc < ids);
+            canonical_ids_of_window[window] = is_canonical[window] ? ids : rc;
+        }
+    }
+}
+
+void debruijn::Graph::build(const std::vector<uint32_t>& read_ids,
+    const std::vector<uint_least32_t>& hashed_node_ids,
+    const std::vector<size_t>& sequence_starts, const uint32_t threads)
+{
+    if (!nodes.empty()) {
+        fatal_error("Error building de Bruijn Graph: the graph already has ",
+            nodes.size(), " nodes");
+    }
+    if (sequence_starts.size() != read_ids.size() + 1
+        or sequence_starts.back() != hashed_node_ids.size()) {
+        fatal_error("Error building de Bruijn Graph: got ", read_ids.size(),
+            " read ids for ", sequence_starts.size(), " sequence starts");
+    }
+
+    const uint32_t number_of_shards = std::max(threads, (uint32_t)1);
+    const SequenceWindows windows(
+        hashed_node_ids, sequence_starts, size, number_of_shards);
+    const size_t number_of_windows = windows.number_of_windows();
+    // the shard is taken from the high bits of the hash, as the hash tables of the
+    // shards probe from its low bits, which would otherwise be the same for all the
+    // keys of a shard when the number of shards is a power of two
+    std::vector<uint32_t> shard_of_window(number_of_windows);
+#pragma omp parallel for num_threads(number_of_shards) schedule(static)
+    for (size_t window = 0; window < number_of_windows; ++window) {
+        const uint64_t hash
+            = PackedNodeIdsHash()(windows.canonical_ids_of_window[window]);
+        shard_of_window[window] = (hash >> 32) % number_of_shards;
+    }
+
+    // bucket the windows by shard with a counting sort, which keeps the windows of a
+    // shard in increasing order, so that each thread only visits the windows of its
+    // shard, windows_of_shard[shard_starts[shard]..shard_starts[shard + 1]]
+    std::vector<size_t> shard_starts(number_of_shards + 1, 0);
+    for (const auto& shard : shard_of_window) {
+        ++shard_starts[shard + 1];
+    }
+    std::partial_sum(shard_starts.begin(), shard_starts.end(), shard_starts.begin());
+    std::vector<size_t> windows_of_shard(number_of_windows);
+    {
+        std::vector<size_t> next_in_shard(shard_starts.begin(), shard_starts.end() - 1);
+        for (size_t window = 0; window < number_of_windows; ++window) {
+            windows_of_shard[next_in_shard[shard_of_window[window]]++] = window;
+        }
+    }
+
+    // find the node of each window in the hash table of its shard, filled by one thread
+    // which numbers the nodes of the shard in the order their first window is seen
+    std::vector<std::vector<size_t>> first_window_of_shard_node(number_of_shards);
+    std::vector<uint32_t> shard_node_of_window(number_of_windows);
+#pragma omp parallel for num_threads(number_of_shards) schedule(static, 1)
+    for (uint32_t shard = 0; shard < number_of_shards; ++shard) {
+        PackedNodeIdsMap shard_nodes;
+        auto& first_windows = first_window_of_shard_node[shard];
+        for (size_t i = shard_starts[shard]; i < shard_starts[shard + 1]; ++i) {
+            const size_t window = windows_of_shard[i];
+            const auto inserted = shard_nodes.emplace(
+                windows.canonical_ids_of_window[window], first_windows.size());
+            if (inserted.second) {
+                first_windows.push_back(window);
+            }
+            shard_node_of_window[window] = inserted.first;
+        }
+    }
+
+    // create the nodes in the order their first window is seen, with the ids and in the
+    // order of insertion that add_node() would give them, as the order of iteration of
+    // nodes decides where the unitigs start
+    std::vector<std::pair<size_t, uint32_t>> first_windows_and_shards;
+    for (uint32_t shard = 0; shard < number_of_shards; ++shard) {
+        for (const auto& window : first_window_of_shard_node[shard]) {
+            first_windows_and_shards.emplace_back(window, shard);
+        }
+    }
+    std::sort(first_windows_and_shards.begin(), first_windows_and_shards.end());
+
+    std::vector<std::vector<NodePtr>> nodes_of_shard(number_of_shards);
+    for (uint32_t shard = 0; shard < number_of_shards; ++shard) {
+        nodes_of_shard[shard].reserve(first_window_of_shard_node[shard].size());
+    }
+    node_hash.reserve(node_hash.size() + first_windows_and_shards.size());
+    for (const auto& first_window_and_shard : first_windows_and_shards) {
+        const size_t window = first_window_and_shard.first;
+        const uint32_t sequence = windows.sequence_of_window[window];
+        const auto window_start = hashed_node_ids.begin() + sequence_starts[sequence]
+            + (window - windows.first_window_of_sequence[sequence]);
+        NodePtr n = std::make_shared<Node>(next_id,
+            std::deque<uint_least32_t>(window_start, window_start + size),
+            read_ids[sequence]);
+        nodes[next_id] = n;
+        node_hash.emplace(pack_node_ids(&*window_start, size), next_id);
+        nodes_of_shard[first_window_and_shard.second].push_back(n);
+        next_id++;
+    }
+    BOOST_LOG_TRIVIAL(debug) << "added " << first_windows_and_shards.size()
+                             << " nodes from " << number_of_windows << " windows";
+
+    // label the nodes with the reads of their other windows and add the edges between
+    // consecutive windows. Each thread updates the nodes of a shard, visiting the
+    // windows in order, so that the read ids and the edges are inserted in the same
+    // order as with add_node() and add_edge()
+#pragma omp parallel for num_threads(number_of_shards) schedule(static, 1)
+    for (uint32_t shard = 0; shard < number_of_shards; ++shard) {
+        const auto node_of_window = [&](const size_t window) -> const NodePtr& {
+            return nodes_of_shard[shard_of_window[window]]
+                                 [shard_node_of_window[window]];
+        };
+
+        for (size_t i = shard_starts[shard]; i < shard_starts[shard + 1]; ++i) {
+            const size_t window = windows_of_shard[i];
+            const NodePtr& n = node_of_window(window);
+            const size_t first_window
+                = first_window_of_shard_node[shard][shard_node_of_window[window]];
+            // whether the window reads as the node, as its first window does
+            const bool forward
+                = windows.is_canonical[window] == windows.is_canonical[first_window];
+            const uint32_t sequence = windows.sequence_of_window[window];
+
+            if (window != first_window) {
+                n->read_ids.insert(read_ids[sequence]);
+            }
+
+            // the edge from the previous window, then the edge to the next one
+            if (window > windows.first_window_of_sequence[sequence]) {
+                const uint32_t previous_node_id = node_of_window(window - 1)->id;
+                if (forward) {
+                    n->in_nodes.insert(previous_node_id);
+                } else {
+                    n->out_nodes.insert(previous_node_id);
+                }
+            }
+            if (window + 1 < windows.first_window_of_sequence[sequence + 1]) {
+                const uint32_t next_node_id = node_of_window(window + 1)->id;
+                if (forward) {
+                    n->out_nodes.insert(next_node_id);
+                } else {
+                    n->in_nodes.insert(next_node_id);
+                }
+            }
+        }
+    }
+}
+
 // Remove all mentions of de bruijn node with id given from graph
 void debruijn::Graph::remove_node(const uint32_t dbg_node_id)
 {
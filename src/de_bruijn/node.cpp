@@ -30,9 +30,9 @@ bool debruijn::Node::operator==(const Node& y) const
     if (match)
         return true;
 
-    auto rc = rc_hashed_node_ids(hashed_node_ids);
     for (uint32_t i = 0; i < hashed_node_ids.size(); ++i) {
-        match = rc[i] == y.hashed_node_ids[i];
+        match = oriented_hashed_node_id(hashed_node_ids, i, false)
+            == y.hashed_node_ids[i];
         if (!match)
             break;
     }
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "de_bruijn/packed_node_ids.h"
+#include "fatal_error.h"
+#include "inthash.h"
+
+using namespace debruijn;
+
+constexpr uint32_t PackedNodeIds::max_size;
+constexpr uint32_t PackedNodeIdsMap::free_slot_value;
+
+PackedNodeIds debruijn::pack_node_ids(const std::deque<uint_least32_t>& hashed_node_ids)
+{
+    if (hashed_node_ids.size() > PackedNodeIds::max_size) {
+        fatal_error("Error packing de Bruijn Graph node: at most ",
+            PackedNodeIds::max_size, " node ids can be packed, got ",
+            hashed_node_ids.size());
+    }
+    PackedNodeIds ids;
+    for (uint32_t i = 0; i < hashed_node_ids.size(); ++i) {
+        ids.set(i, hashed_node_ids[i]);
+    }
+    return ids;
+}
+
+PackedNodeIds debruijn::pack_node_ids(
+    const uint_least32_t* hashed_node_ids, const uint32_t size)
+{
+    if (size > PackedNodeIds::max_size) {
+        fatal_error("Error packing de Bruijn Graph node: at most ",
+            PackedNodeIds::max_size, " node ids can be packed, got ", size);
+    }
+    PackedNodeIds ids;
+    for (uint32_t i = 0; i < size; ++i) {
+        ids.set(i, hashed_node_ids[i]);
+    }
+    return ids;
+}
+
+PackedNodeIds debruijn::rc_packed_node_ids(
+    const PackedNodeIds& ids, const uint32_t size)
+{
+    if (size == 0) {
+        return ids;
+    }
+
+    // reverse the order of the four 32 bits slots
+    PackedNodeIds rc(
+        (ids.low << 32) | (ids.low >> 32), (ids.high << 32) | (ids.high >> 32));
+
+    // the ids are now in the last size slots, shift them back to the first ones
+    const uint32_t shift = 32 * (PackedNodeIds::max_size - size);
+    if (shift >= 64) {
+        rc.high = rc.low << (shift - 64);
+        rc.low = 0;
+    } else if (shift > 0) {
+        rc.high = (rc.high << shift) | (rc.low >> (64 - shift));
+        rc.low <<= shift;
+    }
+
+    // and flip the orientation of each id, see rc_num()
+    const uint64_t orientation_bits = ((uint64_t)1 << 32) | 1;
+    rc.high ^= size >= 2 ? orientation_bits : (uint64_t)1 << 32;
+    if (size > 2) {
+        rc.low ^= size == 4 ? orientation_bits : (uint64_t)1 << 32;
+    }
+    return rc;
+}
+
+size_t PackedNodeIdsHash::operator()(const PackedNodeIds& ids) const
+{
+    const uint64_t mask = std::numeric_limits<uint64_t>::max();
+    return hash64(ids.high ^ hash64(ids.low, mask), mask);
+}
+
+size_t PackedNodeIdsMap::find_slot(const PackedNodeIds& ids) const
+{
+    const size_t mask = slots.size() - 1;
+    size_t slot = PackedNodeIdsHash()(ids) & mask;
+    while (slots[slot].value != free_slot_value and slots[slot].ids != ids) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void PackedNodeIdsMap::rehash(const size_t number_of_slots)
+{
+    std::vector<Slot> previous_slots(
+        number_of_slots, Slot { PackedNodeIds(), free_slot_value });
+    previous_slots.swap(slots);
+    for (const auto& previous_slot : previous_slots) {
+        if (previous_slot.value != free_slot_value) {
+            slots[find_slot(previous_slot.ids)] = previous_slot;
+        }
+    }
+}
+
+void PackedNodeIdsMap::clear()
+{
+    std::fill(slots.begin(), slots.end(), Slot { PackedNodeIds(), free_slot_value });
+    number_of_entries = 0;
+}
+
+void PackedNodeIdsMap::reserve(const size_t entries)
+{
+    size_t number_of_slots = std::max(slots.size(), (size_t)16);
+    while (number_of_slots < 2 * entries) {
+        number_of_slots *= 2;
+    }
+    if (number_of_slots != slots.size()) {
+        rehash(number_of_slots);
+    }
+}
+
+bool PackedNodeIdsMap::contains(const PackedNodeIds& ids) const
+{
+    return !slots.empty() and slots[find_slot(ids)].value != free_slot_value;
+}
+
+uint32_t PackedNodeIdsMap::at(const PackedNodeIds& ids) const
+{
+    if (not contains(ids)) {
+        throw std::out_of_range("PackedNodeIdsMap::at: node ids not in the table");
+    }
+    return slots[find_slot(ids)].value;
+}
+
+std::pair<uint32_t, bool> PackedNodeIdsMap::emplace(
+    const PackedNodeIds& ids, const uint32_t value)
+{
+    if (value == free_slot_value) {
+        fatal_error("Error inserting in the de Bruijn Graph node hash: value ", value,
+            " is reserved for free slots");
+    }
+    reserve(number_of_entries + 1);
+
+    Slot& slot = slots[find_slot(ids)];
+    if (slot.value != free_slot_value) {
+        return std::make_pair(slot.value, false);
+    }
+    slot = Slot { ids, value };
+    ++number_of_entries;
+    return std::make_pair(value, true);
+}
+
+uint64_t PackedNodeIdsMap::estimate_heap_memory_usage() const
+{
+    return slots.capacity() * sizeof(Slot);
+}
@@ -1,5 +1,7 @@
 #include "denovo_discovery/candidate_region.h"
 #include "utils.h"
+#include <chrono>
+#include <boost/algorithm/string/join.hpp>
 #include <seqan/align.h>
 
 std::string SimpleDenovoVariantRecord::to_string() const
@@ -205,15 +207,17 @@ std::vector<Interval> Discover::identify_low_coverage_intervals(
 }
 
 void CandidateRegion::add_pileup_entry(
-    const std::string& read, const ReadCoordinate& read_coordinate)
+    const boost::string_view read, const ReadCoordinate& read_coordinate)
 {
     const bool read_coord_start_is_past_read_end { read_coordinate.start
         >= read.length() };
     if (not read_coord_start_is_past_read_end) {
         const auto end_pos_of_region_in_read { std::min(
             read_coordinate.end, (uint32_t)read.length()) };
-        std::string sequence_in_read_overlapping_region { read.substr(
-            read_coordinate.start, end_pos_of_region_in_read - read_coordinate.start) };
+        std::string sequence_in_read_overlapping_region { read
+                .substr(read_coordinate.start,
+                    end_pos_of_region_in_read - read_coordinate.start)
+                .to_string() };
 
         if (!read_coordinate.is_forward) {
             sequence_in_read_overlapping_region
@@ -329,54 +333,62 @@ PileupConstructionMap Discover::pileup_construction_map(
 void Discover::load_candidate_region_pileups(const fs::path& reads_filepath,
     const CandidateRegions& candidate_regions,
     const PileupConstructionMap& pileup_construction_map, uint32_t threads)
+{
+    load_candidate_region_pileups(std::vector<std::string> { reads_filepath.string() },
+        candidate_regions, pileup_construction_map, threads);
+}
+
+void Discover::load_candidate_region_pileups(
+    const std::vector<std::string>& reads_filepaths,
+    const CandidateRegions& candidate_regions,
+    const PileupConstructionMap& pileup_construction_map, uint32_t threads)
 {
     if (candidate_regions.empty() or pileup_construction_map.empty())
         return;
 
-    const uint32_t nb_reads_to_map_in_a_batch = 1000; // nb of reads to map in a batch
-
     // shared variables - controlled by critical(ReadFileMutex)
-    FastaqHandler fh(reads_filepath.string());
+    FastaqHandler fh(reads_filepaths);
     uint32_t id { 0 };
+    std::string read_file_error; // reported after the parallel region
 
 // parallel region
 // TODO: this is duplicated code with pangraph_from_read_file(), refactor
 #pragma omp parallel num_threads(threads)
     {
         // will hold the reads batch
-        std::vector<std::pair<uint32_t, std::string>> sequencesBuffer(
-            nb_reads_to_map_in_a_batch, make_pair(0, ""));
+        ReadBatch batch;
+        ReadBatchSizer batch_sizer;
         while (true) {
             // read the next batch of reads
-            uint32_t nbOfReads = 0;
+            batch.clear();
 
 // read the reads in batch
 #pragma omp critical(ReadFileMutex)
             {
                 // TODO: we need to read only until the max read id
-                for (auto& id_and_sequence : sequencesBuffer) {
+                while (read_file_error.empty()
+                    and batch.get_number_of_bases() < batch_sizer.get_nb_bases()) {
                     try {
-                        fh.get_next();
+                        fh.get_next(batch, id);
                     } catch (std::out_of_range& err) {
                         break;
+                    } catch (std::runtime_error& err) {
+                        read_file_error = err.what();
+                        break;
                     }
-                    id_and_sequence = make_pair(id, fh.read);
-                    ++nbOfReads;
                     ++id;
                 }
             }
+            const uint32_t nbOfReads = batch.size();
 
             if (nbOfReads == 0)
                 break; // we reached the end of the file, nothing else to map
 
             // process nbOfReads reads
+            const auto batch_start_time = std::chrono::steady_clock::now();
             for (uint32_t i = 0; i < nbOfReads; i++) {
-                uint32_t id;
-                std::string sequence;
-                std::tie(id, sequence) = sequencesBuffer[i];
-
                 auto pileup_construction_map_iterator
-                    = pileup_construction_map.find(id);
+                    = pileup_construction_map.find(batch.get_id(i));
                 const bool is_read_required_for_pileup
                     = pileup_construction_map_iterator != pileup_construction_map.end();
 
@@ -384,6 +396,7 @@ void Discover::load_candidate_region_pileups(const fs::path& reads_filepath,
                     continue;
 
                 // create all pileups for this read
+                const auto sequence = batch.get_sequence(i);
                 for (const auto& pair : pileup_construction_map_iterator->second) {
                     CandidateRegion* candidate_region;
                     const ReadCoordinate* read_coordinate;
@@ -392,10 +405,17 @@ void Discover::load_candidate_region_pileups(const fs::path& reads_filepath,
                     candidate_region->add_pileup_entry(sequence, *read_coordinate);
                 }
             }
+
+            const std::chrono::duration<double> batch_time
+                = std::chrono::steady_clock::now() - batch_start_time;
+            batch_sizer.update(batch.get_number_of_bases(), batch_time.count());
         }
     }
+    if (not read_file_error.empty()) {
+        fatal_error("Error reading the read files: ", read_file_error);
+    }
     BOOST_LOG_TRIVIAL(trace) << "Loaded all candidate regions pileups from "
-                             << reads_filepath.string();
+                             << boost::algorithm::join(reads_filepaths, ", ");
 }
 
 Discover::Discover(uint32_t min_required_covg, uint32_t min_candidate_len,
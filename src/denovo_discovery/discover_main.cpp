@@ -20,7 +20,8 @@ void setup_discover_subcommand(CLI::App& app)
 
     std::string description
         = "A tab-delimited file where each line is a sample identifier followed by "
-          "the path to the fast{a,q} of reads for that sample";
+          "the path(s) to the fast{a,q} of reads for that sample (reads of several "
+          "files are used as if they were a single file)";
     discover_subcmd->add_option("<QUERY_IDX>", opt->reads_idx_file, description)
         ->required()
         ->transform(make_absolute)
@@ -52,6 +53,21 @@ void setup_discover_subcommand(CLI::App& app)
         ->capture_default_str()
         ->group("Input/Output");
 
+    description = "Write a timeline of the parallel tasks, of the waits for locks and "
+                  "of the forked workers to this file, in Chrome trace event format "
+                  "(to open with https://ui.perfetto.dev)";
+    discover_subcmd->add_option("--trace", opt->trace_file, description)
+        ->type_name("FILE")
+        ->transform(make_absolute)
+        ->group("Input/Output");
+
+    description = "Add histograms of the hits and clusters of the reads to "
+                  "pandora.stats.json. Slows mapping down, as all the hits of each "
+                  "read are then counted";
+    discover_subcmd
+        ->add_flag("--mapping-histograms", opt->mapping_histograms, description)
+        ->group("Input/Output");
+
     discover_subcmd
         ->add_option(
             "-e,--error-rate", opt->error_rate, "Estimated error rate for reads")
@@ -112,6 +128,27 @@ void setup_discover_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Filtering");
 
+    description = "Randomly subsample the reads to --max-covg (hashing read names), "
+                  "instead of mapping the first reads up to --max-covg. The number "
+                  "of bases is estimated from the first reads and the file sizes";
+    discover_subcmd->add_flag("--subsample", opt->subsample, description)
+        ->group("Filtering");
+
+    description = "Skip reads with more than this number of hits, e.g. chimeric or "
+                  "low complexity reads which would stall a thread when clustering "
+                  "their hits (0 for no limit)";
+    discover_subcmd->add_option("--max-read-hits", opt->max_read_hits, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
+    description = "Skip reads with hits on more than this number of loci (0 for no "
+                  "limit)";
+    discover_subcmd->add_option("--max-read-loci", opt->max_read_prgs, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
     discover_subcmd
         ->add_option("--discover-k", opt->denovo_kmer_size,
             "K-mer size to use when discovering novel variants")
@@ -172,6 +209,11 @@ void setup_discover_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Mapping");
 
+    description = "Split clusters of hits into chains of colinear hits (read and PRG "
+                  "positions both increasing) before filtering them";
+    discover_subcmd->add_flag("--chain", opt->chain_hits, description)
+        ->group("Mapping");
+
     description = "Maximum number of kmers to average over when selecting the maximum "
                   "likelihood path";
     discover_subcmd->add_option("--kmer-avg", opt->max_num_kmers_to_avg, description)
@@ -248,9 +290,12 @@ void find_denovo_variants_multiprocess(CandidateRegions& candidate_regions,
     }
 
     // forking due to GATB
+    // when the run is traced, each child is a span from its fork until it is waited for
+    std::map<int, std::pair<size_t, double>> child_pid_to_id_and_start;
     size_t child_id;
     bool on_child;
     for (child_id = 0; child_id < threads; ++child_id) {
+        const double fork_time = trace_timestamp();
         int child_process_id = fork();
         bool error_creating_child_process = child_process_id == -1;
         on_child = child_process_id == 0;
@@ -262,6 +307,7 @@ void find_denovo_variants_multiprocess(CandidateRegions& candidate_regions,
         } else {
             BOOST_LOG_TRIVIAL(info) << "Child process id " << child_process_id
                                     << " (child #" << child_id << ") created...";
+            child_pid_to_id_and_start[child_process_id] = { child_id, fork_time };
         }
     }
 
@@ -280,6 +326,15 @@ void find_denovo_variants_multiprocess(CandidateRegions& candidate_regions,
                 BOOST_LOG_TRIVIAL(info)
                     << "Child process " << child_pid << " finished!";
             }
+
+            Tracer* tracer = get_run_tracer();
+            if (tracer) {
+                const auto& id_and_start = child_pid_to_id_and_start[child_pid];
+                const std::string span_name = "find de novo variants (child #"
+                    + std::to_string(id_and_start.first) + ")";
+                tracer->add_process_span(span_name, "discover", child_pid,
+                    id_and_start.second, tracer->now(), { { "sample", sample_name } });
+            }
         }
     }
 
@@ -312,12 +367,22 @@ void find_denovo_variants_multiprocess(CandidateRegions& candidate_regions,
                             << denovo_output_file.string();
 }
 
-void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
+void pandora_discover_core(const std::pair<SampleIdText, SampleFpaths>& sample,
     const std::shared_ptr<Index>& index,
-    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const DiscoverOptions& opt)
+    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const DiscoverOptions& opt,
+    RunStats& run_stats)
 {
     const auto& sample_name = sample.first;
-    const auto& sample_fpath = sample.second;
+    const auto& sample_fpaths = sample.second;
+
+    // reads are read more than once (mapping, then pileups), so they can't be streamed
+    const bool reads_from_stdin = std::find(sample_fpaths.begin(), sample_fpaths.end(),
+                                      FastaqHandler::stdin_filepath)
+        != sample_fpaths.end();
+    if (reads_from_stdin) {
+        fatal_error("[Sample ", sample_name, "] discover can not read reads from ",
+            "standard input, as they are read more than once");
+    }
 
     // make output dir for this sample
     const auto sample_outdir { opt.outdir / sample_name };
@@ -329,19 +394,56 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
         fs::create_directories(kmer_graph_dir);
     }
 
+    ScopedPhase sample_phase(run_stats, "Sample " + sample_name);
+
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
-                            << "Constructing pangenome::Graph from read file "
-                            << sample_fpath << " (this will take a while)";
+                            << "Constructing pangenome::Graph from read file(s) "
+                            << boost::algorithm::join(sample_fpaths, ", ")
+                            << " (this will take a while)";
+    run_stats.start_phase("Mapping reads");
     auto pangraph = std::make_shared<pangenome::Graph>();
-    uint32_t covg
-        = pangraph_from_read_file(sample_fpath, pangraph, index, prgs, opt.window_size,
-            opt.kmer_size, opt.max_diff, opt.error_rate, opt.min_cluster_size,
-            opt.genome_size, opt.illumina, opt.clean, opt.max_covg, opt.threads);
+    // the pangraph is destroyed before the end of the sample phase
+    std::weak_ptr<pangenome::Graph> tracked_pangraph = pangraph;
+    run_stats.track_memory("pangraph_reads", [tracked_pangraph]() {
+        const auto pangraph = tracked_pangraph.lock();
+        return pangraph ? pangraph->estimate_reads_memory_usage() : 0;
+    });
+    run_stats.track_memory("pangraph_nodes", [tracked_pangraph]() {
+        const auto pangraph = tracked_pangraph.lock();
+        return pangraph ? pangraph->estimate_nodes_memory_usage() : 0;
+    });
+    run_stats.track_memory("kmer_graph_coverages", [tracked_pangraph]() {
+        const auto pangraph = tracked_pangraph.lock();
+        return pangraph ? pangraph->estimate_kmer_graph_coverages_memory_usage() : 0;
+    });
+    MappingOptions mapping_options;
+    mapping_options.window_size = opt.window_size;
+    mapping_options.kmer_size = opt.kmer_size;
+    mapping_options.max_diff = opt.max_diff;
+    mapping_options.error_rate = opt.error_rate;
+    mapping_options.min_cluster_size = opt.min_cluster_size;
+    mapping_options.genome_size = opt.genome_size;
+    mapping_options.illumina = opt.illumina;
+    mapping_options.clean = opt.clean;
+    mapping_options.max_covg = opt.max_covg;
+    mapping_options.threads = opt.threads;
+    mapping_options.chain_hits = opt.chain_hits;
+    mapping_options.subsample = opt.subsample;
+    mapping_options.max_read_hits = opt.max_read_hits;
+    mapping_options.max_read_prgs = opt.max_read_prgs;
+    mapping_options.mapping_histograms = opt.mapping_histograms;
+    MappingStats mapping_stats;
+    uint32_t covg = pangraph_from_read_file(
+        sample_fpaths, pangraph, index, prgs, mapping_options, &mapping_stats);
+    add_mapping_counts(run_stats, mapping_stats);
+    run_stats.end_phase();
 
     const auto pangraph_gfa { sample_outdir / "pandora.pangraph.gfa" };
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
                             << "Writing pangenome::Graph to file " << pangraph_gfa;
+    run_stats.start_phase("Writing pangraph");
     write_pangraph_gfa(pangraph_gfa, pangraph);
+    run_stats.end_phase();
 
     if (pangraph->nodes.empty()) {
         BOOST_LOG_TRIVIAL(warning)
@@ -351,10 +453,13 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
 
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
                             << "Updating local PRGs with hits...";
-    pangraph->add_hits_to_kmergraphs();
+    run_stats.start_phase("Adding hits to kmer graphs");
+    pangraph->add_hits_to_kmergraphs(0, opt.threads);
+    run_stats.end_phase();
 
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
                             << "Find PRG paths and write to files...";
+    run_stats.start_phase("Finding paths and candidate regions");
 
     // paralell region!
     // shared variable - synced with critical(consensus_fq)
@@ -373,27 +478,32 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
     Discover discover { opt.min_candidate_covg, opt.min_candidate_len,
         opt.max_candidate_len, candidate_padding, opt.merge_dist };
 
-    // transforms the pangraph->nodes from map to vector so that we can run it in
-    // parallel
-    // TODO: use OMP task instead?
-    std::vector<pangenome::NodePtr> pangraphNodesAsVector;
-    pangraphNodesAsVector.reserve(pangraph->nodes.size());
-    for (auto pan_id_to_node_mapping = pangraph->nodes.begin();
-         pan_id_to_node_mapping != pangraph->nodes.end(); ++pan_id_to_node_mapping) {
-        pangraphNodesAsVector.push_back(pan_id_to_node_mapping->second);
-    }
+    // the nodes are indexed by id, so the parallel loop runs over the ids and skips
+    // those without a node. No node is added or removed within the loop
+    const uint32_t number_of_loci = pangraph->nodes.size();
+    const uint32_t node_id_bound = pangraph->nodes.id_bound();
 
 #pragma omp parallel for num_threads(opt.threads) schedule(dynamic, 10)
-    for (uint32_t i = 0; i < pangraphNodesAsVector.size(); ++i) {
+    for (uint32_t node_id = 0; node_id < node_id_bound; ++node_id) {
+        if (not pangraph->nodes.contains(node_id)) {
+            continue;
+        }
+
         // add some progress
-        if (i && i % 100 == 0) {
-            BOOST_LOG_TRIVIAL(info)
-                << "[Sample " << sample_name << "] "
-                << ((double)i) / pangraphNodesAsVector.size() * 100 << "% done";
+        if (node_id && node_id % 100 == 0) {
+            BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
+                                    << ((double)node_id) / node_id_bound * 100
+                                    << "% done";
         }
 
         // get the node
-        const auto& pangraph_node = pangraphNodesAsVector[i];
+        const auto& pangraph_node = pangraph->nodes.at(node_id);
+        TraceSpan span("consensus and candidate regions", "discover");
+        span.add_arg("prg_id", pangraph_node->prg_id);
+        span.add_arg("node_id", pangraph_node->node_id);
+        if (get_run_tracer()) {
+            span.add_arg("node", pangraph_node->get_name());
+        }
 
         // add consensus path to fastaq
         std::vector<KmerNodePtr> kmp;
@@ -404,8 +514,10 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
 
         if (kmp.empty()) {
             // mark the node as to remove
+            const double wait_start = trace_timestamp();
 #pragma omp critical(nodes_to_remove)
             {
+                trace_lock_wait("nodes_to_remove", wait_start);
                 nodes_to_remove.push_back(pangraph_node);
             }
             continue;
@@ -427,23 +539,31 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
             discover.find_candidate_regions_for_pan_node(pangraph_node_components)
         };
 
+        const double wait_start = trace_timestamp();
 #pragma omp critical(candidate_regions)
         {
+            trace_lock_wait("candidate_regions", wait_start);
             candidate_regions.insert(candidate_regions_for_pan_node.begin(),
                 candidate_regions_for_pan_node.end());
         }
     }
 
+    run_stats.add_count("loci", number_of_loci);
+    run_stats.end_phase();
+
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
                             << "Building read pileups for " << candidate_regions.size()
                             << " candidate de novo regions...";
+    run_stats.start_phase("Building pileups");
     // the pileup_construction_map function is intentionally left
     // single threaded since it would require too much synchronization
     const auto pileup_construction_map
         = discover.pileup_construction_map(candidate_regions);
 
     discover.load_candidate_region_pileups(
-        sample_fpath, candidate_regions, pileup_construction_map, opt.threads);
+        sample_fpaths, candidate_regions, pileup_construction_map, opt.threads);
+    run_stats.add_count("candidate_regions", candidate_regions.size());
+    run_stats.end_phase();
 
     // remove the nodes marked as to be removed
     for (const auto& node_to_remove : nodes_to_remove) {
@@ -468,11 +588,16 @@ void pandora_discover_core(const std::pair<SampleIdText, SampleFpath>& sample,
     BOOST_LOG_TRIVIAL(info)
         << "[Sample " << sample_name << "] "
         << "Generating de novo variants as paths through their local graph...";
+    run_stats.start_phase("Finding de novo variants");
     find_denovo_variants_multiprocess(
         candidate_regions, sample_name, sample_outdir, denovo, opt.threads);
+    run_stats.add_count("candidate_regions", candidate_regions.size());
+    run_stats.end_phase();
 
     if (opt.output_mapped_read_fa) {
-        pangraph->save_mapped_read_strings(sample_fpath, sample_outdir);
+        run_stats.start_phase("Writing mapped reads");
+        pangraph->save_mapped_read_strings(sample_fpaths, sample_outdir);
+        run_stats.end_phase();
     }
 
     BOOST_LOG_TRIVIAL(info) << "[Sample " << sample_name << "] "
@@ -521,21 +646,37 @@ int pandora_discover(DiscoverOptions& opt)
         throw std::logic_error("K must be a positive integer");
     }
 
+    // the timeline of the parallel tasks and forked workers, saved when the run ends,
+    // if asked
+    ScopedRunTracer run_tracer(opt.trace_file, "discover", opt.threads);
+
+    // the run time and memory of each phase, saved when the run ends. The CPU time
+    // of a phase includes the processes it forked
+    RunStats run_stats("discover");
+    install_memory_report_signal_handler();
+
     BOOST_LOG_TRIVIAL(info) << "Loading Index and LocalPRGs from file...";
+    run_stats.start_phase("Loading index");
     auto index = std::make_shared<Index>();
     index->load(opt.prgfile, opt.window_size, opt.kmer_size);
     std::vector<std::shared_ptr<LocalPRG>> prgs;
     read_prg_file(prgs, opt.prgfile);
     load_PRG_kmergraphs(prgs, opt.window_size, opt.kmer_size, opt.prgfile);
+    run_stats.track_memory(
+        "index", [&index]() { return index->estimate_memory_usage(); });
+    run_stats.end_phase();
 
     BOOST_LOG_TRIVIAL(info) << "Loading read index file...";
-    std::vector<std::pair<SampleIdText, SampleFpath>> samples
+    std::vector<std::pair<SampleIdText, SampleFpaths>> samples
         = load_read_index(opt.reads_idx_file);
 
     // for each sample, run pandora discover
-    for (const std::pair<SampleIdText, SampleFpath>& sample : samples) {
-        pandora_discover_core(sample, index, prgs, opt);
+    for (const std::pair<SampleIdText, SampleFpaths>& sample : samples) {
+        pandora_discover_core(sample, index, prgs, opt, run_stats);
     }
+    run_stats.untrack_memory("pangraph_reads");
+    run_stats.untrack_memory("pangraph_nodes");
+    run_stats.untrack_memory("kmer_graph_coverages");
 
     // concatenate all denovo files
     std::vector<fs::path> denovo_paths_files;
@@ -549,6 +690,10 @@ int pandora_discover(DiscoverOptions& opt)
     concatenate_denovo_files(denovo_output_file, denovo_paths_files);
     BOOST_LOG_TRIVIAL(info) << "De novo variant paths written to "
                             << denovo_output_file.string();
+
+    const auto run_stats_filepath { opt.outdir / "pandora.stats.json" };
+    run_stats.save(run_stats_filepath);
+    BOOST_LOG_TRIVIAL(info) << "Run stats written to " << run_stats_filepath;
     BOOST_LOG_TRIVIAL(info) << "All done!";
 
     return 0;
@@ -1,45 +1,197 @@
 #include <string>
 #include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
 #include "fastaq_handler.h"
+#include "fatal_error.h"
+
+const std::string FastaqHandler::stdin_filepath { "-" };
 
 FastaqHandler::FastaqHandler(const std::string filepath)
+    : FastaqHandler(std::vector<std::string> { filepath })
+{
+}
+
+FastaqHandler::FastaqHandler(const std::vector<std::string>& filepaths)
     : closed(false)
-    , filepath(filepath)
+    , inbuf(nullptr)
+    , filepaths(filepaths)
+    , current_file_index(0)
+    , fastaq_file(nullptr)
     , num_reads_parsed(0)
 {
-    this->fastaq_file = gzopen(filepath.c_str(), "r");
-    if (this->fastaq_file == nullptr) {
-        throw std::ios_base::failure("Unable to open " + this->filepath);
+    if (this->filepaths.empty()) {
+        throw std::ios_base::failure("No read file given");
     }
-    this->inbuf = kseq_init(this->fastaq_file);
+    const size_t nb_stdin_filepaths = std::count(
+        this->filepaths.begin(), this->filepaths.end(), FastaqHandler::stdin_filepath);
+    if (nb_stdin_filepaths > 1) {
+        throw std::ios_base::failure("Standard input can only be given once");
+    }
+    // the files after the first one are opened in the background, once the reads are
+    // being mapped, so check now that they can all be opened
+    for (const auto& read_filepath : this->filepaths) {
+        if (read_filepath != FastaqHandler::stdin_filepath
+            and access(read_filepath.c_str(), R_OK) != 0) {
+            fatal_error("Unable to open read file ", read_filepath);
+        }
+    }
+    this->open_file(0, open_fastaq_file(this->filepaths[0]));
 }
 
 FastaqHandler::~FastaqHandler() { this->close(); }
 
-bool FastaqHandler::eof() const { return ks_eof(this->inbuf->f); }
+gzFile FastaqHandler::open_fastaq_file(const std::string& filepath)
+{
+    int file_descriptor;
+    if (filepath == FastaqHandler::stdin_filepath) {
+        file_descriptor = dup(STDIN_FILENO);
+    } else {
+        file_descriptor = open(filepath.c_str(), O_RDONLY);
+#ifdef POSIX_FADV_WILLNEED
+        // ask the kernel to start reading the file in the background
+        if (file_descriptor != -1) {
+            posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_WILLNEED);
+        }
+#endif
+    }
 
-void FastaqHandler::get_next()
+    gzFile fastaq_file = nullptr;
+    if (file_descriptor != -1) {
+        fastaq_file = gzdopen(file_descriptor, "r");
+        if (fastaq_file == nullptr) {
+            ::close(file_descriptor);
+        }
+    }
+    if (fastaq_file == nullptr) {
+        throw std::ios_base::failure("Unable to open " + filepath);
+    }
+    return fastaq_file;
+}
+
+void FastaqHandler::open_file(const size_t file_index, gzFile fastaq_file)
+{
+    this->current_file_index = file_index;
+    this->filepath = this->filepaths[file_index];
+    this->fastaq_file = fastaq_file;
+    this->inbuf = kseq_init(this->fastaq_file);
+
+    // prefetch the next file while this one is read
+    const size_t next_file_index = file_index + 1;
+    if (next_file_index < this->filepaths.size()) {
+        this->next_fastaq_file = std::async(std::launch::async,
+            &FastaqHandler::open_fastaq_file, this->filepaths[next_file_index]);
+    }
+}
+
+void FastaqHandler::close_current_file()
+{
+    if (this->fastaq_file == nullptr) {
+        return;
+    }
+    const auto closed_status = gzclose(this->fastaq_file);
+    kseq_destroy(this->inbuf);
+    this->fastaq_file = nullptr;
+    this->inbuf = nullptr;
+
+    if (closed_status != Z_OK) {
+        std::ostringstream err_msg;
+        err_msg << "Failed to close " << this->filepath
+                << ". Got zlib return code: " << closed_status << std::endl;
+        throw std::ios_base::failure(err_msg.str());
+    }
+}
+
+void FastaqHandler::close_prefetched_file()
 {
-    if (this->eof()) {
-        throw std::out_of_range("Read requested after the end of file was reached");
+    if (this->next_fastaq_file.valid()) {
+        try {
+            gzclose(this->next_fastaq_file.get());
+        } catch (std::ios_base::failure& err) {
+            // the prefetched file could not be opened, but it was not needed anyway
+        }
     }
-    int read_status = kseq_read(this->inbuf);
+}
 
-    // if not eof but we get -1 here then it was an empty file/read/line
-    if (read_status == -1) {
-        throw std::out_of_range("Read requested after the end of file was reached");
+bool FastaqHandler::move_to_next_file()
+{
+    const bool is_last_file = this->current_file_index + 1 >= this->filepaths.size();
+    if (is_last_file) {
+        return false;
     }
-    if (read_status == -2) {
-        throw std::runtime_error("Truncated quality string detected");
-    } else if (read_status == -3) {
-        throw std::ios_base::failure("Error reading " + this->filepath);
+    gzFile next_file = this->next_fastaq_file.get();
+    this->close_current_file();
+    this->open_file(this->current_file_index + 1, next_file);
+    return true;
+}
+
+bool FastaqHandler::eof() const
+{
+    const bool is_last_file = this->current_file_index + 1 >= this->filepaths.size();
+    return is_last_file and ks_eof(this->inbuf->f);
+}
+
+void FastaqHandler::read_next_record()
+{
+    while (true) {
+        if (not ks_eof(this->inbuf->f)) {
+            int read_status = kseq_read(this->inbuf);
+
+            if (read_status == -2) {
+                throw std::runtime_error("Truncated quality string detected");
+            } else if (read_status == -3) {
+                throw std::ios_base::failure("Error reading " + this->filepath);
+            } else if (read_status >= 0) {
+                break;
+            }
+            // if not eof but we get -1 here then it was an empty file/read/line
+        }
+
+        if (not this->move_to_next_file()) {
+            throw std::out_of_range("Read requested after the end of file was reached");
+        }
     }
 
     ++this->num_reads_parsed;
+}
+
+void FastaqHandler::get_next()
+{
+    this->read_next_record();
     this->name = this->inbuf->name.s;
     this->read = this->inbuf->seq.s;
 }
 
+void FastaqHandler::get_next(ReadBatch& batch, const uint32_t read_id)
+{
+    this->read_next_record();
+    batch.add(read_id, this->inbuf->name.s, this->inbuf->name.l, this->inbuf->seq.s,
+        this->inbuf->seq.l);
+}
+
+void FastaqHandler::rewind()
+{
+    const bool reads_from_stdin
+        = std::find(this->filepaths.begin(), this->filepaths.end(),
+              FastaqHandler::stdin_filepath)
+        != this->filepaths.end();
+    if (reads_from_stdin) {
+        throw std::ios_base::failure("Unable to rewind reads given on standard input");
+    }
+
+    num_reads_parsed = 0;
+    name.clear();
+    read.clear();
+    if (this->current_file_index == 0) {
+        gzrewind(this->fastaq_file);
+        kseq_rewind(this->inbuf);
+    } else {
+        this->close_current_file();
+        this->close_prefetched_file();
+        this->open_file(0, open_fastaq_file(this->filepaths[0]));
+    }
+}
+
 void FastaqHandler::get_nth_read(const uint32_t& idx)
 {
     // edge case where no reads have been loaded yet
@@ -48,11 +200,7 @@ void FastaqHandler::get_nth_read(const uint32_t& idx)
     }
     const uint32_t one_based_idx = idx + 1;
     if (one_based_idx < this->num_reads_parsed) {
-        num_reads_parsed = 0;
-        name.clear();
-        read.clear();
-        gzrewind(this->fastaq_file);
-        kseq_rewind(this->inbuf);
+        this->rewind();
     }
 
     while (this->num_reads_parsed < one_based_idx) {
@@ -63,16 +211,9 @@ void FastaqHandler::get_nth_read(const uint32_t& idx)
 void FastaqHandler::close()
 {
     if (!this->is_closed()) {
-        const auto closed_status = gzclose(this->fastaq_file);
-        kseq_destroy(this->inbuf);
-
-        if (closed_status != Z_OK) {
-            std::ostringstream err_msg;
-            err_msg << "Failed to close " << this->filepath
-                    << ". Got zlib return code: " << closed_status << std::endl;
-            throw std::ios_base::failure(err_msg.str());
-        }
         this->closed = true;
+        this->close_prefetched_file();
+        this->close_current_file();
     }
 }
 
@@ -9,6 +9,8 @@
 #include "minirecord.h"
 #include "index.h"
 #include "localPRG.h"
+#include "memory_usage.h"
+#include "trace.h"
 
 /**
  * Adds a k-mer to the index. This is *just* called to add minimizers.
@@ -172,6 +174,22 @@ bool Index::operator==(const Index& other) const
     return true;
 }
 
+uint64_t Index::estimate_memory_usage() const
+{
+    uint64_t bytes = sizeof(Index) + estimate_hash_table_heap_memory_usage(minhash);
+    for (const auto& minimizer_and_records : minhash) {
+        const std::vector<MiniRecord>* records = minimizer_and_records.second;
+        if (records == nullptr) {
+            continue;
+        }
+        bytes += sizeof(*records) + estimate_heap_memory_usage(*records);
+        for (const auto& record : *records) {
+            bytes += record.path.estimate_heap_memory_usage();
+        }
+    }
+    return bytes;
+}
+
 bool Index::operator!=(const Index& other) const { return !(*this == other); }
 
 void index_prgs(std::vector<std::shared_ptr<LocalPRG>>& prgs,
@@ -198,6 +216,9 @@ void index_prgs(std::vector<std::shared_ptr<LocalPRG>>& prgs,
     std::atomic_uint32_t nbOfPRGsDone { 0 };
 #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
     for (uint32_t i = 0; i < prgs.size(); ++i) { // for each prg
+        TraceSpan span("index PRG", "index");
+        span.add_arg("prg_id", prgs[i]->id);
+        span.add_arg("prg", prgs[i]->name);
         uint32_t dir = i / nbOfGFAsPerDir + 1;
         prgs[i]->minimizer_sketch(
             index, w, k, (((double)(nbOfPRGsDone.load())) / prgs.size()) * 100);
@@ -31,6 +31,14 @@ void setup_index_subcommand(CLI::App& app)
         ->transform(make_absolute)
         ->default_str("<PRG>.kXX.wXX.idx");
 
+    index_subcmd
+        ->add_option("--trace", opt->trace_file,
+            "Write a timeline of the indexing of each PRG and of the waits for locks "
+            "to this file, in Chrome trace event format (to open with "
+            "https://ui.perfetto.dev)")
+        ->type_name("FILE")
+        ->transform(make_absolute);
+
     index_subcmd->add_flag(
         "-v", opt->verbosity, "Verbosity of logging. Repeat for increased verbosity");
 
@@ -69,8 +77,11 @@ int pandora_index(IndexOptions const& opt)
 
     BOOST_LOG_TRIVIAL(info) << "Indexing PRG...";
     auto index = std::make_shared<Index>();
-    index_prgs(
-        prgs, index, opt.window_size, opt.kmer_size, kmer_prgs_outdir, opt.threads);
+    {
+        ScopedRunTracer run_tracer(opt.trace_file, "index", opt.threads);
+        index_prgs(
+            prgs, index, opt.window_size, opt.kmer_size, kmer_prgs_outdir, opt.threads);
+    }
 
     // save index
     BOOST_LOG_TRIVIAL(info) << "Saving index...";
@@ -8,9 +8,19 @@
 
 #include "kmergraphwithcoverage.h"
 #include "localPRG.h"
+#include "memory_usage.h"
 
 using namespace prg;
 
+uint64_t KmerGraphWithCoverage::estimate_heap_memory_usage() const
+{
+    uint64_t bytes = ::estimate_heap_memory_usage(node_index_to_sample_coverage);
+    for (const auto& sample_coverage : node_index_to_sample_coverage) {
+        bytes += ::estimate_heap_memory_usage(sample_coverage);
+    }
+    return bytes;
+}
+
 void KmerGraphWithCoverage::set_exp_depth_covg(const uint32_t edp)
 {
     const bool exp_depth_covg_parameter_is_valid = edp > 0;
@@ -12,6 +12,7 @@
 #include "utils.h"
 #include "fastaq.h"
 #include "Maths.h"
+#include "trace.h"
 
 bool LocalPRG::do_path_memoization_in_nodes_along_path_method = false;
 
@@ -566,9 +567,11 @@ void LocalPRG::minimizer_sketch(const std::shared_ptr<Index>& index, const uint3
                         kn = kmer_prg.add_node_with_kh(
                             kmer_path, std::min(kh.first, kh.second), num_AT);
 
+                        const double index_wait_start = trace_timestamp();
 // TODO: name these criticals
 #pragma omp critical
                         { // and now to the index
+                            trace_lock_wait("index", index_wait_start);
                             index->add_record(std::min(kh.first, kh.second), id,
                                 kmer_path, kn->id, (kh.first <= kh.second));
                         }
@@ -628,9 +631,11 @@ void LocalPRG::minimizer_sketch(const std::shared_ptr<Index>& index, const uint3
                     new_kn = kmer_prg.add_node_with_kh(
                         *(v.back()), std::min(kh.first, kh.second), num_AT);
 
+                    const double index_wait_start = trace_timestamp();
 // TODO: name these criticals
 #pragma omp critical
                     {
+                        trace_lock_wait("index", index_wait_start);
                         index->add_record(std::min(kh.first, kh.second), id,
                             *(v.back()), new_kn->id, (kh.first <= kh.second));
                     }
@@ -679,9 +684,11 @@ void LocalPRG::minimizer_sketch(const std::shared_ptr<Index>& index, const uint3
                             new_kn = kmer_prg.add_node_with_kh(
                                 *(v[j]), std::min(kh.first, kh.second), num_AT);
 
+                            const double index_wait_start = trace_timestamp();
 // TODO: name these criticals
 #pragma omp critical
                             {
+                                trace_lock_wait("index", index_wait_start);
                                 index->add_record(std::min(kh.first, kh.second), id,
                                     *(v[j]), new_kn->id, (kh.first <= kh.second));
                             }
@@ -1657,7 +1664,8 @@ void LocalPRG::add_consensus_path_to_fastaq(Fastaq& output_fq, PanNodePtr pnode,
     const bool bin, const uint32_t global_covg,
     const uint32_t& max_num_kmers_to_average, const uint32_t& sample_id) const
 {
-    if (pnode->reads.empty()) {
+    // reads are not stored in coverage-only pangraphs, only counted in covg
+    if (pnode->reads.empty() and pnode->covg == 0) {
         BOOST_LOG_TRIVIAL(warning) << "Node " << pnode->get_name() << " has no reads";
         return;
     }
@@ -1704,8 +1712,10 @@ void LocalPRG::add_consensus_path_to_fastaq(Fastaq& output_fq, PanNodePtr pnode,
     std::string header = " log P(data|sequence)=" + std::to_string(ppath);
     std::string seq = string_along_path(lmp);
 
+    const double consensus_fq_wait_start = trace_timestamp();
 #pragma omp critical(consensus_fq)
     {
+        trace_lock_wait("consensus_fq", consensus_fq_wait_start);
         output_fq.add_entry(fq_name, seq, covgs, global_covg, header);
     }
 }
@@ -1769,8 +1779,10 @@ void LocalPRG::add_variants_to_vcf(VCF& master_vcf, PanNodePtr pnode,
         vcf, pnode->kmer_prg_with_coverage, reference_path, sample_name, sample_id);
     vcf = vcf.merge_multi_allelic();
     vcf = vcf.correct_dot_alleles(string_along_path(reference_path), name);
+    const double master_vcf_wait_start = trace_timestamp();
 #pragma omp critical(master_vcf)
     {
+        trace_lock_wait("master_vcf", master_vcf_wait_start);
         master_vcf.append_vcf(vcf);
     }
 }
@@ -9,6 +9,7 @@
 #include "get_vcf_ref_main.h"
 #include "random_main.h"
 #include "merge_index_main.h"
+#include "simulate_main.h"
 #include "denovo_discovery/discover_main.h"
 
 class MyFormatter : public CLI::Formatter {
@@ -70,6 +71,7 @@ int main(int argc, char* argv[])
     setup_get_vcf_ref_subcommand(app);
     setup_random_subcommand(app);
     setup_merge_index_subcommand(app);
+    setup_simulate_subcommand(app);
     app.require_subcommand();
 
     CLI11_PARSE(app, argc, argv);
@@ -15,11 +15,13 @@ void setup_map_subcommand(CLI::App& app)
         ->type_name("FILE");
 
     map_subcmd
-        ->add_option(
-            "<QUERY>", opt->readsfile, "Fast{a,q} file containing reads to quasi-map")
+        ->add_option("<QUERY>", opt->readsfiles,
+            "Fast{a,q} file(s) containing reads to quasi-map. Several files are mapped "
+            "as a single sample, and - reads from standard input")
         ->required()
         ->transform(make_absolute)
-        ->check(CLI::ExistingFile.description(""))
+        ->check((CLI::ExistingFile | CLI::IsMember({ FastaqHandler::stdin_filepath }))
+                    .description(""))
         ->type_name("FILE");
 
     map_subcmd
@@ -56,6 +58,20 @@ void setup_map_subcommand(CLI::App& app)
         ->check(CLI::ExistingFile.description(""))
         ->group("Input/Output");
 
+    description = "Write a timeline of the parallel tasks and of the waits for locks "
+                  "to this file, in Chrome trace event format (to open with "
+                  "https://ui.perfetto.dev)";
+    map_subcmd->add_option("--trace", opt->trace_file, description)
+        ->type_name("FILE")
+        ->transform(make_absolute)
+        ->group("Input/Output");
+
+    description = "Add histograms of the hits and clusters of the reads to "
+                  "pandora.stats.json. Slows mapping down, as all the hits of each "
+                  "read are then counted";
+    map_subcmd->add_flag("--mapping-histograms", opt->mapping_histograms, description)
+        ->group("Input/Output");
+
     map_subcmd
         ->add_option(
             "-e,--error-rate", opt->error_rate, "Estimated error rate for reads")
@@ -120,6 +136,27 @@ void setup_map_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Filtering");
 
+    description = "Randomly subsample the reads to --max-covg (hashing read names), "
+                  "instead of mapping the first reads up to --max-covg. The number "
+                  "of bases is estimated from the first reads and the file sizes";
+    map_subcmd->add_flag("--subsample", opt->subsample, description)
+        ->group("Filtering");
+
+    description = "Skip reads with more than this number of hits, e.g. chimeric or "
+                  "low complexity reads which would stall a thread when clustering "
+                  "their hits (0 for no limit)";
+    map_subcmd->add_option("--max-read-hits", opt->max_read_hits, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
+    description = "Skip reads with hits on more than this number of loci (0 for no "
+                  "limit)";
+    map_subcmd->add_option("--max-read-loci", opt->max_read_prgs, description)
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Filtering");
+
     description = "Add extra step to carefully genotype sites.";
     auto* gt_opt = map_subcmd->add_flag("--genotype", opt->genotype, description)
                        ->group("Consensus/Variant Calling");
@@ -142,6 +179,17 @@ void setup_map_subcommand(CLI::App& app)
         ->type_name("INT")
         ->group("Mapping");
 
+    description = "Split clusters of hits into chains of colinear hits (read and PRG "
+                  "positions both increasing) before filtering them";
+    map_subcmd->add_flag("--chain", opt->chain_hits, description)->group("Mapping");
+
+    description = "Only compute the coverage of the loci: the hits of each read add "
+                  "coverage to the kmer graphs as the read is mapped, and neither "
+                  "reads nor hits are kept, so memory does not grow with the number "
+                  "of reads. Can not be used with --clean or -M";
+    map_subcmd->add_flag("--coverage-only", opt->coverage_only, description)
+        ->group("Mapping");
+
     description = "Maximum number of kmers to average over when selecting the maximum "
                   "likelihood path";
     map_subcmd->add_option("--kmer-avg", opt->max_num_kmers_to_avg, description)
@@ -236,6 +284,19 @@ int pandora_map(MapOptions& opt)
         opt.output_vcf = true;
     }
 
+    const bool reads_from_stdin
+        = std::find(opt.readsfiles.begin(), opt.readsfiles.end(),
+              FastaqHandler::stdin_filepath)
+        != opt.readsfiles.end();
+    if (reads_from_stdin and opt.output_mapped_read_fa) {
+        fatal_error("Mapped reads can not be output (-M) when reads are given on ",
+            "standard input");
+    }
+    if (opt.coverage_only and (opt.clean or opt.output_mapped_read_fa)) {
+        fatal_error("--coverage-only does not keep reads, so it can not be used with ",
+            "--clean or -M");
+    }
+
     GenotypingOptions genotyping_options({}, opt.genotyping_error_rate,
         opt.confidence_threshold, opt.min_allele_covg_gt,
         opt.min_allele_fraction_covg_gt, opt.min_total_covg_gt, opt.min_diff_covg_gt, 0,
@@ -247,44 +308,93 @@ int pandora_map(MapOptions& opt)
         fs::create_directories(kmer_graphs_dir);
     }
 
+    // the timeline of the parallel tasks, saved when the run ends, if asked
+    ScopedRunTracer run_tracer(opt.trace_file, "map", opt.threads);
+
+    // the run time and memory of each phase, saved when the run ends
+    RunStats run_stats("map");
+    const auto run_stats_filepath { opt.outdir / "pandora.stats.json" };
+    install_memory_report_signal_handler();
+
     BOOST_LOG_TRIVIAL(info) << "Loading Index and LocalPRGs from file...";
+    run_stats.start_phase("Loading index");
     auto index = std::make_shared<Index>();
     index->load(opt.prgfile, opt.window_size, opt.kmer_size);
     std::vector<std::shared_ptr<LocalPRG>> prgs;
     read_prg_file(prgs, opt.prgfile);
     load_PRG_kmergraphs(prgs, opt.window_size, opt.kmer_size, opt.prgfile);
+    run_stats.track_memory(
+        "index", [&index]() { return index->estimate_memory_usage(); });
+    run_stats.end_phase();
 
     BOOST_LOG_TRIVIAL(info)
         << "Constructing pangenome::Graph from read file (this will take a while)...";
+    run_stats.start_phase("Mapping reads");
     auto pangraph = std::make_shared<pangenome::Graph>();
-    uint32_t covg = pangraph_from_read_file(opt.readsfile.string(), pangraph, index,
-        prgs, opt.window_size, opt.kmer_size, opt.max_diff, opt.error_rate,
-        opt.min_cluster_size, opt.genome_size, opt.illumina, opt.clean, opt.max_covg,
-        opt.threads);
+    run_stats.track_memory("pangraph_reads",
+        [&pangraph]() { return pangraph->estimate_reads_memory_usage(); });
+    run_stats.track_memory("pangraph_nodes",
+        [&pangraph]() { return pangraph->estimate_nodes_memory_usage(); });
+    run_stats.track_memory("kmer_graph_coverages", [&pangraph]() {
+        return pangraph->estimate_kmer_graph_coverages_memory_usage();
+    });
+    MappingOptions mapping_options;
+    mapping_options.window_size = opt.window_size;
+    mapping_options.kmer_size = opt.kmer_size;
+    mapping_options.max_diff = opt.max_diff;
+    mapping_options.error_rate = opt.error_rate;
+    mapping_options.min_cluster_size = opt.min_cluster_size;
+    mapping_options.genome_size = opt.genome_size;
+    mapping_options.illumina = opt.illumina;
+    mapping_options.clean = opt.clean;
+    mapping_options.max_covg = opt.max_covg;
+    mapping_options.threads = opt.threads;
+    mapping_options.chain_hits = opt.chain_hits;
+    mapping_options.subsample = opt.subsample;
+    mapping_options.coverage_only = opt.coverage_only;
+    mapping_options.max_read_hits = opt.max_read_hits;
+    mapping_options.max_read_prgs = opt.max_read_prgs;
+    mapping_options.mapping_histograms = opt.mapping_histograms;
+    MappingStats mapping_stats;
+    uint32_t covg = pangraph_from_read_file(
+        opt.readsfiles, pangraph, index, prgs, mapping_options, &mapping_stats);
+    add_mapping_counts(run_stats, mapping_stats);
+    run_stats.end_phase();
 
     if (pangraph->nodes.empty()) {
         BOOST_LOG_TRIVIAL(info) << "Found non of the LocalPRGs in the reads.";
+        run_stats.save(run_stats_filepath);
         BOOST_LOG_TRIVIAL(info) << "Done!";
         return 0;
     }
 
     const auto pangraph_gfa { opt.outdir / "pandora.pangraph.gfa" };
     BOOST_LOG_TRIVIAL(info) << "Writing pangenome::Graph to file " << pangraph_gfa;
+    run_stats.start_phase("Writing pangraph");
     write_pangraph_gfa(pangraph_gfa, pangraph);
+    run_stats.end_phase();
 
-    BOOST_LOG_TRIVIAL(info) << "Updating local PRGs with hits...";
     uint32_t sample_id = 0;
-    pangraph->add_hits_to_kmergraphs();
+    if (not opt.coverage_only) {
+        // in coverage-only mode, the kmer graphs got their coverage during mapping
+        BOOST_LOG_TRIVIAL(info) << "Updating local PRGs with hits...";
+        run_stats.start_phase("Adding hits to kmer graphs");
+        pangraph->add_hits_to_kmergraphs(sample_id, opt.threads);
+        run_stats.end_phase();
+    }
 
     BOOST_LOG_TRIVIAL(info) << "Estimating parameters for kmer graph model...";
+    run_stats.start_phase("Estimating parameters");
     auto exp_depth_covg = estimate_parameters(pangraph, opt.outdir, opt.kmer_size,
         opt.error_rate, covg, opt.binomial, sample_id);
     genotyping_options.add_exp_depth_covg(exp_depth_covg);
     if (genotyping_options.get_min_kmer_covg() == 0) {
         genotyping_options.set_min_kmer_covg(exp_depth_covg / 10);
     }
+    run_stats.end_phase();
 
     BOOST_LOG_TRIVIAL(info) << "Find PRG paths and write to files...";
+    run_stats.start_phase("Finding paths");
 
     // paralell region!
     // shared variable - synced with critical(consensus_fq)
@@ -292,6 +402,8 @@ int pandora_map(MapOptions& opt)
 
     // shared variable - synced with critical(master_vcf)
     VCF master_vcf(&genotyping_options);
+    run_stats.track_memory(
+        "vcf_records", [&master_vcf]() { return master_vcf.estimate_memory_usage(); });
 
     // shared variable - synced with critical(candidate_regions)
     CandidateRegions candidate_regions;
@@ -308,26 +420,32 @@ int pandora_map(MapOptions& opt)
         load_vcf_refs_file(opt.vcf_refs_file, vcf_refs);
     }
 
-    // transforms the pangraph->nodes from map to vector so that we can run it in
-    // parallel
-    // TODO: use OMP task instead?
-    std::vector<pangenome::NodePtr> pangraphNodesAsVector;
-    pangraphNodesAsVector.reserve(pangraph->nodes.size());
-    for (auto pan_id_to_node_mapping = pangraph->nodes.begin();
-         pan_id_to_node_mapping != pangraph->nodes.end(); ++pan_id_to_node_mapping)
-        pangraphNodesAsVector.push_back(pan_id_to_node_mapping->second);
+    // the nodes are indexed by id, so the parallel loop runs over the ids and skips
+    // those without a node. No node is added or removed within the loop
+    const uint32_t number_of_loci = pangraph->nodes.size();
+    const uint32_t node_id_bound = pangraph->nodes.id_bound();
 
 // TODO: check the batch size
 #pragma omp parallel for num_threads(opt.threads) schedule(dynamic, 10)
-    for (uint32_t i = 0; i < pangraphNodesAsVector.size(); ++i) {
+    for (uint32_t node_id = 0; node_id < node_id_bound; ++node_id) {
+        if (not pangraph->nodes.contains(node_id)) {
+            continue;
+        }
+
         // add some progress
-        if (i && i % 100 == 0) {
+        if (node_id && node_id % 100 == 0) {
             BOOST_LOG_TRIVIAL(info)
-                << ((double)i) / pangraphNodesAsVector.size() * 100 << "% done";
+                << ((double)node_id) / node_id_bound * 100 << "% done";
         }
 
         // get the node
-        const auto& pangraph_node = pangraphNodesAsVector[i];
+        const auto& pangraph_node = pangraph->nodes.at(node_id);
+        TraceSpan span("consensus", "map");
+        span.add_arg("prg_id", pangraph_node->prg_id);
+        span.add_arg("node_id", pangraph_node->node_id);
+        if (get_run_tracer()) {
+            span.add_arg("node", pangraph_node->get_name());
+        }
 
         // get the vcf_ref, if applicable
         std::string vcf_ref;
@@ -344,8 +462,10 @@ int pandora_map(MapOptions& opt)
             opt.max_num_kmers_to_avg, 0);
 
         if (kmp.empty()) {
+            const double wait_start = trace_timestamp();
 #pragma omp critical(nodes_to_remove)
             {
+                trace_lock_wait("nodes_to_remove", wait_start);
                 nodes_to_remove.push_back(pangraph_node);
             }
             continue;
@@ -373,6 +493,8 @@ int pandora_map(MapOptions& opt)
     if (opt.output_vcf) {
         master_vcf.save(opt.outdir / "pandora_consensus.vcf", true, false);
     }
+    run_stats.add_count("loci", number_of_loci);
+    run_stats.end_phase();
 
     if (pangraph->nodes.empty()) {
         BOOST_LOG_TRIVIAL(error)
@@ -380,11 +502,13 @@ int pandora_map(MapOptions& opt)
                "your genome_size accurate?"
             << " Genome size is assumed to be " << opt.genome_size
             << " and can be updated with --genome_size";
+        run_stats.save(run_stats_filepath);
         return 0;
     }
 
     if (opt.genotype) {
         BOOST_LOG_TRIVIAL(info) << "Genotyping VCF...";
+        run_stats.start_phase("Genotyping");
         master_vcf.genotype(opt.local_genotype);
         BOOST_LOG_TRIVIAL(info) << "Finished genotyping VCF";
         const auto gt_vcf_filepath { opt.outdir / "pandora_genotyped.vcf" };
@@ -394,12 +518,17 @@ int pandora_map(MapOptions& opt)
         } else {
             master_vcf.save(gt_vcf_filepath, false, true);
         }
+        run_stats.end_phase();
     }
 
     if (opt.output_mapped_read_fa) {
-        pangraph->save_mapped_read_strings(opt.readsfile, opt.outdir);
+        run_stats.start_phase("Writing mapped reads");
+        pangraph->save_mapped_read_strings(opt.readsfiles, opt.outdir);
+        run_stats.end_phase();
     }
 
+    run_stats.save(run_stats_filepath);
+    BOOST_LOG_TRIVIAL(info) << "Run stats written to " << run_stats_filepath;
     BOOST_LOG_TRIVIAL(info) << "Done!";
     return 0;
 }
@@ -0,0 +1,58 @@
+#include <atomic>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+#include <boost/log/trivial.hpp>
+
+#include "memory_usage.h"
+#include "run_stats.h"
+
+// set by the SIGUSR1 handler, and reset when the memory report is logged
+std::atomic<bool> memory_report_signal_received { false };
+
+uint64_t get_current_rss_bytes()
+{
+    // the second field of statm is the number of resident pages
+    std::ifstream statm("/proc/self/statm");
+    uint64_t total_pages = 0, resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+// only sets a lock-free flag, so that it is async-signal-safe
+void handle_memory_report_signal(int) { memory_report_signal_received = true; }
+
+void install_memory_report_signal_handler()
+{
+    struct sigaction action;
+    action.sa_handler = handle_memory_report_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
+
+bool memory_report_requested() { return memory_report_signal_received.exchange(false); }
+
+// bytes as megabytes with one decimal
+std::string to_megabytes(const uint64_t bytes)
+{
+    std::stringstream out;
+    out << std::fixed << std::setprecision(1) << (double)bytes / (1024 * 1024) << " MB";
+    return out.str();
+}
+
+void log_memory_breakdown(const std::string& when, const MemoryBreakdown& breakdown)
+{
+    std::stringstream out;
+    out << "Memory usage " << when << ": RSS " << to_megabytes(get_current_rss_bytes())
+        << " (peak " << to_megabytes(get_peak_rss_bytes()) << ")";
+    for (const auto& name_and_bytes : breakdown) {
+        out << ", " << name_and_bytes.first << " "
+            << to_megabytes(name_and_bytes.second);
+    }
+    BOOST_LOG_TRIVIAL(info) << out.str();
+}
@@ -8,8 +8,11 @@ MinimizerHit::MinimizerHit(const uint32_t i, const Minimizer& minimizer_from_rea
     const MiniRecord& minimizer_from_PRG)
     : read_id { i }
     , read_start_position { minimizer_from_read.pos_of_kmer_in_read.start }
-    , read_strand { minimizer_from_read.is_forward_strand }
-    , minimizer_from_PRG { minimizer_from_PRG }
+    , prg_id { minimizer_from_PRG.prg_id }
+    , kmer_node_id { minimizer_from_PRG.knode_id }
+    , same_strands { minimizer_from_read.is_forward_strand
+          == minimizer_from_PRG.strand }
+    , minimizer_from_PRG { &minimizer_from_PRG }
 {
     const bool both_minimizers_have_same_length
         = minimizer_from_read.pos_of_kmer_in_read.length
@@ -1,16 +1,106 @@
 #include <functional>
 #include <memory>
+#include <algorithm>
 #include "minihits.h"
 #include "minihit.h"
 #include "minirecord.h"
 #include "minimizer.h"
+#include "fatal_error.h"
+
+constexpr uint32_t MinimizerHits::max_sortable_prg_id;
 
 void MinimizerHits::add_hit(const uint32_t i, const Minimizer& minimizer_from_read,
     const MiniRecord& minimizer_from_PRG)
 {
-    MinimizerHitPtr mh(
-        std::make_shared<MinimizerHit>(i, minimizer_from_read, minimizer_from_PRG));
-    hits.insert(mh);
+    hits.emplace_back(i, minimizer_from_read, minimizer_from_PRG);
+}
+
+void MinimizerHits::radix_sort_entries()
+{
+    // LSD radix sort on 8-bit digits: first the 8 bytes of the key, then the 4 bytes
+    // of the read id. Passes where all entries share the same digit are skipped, which
+    // is the case for the read id when all hits come from a single read
+    constexpr uint32_t nb_key_passes = sizeof(uint64_t);
+    constexpr uint32_t nb_passes = nb_key_passes + sizeof(uint32_t);
+    const auto digit_of = [](const SortEntry& entry, const uint32_t pass) -> uint8_t {
+        if (pass < nb_key_passes) {
+            return (entry.key >> (8 * pass)) & 0xFF;
+        }
+        return (entry.read_id >> (8 * (pass - nb_key_passes))) & 0xFF;
+    };
+
+    sort_entries_buffer.resize(sort_entries.size());
+    for (uint32_t pass = 0; pass < nb_passes; ++pass) {
+        size_t bucket_offsets[256] = { 0 };
+        for (const auto& entry : sort_entries) {
+            ++bucket_offsets[digit_of(entry, pass)];
+        }
+        const bool all_entries_share_the_digit
+            = bucket_offsets[digit_of(sort_entries[0], pass)] == sort_entries.size();
+        if (all_entries_share_the_digit) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& bucket_offset : bucket_offsets) {
+            const size_t bucket_size = bucket_offset;
+            bucket_offset = offset;
+            offset += bucket_size;
+        }
+        for (const auto& entry : sort_entries) {
+            sort_entries_buffer[bucket_offsets[digit_of(entry, pass)]++] = entry;
+        }
+        sort_entries.swap(sort_entries_buffer);
+    }
+}
+
+void MinimizerHits::sort()
+{
+    if (hits.size() < 2) {
+        return;
+    }
+
+    // key in the order of MinimizerHit::operator<: prg id, then forward hits first,
+    // then read position. The read id is sorted on separately. The prg id only has the
+    // 31 highest bits of the key
+    sort_entries.clear();
+    sort_entries.reserve(hits.size());
+    for (uint32_t i = 0; i < hits.size(); ++i) {
+        const MinimizerHit& hit = hits[i];
+        if (hit.get_prg_id() >= max_sortable_prg_id) {
+            fatal_error("Error sorting minimizer hits: PRG id ", hit.get_prg_id(),
+                " is too large, PRG ids must be less than ", max_sortable_prg_id);
+        }
+        const uint64_t key = ((uint64_t)hit.get_prg_id() << 33)
+            | ((uint64_t)(not hit.is_forward()) << 32) | hit.get_read_start_position();
+        sort_entries.push_back({ key, hit.get_read_id(), i });
+    }
+    radix_sort_entries();
+
+    hits_buffer.clear();
+    hits_buffer.reserve(hits.size());
+    for (const auto& entry : sort_entries) {
+        hits_buffer.push_back(hits[entry.hit_index]);
+    }
+    hits.swap(hits_buffer);
+
+    // hits with the same key can still differ by their PRG path, which is the last
+    // criterion of MinimizerHit::operator<
+    auto run_start = hits.begin();
+    for (uint32_t i = 1; i <= sort_entries.size(); ++i) {
+        const bool run_ends = i == sort_entries.size()
+            or sort_entries[i].key != sort_entries[i - 1].key
+            or sort_entries[i].read_id != sort_entries[i - 1].read_id;
+        if (run_ends) {
+            const auto run_end = hits.begin() + i;
+            if (run_end - run_start > 1) {
+                std::sort(run_start, run_end);
+            }
+            run_start = run_end;
+        }
+    }
+
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
 }
 
 /*std::ostream& operator<< (std::ostream & out, MinimizerHits const& m) {
@@ -165,3 +255,81 @@ bool clusterComp_size::operator()(
     }
     return false;
 }
+
+MinimizerHitClusterRange::MinimizerHitClusterRange(
+    const std::vector<MinimizerHit>& hits, const uint32_t begin, const uint32_t end)
+    : begin { begin }
+    , end { end }
+    , read_id { hits[begin].get_read_id() }
+    , prg_id { hits[begin].get_prg_id() }
+    , is_forward { hits[begin].is_forward() }
+    , first_read_start_position { hits[begin].get_read_start_position() }
+    , last_read_start_position { hits[end - 1].get_read_start_position() }
+{
+}
+
+void MinimizerHitClusters::add(
+    const std::vector<MinimizerHitClusterRange>& clusters_to_add,
+    const std::vector<MinimizerHit>& hits_of_clusters)
+{
+    for (const auto& cluster : clusters_to_add) {
+        MinimizerHitClusterRange staged_cluster = cluster;
+        staged_cluster.begin = hits.size();
+        hits.insert(hits.end(), hits_of_clusters.begin() + cluster.begin,
+            hits_of_clusters.begin() + cluster.end);
+        staged_cluster.end = hits.size();
+        clusters.push_back(staged_cluster);
+    }
+}
+
+bool clusterRangeComp::operator()(
+    const MinimizerHitClusterRange& lhs, const MinimizerHitClusterRange& rhs) const
+{
+    if (lhs.read_id != rhs.read_id) {
+        return lhs.read_id < rhs.read_id;
+    }
+    if (lhs.first_read_start_position != rhs.first_read_start_position) {
+        return lhs.first_read_start_position < rhs.first_read_start_position;
+    }
+    if (lhs.size() != rhs.size()) {
+        return lhs.size() > rhs.size();
+    } // want bigger first!
+    if (lhs.prg_id != rhs.prg_id) {
+        return lhs.prg_id < rhs.prg_id;
+    }
+    const auto& lhs_path = hits[lhs.begin].get_prg_path();
+    const auto& rhs_path = hits[rhs.begin].get_prg_path();
+    if (lhs_path < rhs_path) {
+        return true;
+    }
+    if (rhs_path < lhs_path) {
+        return false;
+    }
+    return lhs.is_forward < rhs.is_forward;
+}
+
+bool clusterRangeComp_size::operator()(
+    const MinimizerHitClusterRange& lhs, const MinimizerHitClusterRange& rhs) const
+{
+    if (lhs.read_id != rhs.read_id) {
+        return lhs.read_id < rhs.read_id;
+    }
+    if (lhs.size() != rhs.size()) {
+        return lhs.size() > rhs.size();
+    }
+    if (lhs.first_read_start_position != rhs.first_read_start_position) {
+        return lhs.first_read_start_position < rhs.first_read_start_position;
+    }
+    if (lhs.prg_id != rhs.prg_id) {
+        return lhs.prg_id < rhs.prg_id;
+    }
+    const auto& lhs_path = hits[lhs.begin].get_prg_path();
+    const auto& rhs_path = hits[rhs.begin].get_prg_path();
+    if (lhs_path < rhs_path) {
+        return true;
+    }
+    if (rhs_path < lhs_path) {
+        return false;
+    }
+    return lhs.is_forward < rhs.is_forward;
+}
@@ -1,14 +1,17 @@
 #include <iostream>
+#include <exception>
 #include <map>
 #include <unordered_set>
 #include <set>
 #include <utility>
 #include <vector>
 #include "utils.h"
+#include "noise_filtering.h"
 #include "pangenome/pangraph.h"
 #include "pangenome/pannode.h"
 #include "de_bruijn/graph.h"
 #include "minihit.h"
+#include "trace.h"
 
 uint_least32_t node_plus_orientation_to_num(
     const uint_least32_t node_id, const bool orientation)
@@ -59,10 +62,42 @@ void hashed_node_ids_to_ids_and_orientations(
     }
 }
 
-bool overlap_forwards(
-    const std::deque<uint_least32_t>& node1, const std::deque<uint_least32_t>& node2)
+std::deque<uint_least32_t> rc_hashed_node_ids(
+    const std::deque<uint_least32_t>& hashed_node_ids)
+{
+    std::deque<uint_least32_t> d;
+    for (const auto& i : hashed_node_ids) {
+        d.push_front(rc_num(i));
+    }
+    return d;
+}
+
+uint_least32_t oriented_hashed_node_id(
+    const std::deque<uint_least32_t>& hashed_node_ids, const uint32_t i,
+    const bool forward)
+{
+    if (forward) {
+        return hashed_node_ids[i];
+    }
+    return rc_num(hashed_node_ids[hashed_node_ids.size() - 1 - i]);
+}
+
+// As overlap_backwards() and overlap_forwards(), with the second node read in the
+// given orientation, without reverse complementing it into a new deque
+bool oriented_overlap_backwards(const std::deque<uint_least32_t>& node1,
+    const std::deque<uint_least32_t>& node2, const bool node2_forward)
+{
+    for (uint32_t i = 1; i < std::min(node1.size() + 1, node2.size()); ++i) {
+        if (oriented_hashed_node_id(node2, i, node2_forward) != node1[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool oriented_overlap_forwards(const std::deque<uint_least32_t>& node1,
+    const std::deque<uint_least32_t>& node2, const bool node2_forward)
 {
-    // second deque should extend first by 1
     const bool first_node_is_larger_or_same_size = node1.size() >= node2.size();
     if (!first_node_is_larger_or_same_size) {
         fatal_error("Error on checking for overlaps in noise filtering: first node "
@@ -72,7 +107,7 @@ bool overlap_forwards(
     uint32_t i = node1.size() - node2.size() + 1;
     uint32_t j = 0;
     while (i < node1.size() and j < node2.size()) {
-        if (node1[i] != node2[j]) {
+        if (node1[i] != oriented_hashed_node_id(node2, j, node2_forward)) {
             return false;
         }
         i++;
@@ -81,25 +116,17 @@ bool overlap_forwards(
     return true;
 }
 
-bool overlap_backwards(
+bool overlap_forwards(
     const std::deque<uint_least32_t>& node1, const std::deque<uint_least32_t>& node2)
 {
-    for (uint32_t i = 1; i < std::min(node1.size() + 1, node2.size()); ++i) {
-        if (node2[i] != node1[i - 1]) {
-            return false;
-        }
-    }
-    return true;
+    // second deque should extend first by 1
+    return oriented_overlap_forwards(node1, node2, true);
 }
 
-std::deque<uint_least32_t> rc_hashed_node_ids(
-    const std::deque<uint_least32_t>& hashed_node_ids)
+bool overlap_backwards(
+    const std::deque<uint_least32_t>& node1, const std::deque<uint_least32_t>& node2)
 {
-    std::deque<uint_least32_t> d;
-    for (const auto& i : hashed_node_ids) {
-        d.push_front(rc_num(i));
-    }
-    return d;
+    return oriented_overlap_backwards(node1, node2, true);
 }
 
 std::deque<uint_least32_t> extend_hashed_pg_node_ids_backwards(
@@ -107,18 +134,13 @@ std::deque<uint_least32_t> extend_hashed_pg_node_ids_backwards(
 {
     std::deque<uint_least32_t> hashed_pg_node_ids
         = dbg.nodes.at(dbg_node_ids.at(0))->hashed_node_ids;
-    std::deque<uint_least32_t> rev_node;
 
     for (uint32_t i = 1; i < dbg_node_ids.size(); ++i) {
-        rev_node
-            = rc_hashed_node_ids(dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids);
-        if (overlap_backwards(hashed_pg_node_ids,
-                dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids)) {
-            hashed_pg_node_ids.push_front(
-                dbg.nodes.at(dbg_node_ids[i])->hashed_node_ids[0]);
-        } else if (overlap_backwards(hashed_pg_node_ids, rev_node)) {
-            hashed_pg_node_ids.push_front(
-                rc_num(dbg.nodes.at(dbg_node_ids[i])->hashed_node_ids.back()));
+        const auto& node_ids = dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids;
+        if (oriented_overlap_backwards(hashed_pg_node_ids, node_ids, true)) {
+            hashed_pg_node_ids.push_front(node_ids[0]);
+        } else if (oriented_overlap_backwards(hashed_pg_node_ids, node_ids, false)) {
+            hashed_pg_node_ids.push_front(rc_num(node_ids.back()));
         } else {
             hashed_pg_node_ids.clear();
             break;
@@ -132,18 +154,13 @@ std::deque<uint_least32_t> extend_hashed_pg_node_ids_forwards(
 {
     std::deque<uint_least32_t> hashed_pg_node_ids
         = dbg.nodes.at(dbg_node_ids.at(0))->hashed_node_ids;
-    std::deque<uint_least32_t> rev_node;
 
     for (uint32_t i = 1; i < dbg_node_ids.size(); ++i) {
-        rev_node
-            = rc_hashed_node_ids(dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids);
-        if (overlap_forwards(hashed_pg_node_ids,
-                dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids)) {
-            hashed_pg_node_ids.push_back(
-                dbg.nodes.at(dbg_node_ids[i])->hashed_node_ids.back());
-        } else if (overlap_forwards(hashed_pg_node_ids, rev_node)) {
-            hashed_pg_node_ids.push_back(
-                rc_num(dbg.nodes.at(dbg_node_ids[i])->hashed_node_ids[0]));
+        const auto& node_ids = dbg.nodes.at(dbg_node_ids.at(i))->hashed_node_ids;
+        if (oriented_overlap_forwards(hashed_pg_node_ids, node_ids, true)) {
+            hashed_pg_node_ids.push_back(node_ids.back());
+        } else if (oriented_overlap_forwards(hashed_pg_node_ids, node_ids, false)) {
+            hashed_pg_node_ids.push_back(rc_num(node_ids[0]));
         } else {
             hashed_pg_node_ids.clear();
             break;
@@ -178,40 +195,53 @@ void dbg_node_ids_to_ids_and_orientations(const debruijn::Graph& dbg,
     hashed_node_ids_to_ids_and_orientations(hashed_pg_node_ids, node_ids, node_orients);
 }
 
-void construct_debruijn_graph(
-    std::shared_ptr<pangenome::Graph> pangraph, debruijn::Graph& dbg)
+void construct_debruijn_graph(std::shared_ptr<pangenome::Graph> pangraph,
+    debruijn::Graph& dbg, const uint32_t threads)
 {
     dbg.nodes.clear();
     dbg.node_hash.clear();
 
-    debruijn::OrientedNodePtr prev, current;
-    std::deque<uint_least32_t> hashed_ids;
-
+    std::vector<uint32_t> read_ids;
+    std::vector<pangenome::Read*> reads;
+    // the hashed ids of the oriented pangraph nodes along each read, one read after the
+    // other in a single buffer
+    std::vector<size_t> sequence_starts = { 0 };
     for (const auto& r : pangraph->reads) {
         if (r.second->get_nodes().size() < dbg.size) {
             // can't add anything for this read
             continue;
         }
-
-        prev = std::make_pair(nullptr, false);
-        current = std::make_pair(nullptr, false);
-        hashed_ids.clear();
-
-        for (uint32_t i = 0; i < r.second->get_nodes().size(); ++i) {
-            hashed_ids.push_back(
-                node_plus_orientation_to_num(r.second->get_nodes()[i].lock()->node_id,
-                    r.second->node_orientations[i]));
-
-            if (hashed_ids.size() == dbg.size) {
-                current = dbg.add_node(hashed_ids, r.first);
-                if (prev.first != nullptr and current.first != nullptr) {
-                    dbg.add_edge(prev, current);
+        read_ids.push_back(r.first);
+        reads.push_back(r.second.get());
+        sequence_starts.push_back(
+            sequence_starts.back() + r.second->get_nodes().size());
+    }
+    std::vector<uint_least32_t> hashed_node_ids(sequence_starts.back());
+
+    // exceptions can not leave the parallel region, the first one is rethrown after it
+    std::exception_ptr error;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (uint32_t i = 0; i < reads.size(); ++i) {
+        try {
+            const auto& read_nodes = reads[i]->get_nodes();
+            for (uint32_t j = 0; j < read_nodes.size(); ++j) {
+                hashed_node_ids[sequence_starts[i] + j] = node_plus_orientation_to_num(
+                    read_nodes[j].lock()->node_id, reads[i]->node_orientations[j]);
+            }
+        } catch (...) {
+#pragma omp critical(construct_debruijn_graph_error)
+            {
+                if (not error) {
+                    error = std::current_exception();
                 }
-                prev = current;
-                hashed_ids.pop_front();
             }
         }
     }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    dbg.build(read_ids, hashed_node_ids, sequence_starts, threads);
 }
 
 void remove_leaves(std::shared_ptr<pangenome::Graph> pangraph, debruijn::Graph& dbg,
@@ -366,8 +396,81 @@ void remove_middle_nodes_of_tig_from_read(std::shared_ptr<pangenome::Graph> pang
         if (it == r->get_nodes().end()) {
             break;
         }
-        it = pangenome->remove_node_from_read(it, r);
+        // the pangraph nodes are shared by the unitigs filtered in parallel
+        const double wait_start = trace_timestamp();
+#pragma omp critical(pangraph_nodes)
+        {
+            trace_lock_wait("pangraph_nodes", wait_start);
+            it = pangenome->remove_node_from_read(it, r);
+        }
+    }
+}
+
+// Remove the internal nodes of the unitig from the reads if it is covered by too few
+// reads, see filter_unitigs()
+void filter_unitig(std::shared_ptr<pangenome::Graph> pangraph, debruijn::Graph& dbg,
+    std::deque<uint32_t> d, const uint_least32_t& threshold)
+{
+    std::vector<uint_least32_t> node_ids;
+    std::vector<bool> node_orients;
+    std::unordered_set<pangenome::ReadPtr> reads_along_tig;
+    bool all_reads_tig;
+
+    // look up the node ids and orientations associated with this node
+    dbg_node_ids_to_ids_and_orientations(dbg, d, node_ids, node_orients);
+
+    // collect the reads covering that tig
+    find_reads_along_tig(
+        dbg, d, pangraph, node_ids, node_orients, reads_along_tig, all_reads_tig);
+
+    // now if the number of reads covering tig falls below threshold, remove the
+    // middle nodes of this tig from the reads
+    if (reads_along_tig.size() <= threshold) {
+        BOOST_LOG_TRIVIAL(trace)
+            << "not enough reads, so remove the tig from the reads";
+        for (const auto& r : reads_along_tig) {
+            remove_middle_nodes_of_tig_from_read(
+                pangraph, dbg, r, node_ids, node_orients);
+        }
+        // also remove read_ids from each of the corresponding nodes of dbg
+        for (uint32_t i = 1; i < d.size() - 1; ++i) {
+            for (const auto& r : reads_along_tig) {
+                dbg.remove_read_from_node(r->id, d[i]);
+            }
+        }
+    }
+}
+
+// The connected components of the dbg, as the component index of each node id
+std::unordered_map<uint32_t, uint32_t> get_components(
+    const debruijn::Graph& dbg, uint32_t& number_of_components)
+{
+    std::unordered_map<uint32_t, uint32_t> component_of_node;
+    component_of_node.reserve(dbg.nodes.size());
+    number_of_components = 0;
+    std::vector<uint32_t> to_visit;
+    for (const auto& node_entry : dbg.nodes) {
+        if (component_of_node.find(node_entry.first) != component_of_node.end()) {
+            continue;
+        }
+        component_of_node[node_entry.first] = number_of_components;
+        to_visit.push_back(node_entry.first);
+        while (!to_visit.empty()) {
+            const auto& node_ptr = dbg.nodes.at(to_visit.back());
+            to_visit.pop_back();
+            for (const auto& neighbours :
+                { &node_ptr->in_nodes, &node_ptr->out_nodes }) {
+                for (const auto& neighbour : *neighbours) {
+                    if (component_of_node.emplace(neighbour, number_of_components)
+                            .second) {
+                        to_visit.push_back(neighbour);
+                    }
+                }
+            }
+        }
+        ++number_of_components;
     }
+    return component_of_node;
 }
 
 // Remove the internal nodes of low coverage unitigs e.g.
@@ -376,42 +479,115 @@ void remove_middle_nodes_of_tig_from_read(std::shared_ptr<pangenome::Graph> pang
 // then we would remove the 3 internal kmers from the dbg
 // and node 6 from the pg->
 // If the tig is smaller than k+2 long, currently does nothing
+// As a read is a path in the dbg, the reads of a unitig and the dbg nodes they
+// cover all belong to its connected component, so the components are filtered in
+// parallel, each on a dbg of its own nodes, with the same result as filtering the
+// unitigs in turn
 void filter_unitigs(std::shared_ptr<pangenome::Graph> pangraph, debruijn::Graph& dbg,
-    const uint_least32_t& threshold)
+    const uint_least32_t& threshold, const uint32_t threads)
 {
     BOOST_LOG_TRIVIAL(debug) << "Filter unitigs using threshold " << threshold;
-    std::vector<uint_least32_t> node_ids;
-    std::vector<bool> node_orients;
-    std::unordered_set<pangenome::ReadPtr> reads_along_tig;
-    bool all_reads_tig;
-
     std::set<std::deque<uint32_t>> unitigs = dbg.get_unitigs();
     BOOST_LOG_TRIVIAL(debug) << "have " << unitigs.size() << " tigs";
-    for (auto d : unitigs) {
-        // look up the node ids and orientations associated with this node
-        dbg_node_ids_to_ids_and_orientations(dbg, d, node_ids, node_orients);
 
-        // collect the reads covering that tig
-        find_reads_along_tig(
-            dbg, d, pangraph, node_ids, node_orients, reads_along_tig, all_reads_tig);
+    if (threads <= 1) {
+        for (const auto& d : unitigs) {
+            filter_unitig(pangraph, dbg, d, threshold);
+        }
+        return;
+    }
 
-        // now if the number of reads covering tig falls below threshold, remove the
-        // middle nodes of this tig from the reads
-        if (reads_along_tig.size() <= threshold) {
-            BOOST_LOG_TRIVIAL(trace)
-                << "not enough reads, so remove the tig from the reads";
-            for (const auto& r : reads_along_tig) {
-                remove_middle_nodes_of_tig_from_read(
-                    pangraph, dbg, r, node_ids, node_orients);
+    uint32_t number_of_components;
+    const std::unordered_map<uint32_t, uint32_t> component_of_node
+        = get_components(dbg, number_of_components);
+    std::vector<uint32_t> size_of_component(number_of_components, 0);
+    for (const auto& node_entry : component_of_node) {
+        ++size_of_component[node_entry.second];
+    }
+    std::vector<bool> component_has_unitigs(number_of_components, false);
+    for (const auto& d : unitigs) {
+        component_has_unitigs[component_of_node.at(d.front())] = true;
+    }
+
+    // pack the components with unitigs, largest first, into a few bins per thread, each
+    // with a dbg sharing the nodes of its components
+    std::vector<uint32_t> components_by_size;
+    for (uint32_t component = 0; component < number_of_components; ++component) {
+        if (component_has_unitigs[component]) {
+            components_by_size.push_back(component);
+        }
+    }
+    std::sort(components_by_size.begin(), components_by_size.end(),
+        [&](const uint32_t lhs, const uint32_t rhs) {
+            if (size_of_component[lhs] != size_of_component[rhs]) {
+                return size_of_component[lhs] > size_of_component[rhs];
             }
-            // also remove read_ids from each of the corresponding nodes of dbg
-            for (uint32_t i = 1; i < d.size() - 1; ++i) {
-                for (const auto& r : reads_along_tig) {
-                    dbg.remove_read_from_node(r->id, d[i]);
+            return lhs < rhs;
+        });
+    const uint32_t number_of_bins
+        = std::min((uint32_t)components_by_size.size(), threads * 4);
+    std::vector<uint32_t> bin_of_component(number_of_components, 0);
+    std::vector<uint64_t> size_of_bin(number_of_bins, 0);
+    for (const auto& component : components_by_size) {
+        const uint32_t bin = std::min_element(size_of_bin.begin(), size_of_bin.end())
+            - size_of_bin.begin();
+        bin_of_component[component] = bin;
+        size_of_bin[bin] += size_of_component[component];
+    }
+
+    std::vector<std::unique_ptr<debruijn::Graph>> bins;
+    for (uint32_t bin = 0; bin < number_of_bins; ++bin) {
+        bins.emplace_back(new debruijn::Graph(dbg.size));
+        // without the buckets reserved for a whole graph
+        bins.back()->nodes = std::unordered_map<uint32_t, debruijn::NodePtr>();
+        bins.back()->nodes.reserve(size_of_bin[bin]);
+    }
+    for (const auto& node_entry : dbg.nodes) {
+        const uint32_t component = component_of_node.at(node_entry.first);
+        if (component_has_unitigs[component]) {
+            bins[bin_of_component[component]]->nodes.insert(node_entry);
+        }
+    }
+    // the unitigs of a bin keep their order
+    std::vector<std::vector<const std::deque<uint32_t>*>> unitigs_of_bin(
+        number_of_bins);
+    for (const auto& d : unitigs) {
+        unitigs_of_bin[bin_of_component[component_of_node.at(d.front())]].push_back(&d);
+    }
+
+    // exceptions can not leave the parallel region, the first one is rethrown after it
+    std::exception_ptr error;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+    for (uint32_t bin = 0; bin < number_of_bins; ++bin) {
+        TraceSpan span("filter unitigs", "noise filtering");
+        span.add_arg("unitigs", unitigs_of_bin[bin].size());
+        try {
+            for (const auto& d : unitigs_of_bin[bin]) {
+                filter_unitig(pangraph, *bins[bin], *d, threshold);
+            }
+        } catch (...) {
+#pragma omp critical(filter_unitigs_error)
+            {
+                if (not error) {
+                    error = std::current_exception();
                 }
             }
         }
-        reads_along_tig.clear();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    // remove from the dbg the nodes which no read covers anymore
+    for (auto it = dbg.nodes.begin(); it != dbg.nodes.end();) {
+        const uint32_t component = component_of_node.at(it->first);
+        const bool removed = component_has_unitigs[component]
+            and bins[bin_of_component[component]]->nodes.count(it->first) == 0;
+        if (removed) {
+            it = dbg.nodes.erase(it);
+        } else {
+            ++it;
+        }
     }
 }
 
@@ -438,7 +614,8 @@ void detangle_pangraph_with_debruijn_graph(
         if (!all_reads_tig and !reads_along_tig.empty()) {
             for (uint32_t i = 0; i < node_ids.size(); ++i) {
                 for (const auto& r : pangraph->nodes[node_ids[i]]->reads) {
-                    if (reads_along_tig.find(r) == reads_along_tig.end()) {
+                    if (reads_along_tig.find(pangraph->reads.at(r->id))
+                        == reads_along_tig.end()) {
                         pangraph->split_node_by_reads(
                             reads_along_tig, node_ids, node_orients, node_ids[i]);
                         break;
@@ -450,21 +627,22 @@ void detangle_pangraph_with_debruijn_graph(
 }
 
 void clean_pangraph_with_debruijn_graph(std::shared_ptr<pangenome::Graph> pangraph,
-    const uint_least32_t size, const uint_least32_t threshold, const bool illumina)
+    const uint_least32_t size, const uint_least32_t threshold, const bool illumina,
+    const uint32_t threads)
 {
     BOOST_LOG_TRIVIAL(debug) << "Construct de Bruijn Graph from PanGraph with size "
                              << (uint32_t)size;
     debruijn::Graph dbg(size);
-    construct_debruijn_graph(pangraph, dbg);
+    construct_debruijn_graph(pangraph, dbg, threads);
 
     if (not illumina)
         remove_leaves(pangraph, dbg, threshold);
-    filter_unitigs(pangraph, dbg, threshold);
+    filter_unitigs(pangraph, dbg, threshold, threads);
     BOOST_LOG_TRIVIAL(debug) << "Finished filtering tigs";
 
     // update dbg now that have removed leaves and some inner nodes
     BOOST_LOG_TRIVIAL(trace) << "Reconstruct dbg";
-    construct_debruijn_graph(pangraph, dbg);
+    construct_debruijn_graph(pangraph, dbg, threads);
 
     BOOST_LOG_TRIVIAL(trace) << "Now detangle";
     detangle_pangraph_with_debruijn_graph(pangraph, dbg);
@@ -6,6 +6,8 @@ class Node;
 
 class Read;
 
+class NodeReads;
+
 class Sample;
 struct SamplePtrSorterBySampleId;
 
@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <exception>
 #include <boost/filesystem.hpp>
 
 #include "utils.h"
@@ -14,6 +15,7 @@
 #include "pangenome/pansample.h"
 #include "fastaq_handler.h"
 #include "fatal_error.h"
+#include "memory_usage.h"
 
 using namespace pangenome;
 
@@ -75,19 +77,19 @@ void update_node_info_with_this_read(const NodePtr& node_ptr, const ReadPtr& rea
 
 // Checks that all hits in the cluster are from the given prg and read
 void check_correct_hits(const uint32_t prg_id, const uint32_t read_id,
-    const std::set<MinimizerHitPtr, pComp>& cluster)
+    const MinimizerHitIterator& cluster_begin, const MinimizerHitIterator& cluster_end)
 {
-    for (const auto& hit_ptr : cluster) {
-        const bool hits_correspond_to_correct_read = read_id == hit_ptr->get_read_id();
+    for (auto hit = cluster_begin; hit != cluster_end; ++hit) {
+        const bool hits_correspond_to_correct_read = read_id == hit->get_read_id();
         if (!hits_correspond_to_correct_read) {
             fatal_error("Minimizer hits error: hit should be on read id ", read_id,
-                ", but it is on read id ", hit_ptr->get_read_id());
+                ", but it is on read id ", hit->get_read_id());
         }
 
-        const bool hits_correspond_to_correct_prg = prg_id == hit_ptr->get_prg_id();
+        const bool hits_correspond_to_correct_prg = prg_id == hit->get_prg_id();
         if (!hits_correspond_to_correct_prg) {
             fatal_error("Minimizer hits error: hit should be on PRG id ", prg_id,
-                ", but it is on PRG id ", hit_ptr->get_prg_id());
+                ", but it is on PRG id ", hit->get_prg_id());
         }
     }
 }
@@ -97,10 +99,11 @@ void check_correct_hits(const uint32_t prg_id, const uint32_t read_id,
 // as well as its orientation (unless the previous node along
 // the read was the same node and orientation)
 // Store the hits on the read
-void update_read_info_with_node_and_cluster(ReadPtr& read_ptr, const NodePtr& node_ptr,
-    const std::set<MinimizerHitPtr, pComp>& cluster)
+void update_read_info_with_node_and_cluster(const ReadPtr& read_ptr,
+    const NodePtr& node_ptr, const MinimizerHitIterator& cluster_begin,
+    const MinimizerHitIterator& cluster_end)
 {
-    read_ptr->add_hits(node_ptr, cluster);
+    read_ptr->add_hits(node_ptr, cluster_begin, cluster_end);
 }
 
 void pangenome::Graph::add_hits_between_PRG_and_read(
@@ -111,20 +114,38 @@ void pangenome::Graph::add_hits_between_PRG_and_read(
     std::set<MinimizerHitPtr, pComp>& cluster // the cluster itself
 )
 {
-    check_correct_hits(prg->id, read_id,
-        cluster); // assure this cluster corresponds to the given prg and read
+    std::vector<MinimizerHit> cluster_hits;
+    cluster_hits.reserve(cluster.size());
+    for (const auto& hit_ptr : cluster) {
+        cluster_hits.push_back(*hit_ptr);
+    }
+    add_hits_between_PRG_and_read(
+        prg, read_id, cluster_hits.begin(), cluster_hits.end());
+}
+
+void pangenome::Graph::add_hits_between_PRG_and_read(
+    const std::shared_ptr<LocalPRG>&
+        prg, // the prg from where this cluster of hits come
+    const uint32_t read_id, // the read id from where this cluster of reads come
+    const MinimizerHitIterator& cluster_begin, // the cluster itself, as a range of
+    const MinimizerHitIterator& cluster_end // sorted hits
+)
+{
+    check_correct_hits(prg->id, read_id, cluster_begin,
+        cluster_end); // assure this cluster corresponds to the given prg and read
 
-    // add and get the new read
+    // add and get the new read (by reference, to not update its reference count)
     add_read(read_id);
-    auto read_ptr = get_read(read_id);
+    const ReadPtr& read_ptr = get_read(read_id);
 
     // add and get the new node
     add_node(prg);
-    auto node_ptr = get_node(prg);
+    const NodePtr& node_ptr = get_node(prg);
 
     // update the info
     update_node_info_with_this_read(node_ptr, read_ptr);
-    update_read_info_with_node_and_cluster(read_ptr, node_ptr, cluster);
+    update_read_info_with_node_and_cluster(
+        read_ptr, node_ptr, cluster_begin, cluster_end);
 }
 
 // TODO: this should be a method of class Sample
@@ -150,7 +171,7 @@ void pangenome::Graph::add_hits_between_PRG_and_sample(
 }
 
 // Remove the node n, and all references to it
-std::unordered_map<uint32_t, NodePtr>::iterator pangenome::Graph::remove_node(NodePtr n)
+DenseIdMap<NodePtr>::iterator pangenome::Graph::remove_node(NodePtr n)
 {
     // removes all instances of node n and references to it in reads
     for (const auto& r : n->reads) {
@@ -242,7 +263,7 @@ void pangenome::Graph::split_node_by_reads(std::unordered_set<ReadPtr>& reads_al
     nodes[next_id] = n;
 
     // switch old node to new node in reads
-    std::unordered_multiset<ReadPtr>::iterator rit;
+    NodeReads::iterator rit;
     std::pair<uint32_t, uint32_t> pos;
     for (const auto& r : reads_along_tig) {
         // ignore if this node does not contain this read
@@ -267,6 +288,7 @@ void pangenome::Graph::split_node_by_reads(std::unordered_set<ReadPtr>& reads_al
             n->covg += 1;
         }
     }
+    n->reads.sort_by_id();
 
     // replace node in tig
     for (uint32_t i = 0; i < node_ids.size(); ++i) {
@@ -277,69 +299,155 @@ void pangenome::Graph::split_node_by_reads(std::unordered_set<ReadPtr>& reads_al
     }
 }
 
-// For each node in pangraph, make a copy of the kmergraph and use the hits
-// stored on each read containing the node to add coverage to this graph
-void pangenome::Graph::add_hits_to_kmergraphs(const uint32_t& sample_id)
-{
-    for (const auto& node_entries : nodes) {
-        Node& pangraph_node = *node_entries.second;
-        const bool pangraph_node_has_a_valid_kmer_prg_with_coverage
-            = (pangraph_node.kmer_prg_with_coverage.kmer_prg != nullptr)
-            and (not pangraph_node.kmer_prg_with_coverage.kmer_prg->nodes.empty());
-        if (!pangraph_node_has_a_valid_kmer_prg_with_coverage) {
-            fatal_error(
-                "Error adding hits to kmer graph: pangraph node does not have a "
-                "valid Kmer PRG with coverage");
+void check_kmer_prg_with_coverage_is_valid(const pangenome::Node& pangraph_node)
+{
+    const bool pangraph_node_has_a_valid_kmer_prg_with_coverage
+        = (pangraph_node.kmer_prg_with_coverage.kmer_prg != nullptr)
+        and (not pangraph_node.kmer_prg_with_coverage.kmer_prg->nodes.empty());
+    if (!pangraph_node_has_a_valid_kmer_prg_with_coverage) {
+        fatal_error("Error adding hits to kmer graph: pangraph node does not have a "
+                    "valid Kmer PRG with coverage");
+    }
+}
+
+// Adds the coverage of the given hits to the kmergraph of the node, counting the hits
+// added in each direction in num_hits
+void add_hits_coverage_to_kmergraph(pangenome::Node& pangraph_node,
+    const MinimizerHitIterator& hits_begin, const MinimizerHitIterator& hits_end,
+    const uint32_t sample_id, uint32_t (&num_hits)[2])
+{
+    for (auto hit_it = hits_begin; hit_it != hits_end; ++hit_it) {
+        const MinimizerHit& minimizer_hit = *hit_it;
+
+        const bool minimizer_hit_kmer_node_id_is_valid
+            = (minimizer_hit.get_kmer_node_id()
+                  < pangraph_node.kmer_prg_with_coverage.kmer_prg->nodes.size())
+            && (pangraph_node.kmer_prg_with_coverage.kmer_prg
+                    ->nodes[minimizer_hit.get_kmer_node_id()]
+                != nullptr);
+        if (!minimizer_hit_kmer_node_id_is_valid) {
+            fatal_error("Error adding hits to kmer graph: minimizer hit "
+                        "kmer node is invalid");
         }
-        uint32_t num_hits[2] = { 0, 0 };
 
-        // add hits
-        for (const auto& read_ptr : pangraph_node.reads) {
-            const Read& read = *read_ptr;
+        if (minimizer_hit.is_forward()) {
+            pangraph_node.kmer_prg_with_coverage.increment_forward_covg(
+                minimizer_hit.get_kmer_node_id(), sample_id);
+        } else {
+            pangraph_node.kmer_prg_with_coverage.increment_reverse_covg(
+                minimizer_hit.get_kmer_node_id(), sample_id);
+        }
 
-            auto hits = read.get_hits_as_unordered_map();
-            for (const auto& minimizer_hit_ptr : hits.at(pangraph_node.prg_id)) {
-                const auto& minimizer_hit = *minimizer_hit_ptr;
+        const auto covg { minimizer_hit.is_forward()
+                ? pangraph_node.kmer_prg_with_coverage.get_forward_covg(
+                    minimizer_hit.get_kmer_node_id(), sample_id)
+                : pangraph_node.kmer_prg_with_coverage.get_reverse_covg(
+                    minimizer_hit.get_kmer_node_id(), sample_id) };
+        if (covg == 1000) {
+            BOOST_LOG_TRIVIAL(debug) << "Adding hit " << minimizer_hit
+                                     << " resulted in high coverage on node "
+                                     << *pangraph_node.kmer_prg_with_coverage.kmer_prg
+                                             ->nodes[minimizer_hit.get_kmer_node_id()];
+        }
+        num_hits[minimizer_hit.is_forward()] += 1;
+    }
+}
 
-                const bool minimizer_hit_kmer_node_id_is_valid
-                    = (minimizer_hit.get_kmer_node_id()
-                          < pangraph_node.kmer_prg_with_coverage.kmer_prg->nodes.size())
-                    && (pangraph_node.kmer_prg_with_coverage.kmer_prg
-                            ->nodes[minimizer_hit.get_kmer_node_id()]
-                        != nullptr);
-                if (!minimizer_hit_kmer_node_id_is_valid) {
-                    fatal_error("Error adding hits to kmer graph: minimizer hit "
-                                "kmer node is invalid");
-                }
+// Uses the hits stored on each read containing the node to add coverage to the
+// kmergraph of the node
+void add_hits_to_kmergraph(pangenome::Node& pangraph_node, const uint32_t sample_id)
+{
+    check_kmer_prg_with_coverage_is_valid(pangraph_node);
+    uint32_t num_hits[2] = { 0, 0 };
+
+    // add hits
+    for (const auto& read_ptr : pangraph_node.reads) {
+        const auto hits = read_ptr->get_hits_of_node(pangraph_node.prg_id);
+        add_hits_coverage_to_kmergraph(
+            pangraph_node, hits.first, hits.second, sample_id, num_hits);
+    }
 
-                if (minimizer_hit.is_forward()) {
-                    pangraph_node.kmer_prg_with_coverage.increment_forward_covg(
-                        minimizer_hit.get_kmer_node_id(), sample_id);
-                } else {
-                    pangraph_node.kmer_prg_with_coverage.increment_reverse_covg(
-                        minimizer_hit.get_kmer_node_id(), sample_id);
-                }
+    BOOST_LOG_TRIVIAL(debug)
+        << "Added " << num_hits[1] << " hits in the forward direction and "
+        << num_hits[0] << " hits in the reverse";
+    pangraph_node.kmer_prg_with_coverage.set_num_reads(pangraph_node.covg);
+}
 
-                const auto covg { minimizer_hit.is_forward()
-                        ? pangraph_node.kmer_prg_with_coverage.get_forward_covg(
-                            minimizer_hit.get_kmer_node_id(), sample_id)
-                        : pangraph_node.kmer_prg_with_coverage.get_reverse_covg(
-                            minimizer_hit.get_kmer_node_id(), sample_id) };
-                if (covg == 1000) {
-                    BOOST_LOG_TRIVIAL(debug)
-                        << "Adding hit " << minimizer_hit
-                        << " resulted in high coverage on node "
-                        << *pangraph_node.kmer_prg_with_coverage.kmer_prg
-                                ->nodes[minimizer_hit.get_kmer_node_id()];
+void pangenome::Graph::add_coverage_between_PRG_and_read(
+    const std::shared_ptr<LocalPRG>& prg, const uint32_t read_id,
+    const MinimizerHitIterator& hits_begin, const MinimizerHitIterator& hits_end,
+    const uint32_t number_of_copies)
+{
+    check_correct_hits(prg->id, read_id, hits_begin, hits_end);
+
+    add_node(prg);
+    auto node_ptr = get_node(prg);
+    check_kmer_prg_with_coverage_is_valid(*node_ptr);
+
+    // the read is only counted, it is neither stored in the graph nor in the node
+    node_ptr->covg += number_of_copies;
+    node_ptr->kmer_prg_with_coverage.set_num_reads(node_ptr->covg);
+    uint32_t num_hits[2] = { 0, 0 };
+    for (uint32_t copy = 0; copy < number_of_copies; ++copy) {
+        add_hits_coverage_to_kmergraph(*node_ptr, hits_begin, hits_end, 0, num_hits);
+    }
+}
+
+void pangenome::Graph::sort_node_reads(const uint32_t threads)
+{
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (uint32_t node_id = 0; node_id < nodes.id_bound(); ++node_id) {
+        if (nodes.contains(node_id)) {
+            nodes.at(node_id)->reads.sort_by_id();
+        }
+    }
+}
+
+// For each node in pangraph, make a copy of the kmergraph and use the hits
+// stored on each read containing the node to add coverage to this graph
+void pangenome::Graph::add_hits_to_kmergraphs(
+    const uint32_t& sample_id, const uint32_t threads)
+{
+    // each node only updates its own kmergraph, so nodes are processed in parallel.
+    // Nodes with the most hits are scheduled first, so that a few big loci do not end
+    // up being processed last by a single thread
+    std::vector<std::pair<uint64_t, Node*>> nodes_by_number_of_hits;
+    nodes_by_number_of_hits.reserve(nodes.size());
+    for (const auto& node_entry : nodes) {
+        Node& pangraph_node = *node_entry.second;
+        uint64_t number_of_hits { 0 };
+        for (const auto& read_ptr : pangraph_node.reads) {
+            const auto hits = read_ptr->get_hits_of_node(pangraph_node.prg_id);
+            number_of_hits += hits.second - hits.first;
+        }
+        nodes_by_number_of_hits.emplace_back(number_of_hits, &pangraph_node);
+    }
+    std::sort(nodes_by_number_of_hits.begin(), nodes_by_number_of_hits.end(),
+        [](const std::pair<uint64_t, Node*>& lhs,
+            const std::pair<uint64_t, Node*>& rhs) {
+            if (lhs.first != rhs.first) {
+                return lhs.first > rhs.first;
+            }
+            return lhs.second->node_id < rhs.second->node_id;
+        });
+
+    // exceptions can not leave the parallel region, the first one is rethrown after it
+    std::exception_ptr error;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+    for (uint32_t i = 0; i < nodes_by_number_of_hits.size(); ++i) {
+        try {
+            add_hits_to_kmergraph(*nodes_by_number_of_hits[i].second, sample_id);
+        } catch (...) {
+#pragma omp critical(add_hits_to_kmergraphs_error)
+            {
+                if (not error) {
+                    error = std::current_exception();
                 }
-                num_hits[minimizer_hit.is_forward()] += 1;
             }
         }
-
-        BOOST_LOG_TRIVIAL(debug)
-            << "Added " << num_hits[1] << " hits in the forward direction and "
-            << num_hits[0] << " hits in the reverse";
-        pangraph_node.kmer_prg_with_coverage.set_num_reads(pangraph_node.covg);
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
 }
 
@@ -485,6 +593,37 @@ bool pangenome::Graph::operator==(const Graph& y) const
     return true;
 }
 
+uint64_t pangenome::Graph::estimate_reads_memory_usage() const
+{
+    uint64_t bytes = estimate_tree_heap_memory_usage(reads);
+    for (const auto& read_entry : reads) {
+        bytes += shared_ptr_control_block_bytes + sizeof(Read)
+            + read_entry.second->estimate_heap_memory_usage();
+    }
+    return bytes;
+}
+
+uint64_t pangenome::Graph::estimate_nodes_memory_usage() const
+{
+    uint64_t bytes = nodes.estimate_heap_memory_usage();
+    for (const auto& node_entry : nodes) {
+        const NodePtr& node = node_entry.second;
+        bytes += shared_ptr_control_block_bytes + sizeof(Node)
+            + node->reads.estimate_heap_memory_usage()
+            + estimate_tree_heap_memory_usage(node->samples);
+    }
+    return bytes;
+}
+
+uint64_t pangenome::Graph::estimate_kmer_graph_coverages_memory_usage() const
+{
+    uint64_t bytes = 0;
+    for (const auto& node_entry : nodes) {
+        bytes += node_entry.second->kmer_prg_with_coverage.estimate_heap_memory_usage();
+    }
+    return bytes;
+}
+
 bool pangenome::Graph::operator!=(const Graph& y) const { return !(*this == y); }
 
 // Saves a presence/absence/copynumber matrix for each node and each sample
@@ -519,10 +658,18 @@ void pangenome::Graph::save_matrix(
 
 void pangenome::Graph::save_mapped_read_strings(
     const fs::path& readfilepath, const fs::path& outdir, const int32_t buff)
+{
+    save_mapped_read_strings(
+        std::vector<std::string> { readfilepath.string() }, outdir, buff);
+}
+
+void pangenome::Graph::save_mapped_read_strings(
+    const std::vector<std::string>& readfilepaths, const fs::path& outdir,
+    const int32_t buff)
 {
     BOOST_LOG_TRIVIAL(debug) << "Save mapped read strings and coordinates";
     fs::ofstream outhandle;
-    FastaqHandler readfile(readfilepath.string());
+    FastaqHandler readfile(readfilepaths);
     uint32_t start, end;
 
     // for each node in pangraph, find overlaps and write to a file
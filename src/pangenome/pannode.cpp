@@ -10,6 +10,69 @@
 
 using namespace pangenome;
 
+void pangenome::NodeReads::insert(Read* read)
+{
+    sorted = sorted and (reads.empty() or reads.back()->id <= read->id);
+    reads.push_back(read);
+}
+
+void pangenome::NodeReads::sort_by_id()
+{
+    if (not sorted) {
+        std::stable_sort(reads.begin(), reads.end(),
+            [](const Read* lhs, const Read* rhs) { return lhs->id < rhs->id; });
+        sorted = true;
+    }
+}
+
+std::pair<NodeReads::const_iterator, NodeReads::const_iterator>
+pangenome::NodeReads::sorted_copies(const Read* read) const
+{
+    return std::equal_range(reads.cbegin(), reads.cend(), read,
+        [](const Read* lhs, const Read* rhs) { return lhs->id < rhs->id; });
+}
+
+NodeReads::const_iterator pangenome::NodeReads::find(const Read* read) const
+{
+    if (not sorted) {
+        return std::find_if(reads.cbegin(), reads.cend(),
+            [read](const Read* other) { return other->id == read->id; });
+    }
+    const auto copies = sorted_copies(read);
+    return copies.first != copies.second ? copies.first : reads.cend();
+}
+
+NodeReads::iterator pangenome::NodeReads::find(const Read* read)
+{
+    const auto it = static_cast<const NodeReads&>(*this).find(read);
+    return reads.begin() + (it - reads.cbegin());
+}
+
+size_t pangenome::NodeReads::count(const Read* read) const
+{
+    if (not sorted) {
+        return std::count_if(reads.cbegin(), reads.cend(),
+            [read](const Read* other) { return other->id == read->id; });
+    }
+    const auto copies = sorted_copies(read);
+    return copies.second - copies.first;
+}
+
+size_t pangenome::NodeReads::erase(const ReadPtr& read)
+{
+    // removing reads keeps the others in order
+    const size_t size_before = reads.size();
+    if (not sorted) {
+        reads.erase(std::remove_if(reads.begin(), reads.end(),
+                        [&read](const Read* other) { return other->id == read->id; }),
+            reads.end());
+    } else {
+        const auto copies = sorted_copies(read.get());
+        reads.erase(copies.first, copies.second);
+    }
+    return size_before - reads.size();
+}
+
 // constructors
 pangenome::Node::Node(const std::shared_ptr<LocalPRG>& prg)
     : Node(prg, prg->id)
@@ -64,7 +127,7 @@ Node& Node::operator=(const Node& other)
 void pangenome::Node::remove_read(ReadPtr r)
 {
     // removes single copy of read
-    auto it = find(reads.begin(), reads.end(), r);
+    auto it = reads.find(r);
     if (it != reads.end()) {
         covg -= 1;
         reads.erase(it);
@@ -106,17 +169,17 @@ void pangenome::Node::get_read_overlap_coordinates(
     auto read_count = 0;
     for (const auto& read_ptr : reads) {
         read_count++;
-        auto hits = read_ptr->get_hits_as_unordered_map();
-        if (hits.at(prg_id).size() < 2)
+        const auto hits = read_ptr->get_hits_of_node(prg_id);
+        if (hits.second - hits.first < 2)
             continue;
 
-        auto hit_ptr_iter = hits.at(prg_id).begin();
-        uint32_t start = (*hit_ptr_iter)->get_read_start_position();
+        const auto hit_iter = hits.first;
+        uint32_t start = hit_iter->get_read_start_position();
         uint32_t end = 0;
-        for (const auto& hit_ptr : hits.at(prg_id)) {
-            start = std::min(start, hit_ptr->get_read_start_position());
-            end = std::max(end,
-                hit_ptr->get_read_start_position() + hit_ptr->get_prg_path().length());
+        for (auto hit = hits.first; hit != hits.second; ++hit) {
+            start = std::min(start, hit->get_read_start_position());
+            end = std::max(
+                end, hit->get_read_start_position() + hit->get_prg_path().length());
         }
 
         const bool read_coordinates_are_valid = end > start;
@@ -126,7 +189,7 @@ void pangenome::Node::get_read_overlap_coordinates(
                 "th on this node). Found end ", end, " after found start ", start);
         }
 
-        coordinate = { read_ptr->id, start, end, (*hit_ptr_iter)->is_forward() };
+        coordinate = { read_ptr->id, start, end, hit_iter->is_forward() };
         read_overlap_coordinates.push_back(coordinate);
     }
 
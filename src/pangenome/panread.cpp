@@ -7,21 +7,21 @@
 #include "pangenome/panread.h"
 #include "pangenome/pannode.h"
 #include "minihits.h"
+#include "memory_usage.h"
 
 using namespace pangenome;
 
 Read::Read(const uint32_t i)
     : id(i)
-    , hits(0)
     , node_orientations(0)
     , nodes(0)
 {
 }
 
-Read::~Read()
+uint64_t Read::estimate_heap_memory_usage() const
 {
-    for (MinimizerHit* minihit : hits)
-        delete minihit;
+    return ::estimate_heap_memory_usage(hits) + ::estimate_heap_memory_usage(nodes)
+        + node_orientations.capacity() / 8;
 }
 
 std::vector<WeakNodePtr>::iterator Read::find_node_by_id(uint32_t node_id)
@@ -35,30 +35,40 @@ std::vector<WeakNodePtr>::iterator Read::find_node_by_id(uint32_t node_id)
 void Read::add_hits(
     const NodePtr& node_ptr, const std::set<MinimizerHitPtr, pComp>& cluster)
 {
-    // TODO: review this method...
-    auto before_size = hits.size();
-
+    std::vector<MinimizerHit> cluster_hits;
+    cluster_hits.reserve(cluster.size());
     for (const auto& clusterHitSmrtPointer : cluster)
-        hits.push_back(new MinimizerHit(*clusterHitSmrtPointer));
-    std::sort(hits.begin(), hits.end(),
-        [](const MinimizerHit* const lhs, const MinimizerHit* const rhs) {
-            return (*lhs) < (*rhs);
-        }); // TODO: might not need this...
-    auto last = std::unique(hits.begin(), hits.end(),
-        [](const MinimizerHit* const lhs, const MinimizerHit* const rhs) {
-            return (*lhs) == (*rhs);
-        });
-    hits.erase(last, hits.end());
-    hits.shrink_to_fit();
+        cluster_hits.push_back(*clusterHitSmrtPointer);
+    add_hits(node_ptr, cluster_hits.begin(), cluster_hits.end());
+}
+
+void Read::add_hits(const NodePtr& node_ptr, const MinimizerHitIterator& cluster_begin,
+    const MinimizerHitIterator& cluster_end)
+{
+    const auto before_size = hits.size();
+    const auto cluster_size = cluster_end - cluster_begin;
+
+    // the hits of a read are kept sorted: sort the new hits, and merge them with the
+    // previous ones only if they do not simply go after them, which is the common case
+    // as clusters are added in order of PRG id
+    hits.insert(hits.end(), cluster_begin, cluster_end);
+    const auto new_hits_begin = hits.begin() + before_size;
+    std::sort(new_hits_begin, hits.end());
+    if (before_size > 0 and new_hits_begin != hits.end()
+        and *new_hits_begin < *(new_hits_begin - 1)) {
+        std::inplace_merge(hits.begin(), new_hits_begin, hits.end());
+    }
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
 
     const bool hits_were_correctly_inserted
-        = hits.size() == before_size + cluster.size();
+        = hits.size() == before_size + cluster_size;
     if (!hits_were_correctly_inserted) {
         fatal_error("Error when adding hits to Pangraph read");
     }
 
     // add the orientation/node accordingly
-    const bool orientation = !cluster.empty() and (*cluster.begin())->is_forward();
+    const bool orientation
+        = cluster_begin != cluster_end and cluster_begin->is_forward();
     if (get_nodes().empty() or node_ptr != get_nodes().back().lock()
         or orientation != node_orientations.back()
         // or we think there really are 2 copies of gene
@@ -74,10 +84,10 @@ Read::get_hits_as_unordered_map() const
     std::unordered_map<uint32_t, std::vector<MinimizerHitPtr>>
         hitsMap; // this will map node_ids from the pangenome::Graph to their minimizer
                  // hits
-    for (const MinimizerHit* const minihit : hits) {
+    for (const MinimizerHit& minihit : hits) {
         // gets the nodeId
-        uint32_t nodeId = minihit->get_prg_id(); // prg_id == node_id in
-                                                 // pangenome::Graph
+        uint32_t nodeId = minihit.get_prg_id(); // prg_id == node_id in
+                                                // pangenome::Graph
 
         // checks if we have an entry for this nodeId in hitsMap
         if (hitsMap.find(nodeId) == hitsMap.end())
@@ -86,8 +96,8 @@ Read::get_hits_as_unordered_map() const
 
         // add this minihit to hitsMap
         hitsMap[nodeId].push_back(std::make_shared<MinimizerHit>(
-            *minihit)); // TODO: I think here we don't really need to create a shared
-                        // pointer - a raw pointer is fine
+            minihit)); // TODO: I think here we don't really need to create a shared
+                       // pointer - a raw pointer is fine
     }
 
     // add empty hits if we have them - for backwards compatibility
@@ -100,6 +110,22 @@ Read::get_hits_as_unordered_map() const
     return hitsMap;
 }
 
+std::pair<MinimizerHitIterator, MinimizerHitIterator> Read::get_hits_of_node(
+    const uint32_t node_id) const
+{
+    // hits all have the same read id, so they are sorted first by prg id, which is
+    // the node id in pangenome::Graph
+    const auto begin = std::lower_bound(hits.cbegin(), hits.cend(), node_id,
+        [](const MinimizerHit& hit, const uint32_t id) {
+            return hit.get_prg_id() < id;
+        });
+    const auto end = std::upper_bound(
+        begin, hits.cend(), node_id, [](const uint32_t id, const MinimizerHit& hit) {
+            return id < hit.get_prg_id();
+        });
+    return std::make_pair(begin, end);
+}
+
 // find the index i in the nodes and node_orientations vectors such that [i,i+v.size()]
 // corresponds to these vectors of nodes or some vector overlapping end of read
 // NB will find the first such instance if there is more than one
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include "read_batch.h"
+
+void ReadBatch::add(const uint32_t id, const char* name, const size_t name_length,
+    const char* sequence, const size_t sequence_length)
+{
+    records.push_back({ id, names.size(), (uint32_t)name_length, sequences.size(),
+        sequence_length });
+    names.append(name, name_length);
+    sequences.append(sequence, sequence_length);
+}
+
+void ReadBatch::clear()
+{
+    names.clear();
+    sequences.clear();
+    records.clear();
+}
+
+constexpr uint64_t ReadBatchSizer::default_initial_nb_bases;
+constexpr uint64_t ReadBatchSizer::default_min_nb_bases;
+constexpr uint64_t ReadBatchSizer::default_max_nb_bases;
+constexpr double ReadBatchSizer::default_target_seconds_per_batch;
+
+ReadBatchSizer::ReadBatchSizer(const uint64_t initial_nb_bases,
+    const uint64_t min_nb_bases, const uint64_t max_nb_bases,
+    const double target_seconds_per_batch)
+    : min_nb_bases { min_nb_bases }
+    , max_nb_bases { std::max(min_nb_bases, max_nb_bases) }
+    , target_seconds_per_batch { target_seconds_per_batch }
+    , nb_bases { std::min(std::max(initial_nb_bases, min_nb_bases),
+          std::max(min_nb_bases, max_nb_bases)) }
+{
+}
+
+void ReadBatchSizer::update(
+    const uint64_t nb_bases_processed, const double seconds_taken)
+{
+    const bool no_feedback = nb_bases_processed == 0 or seconds_taken <= 0;
+    if (no_feedback) {
+        return;
+    }
+
+    const double bases_per_second = nb_bases_processed / seconds_taken;
+    const double ideal_nb_bases = bases_per_second * target_seconds_per_batch;
+
+    // move halfway towards the ideal size, so that a single odd batch (e.g. one with a
+    // pathological read) does not make the size oscillate
+    const double smoothed_nb_bases = (nb_bases + ideal_nb_bases) / 2;
+    nb_bases = std::min(
+        std::max((uint64_t)smoothed_nb_bases, min_nb_bases), max_nb_bases);
+}
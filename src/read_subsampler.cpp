@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include "read_subsampler.h"
+#include "fastaq_handler.h"
+#include "inthash.h"
+
+ReadSubsampler::ReadSubsampler(const double fraction)
+    : fraction(std::max(0.0, std::min(fraction, 1.0)))
+    , max_kept_hash(0)
+    , keep_all(this->fraction >= 1.0)
+{
+    if (not keep_all) {
+        // keep reads whose hash, seen as a fraction of 2^64, is below the fraction
+        const double max_kept_hash_as_double = std::ldexp(this->fraction, 64);
+        max_kept_hash = max_kept_hash_as_double >= std::ldexp(1.0, 64)
+            ? std::numeric_limits<uint64_t>::max()
+            : (uint64_t)max_kept_hash_as_double;
+    }
+}
+
+double ReadSubsampler::fraction_for_target_covg(const uint64_t total_nb_bases,
+    const uint32_t genome_size, const uint32_t target_covg)
+{
+    const double target_nb_bases = (double)target_covg * genome_size;
+    if (total_nb_bases == 0 or (double)total_nb_bases <= target_nb_bases) {
+        return 1.0;
+    }
+    return target_nb_bases / total_nb_bases;
+}
+
+uint64_t ReadSubsampler::estimate_number_of_bases(
+    const std::vector<std::string>& filepaths, const uint64_t prefix_nb_bases)
+{
+    double nb_bases { 0 };
+    for (const auto& filepath : filepaths) {
+        const uint64_t file_size = boost::filesystem::file_size(filepath);
+
+        FastaqHandler fh(filepath);
+        uint64_t prefix_bases { 0 };
+        bool whole_file_read { false };
+        while (prefix_bases < prefix_nb_bases) {
+            try {
+                fh.get_next();
+            } catch (std::out_of_range& err) {
+                whole_file_read = true;
+                break;
+            }
+            prefix_bases += fh.read.length();
+        }
+        whole_file_read = whole_file_read or fh.eof();
+
+        // the bytes of the file read for the prefix, compressed or not, including
+        // what zlib buffered ahead, which slightly underestimates the file
+        const int64_t prefix_file_bytes = gzoffset(fh.fastaq_file);
+        if (whole_file_read or prefix_file_bytes <= 0) {
+            nb_bases += prefix_bases;
+        } else {
+            nb_bases += (double)prefix_bases * file_size / prefix_file_bytes;
+        }
+    }
+    return (uint64_t)nb_bases;
+}
+
+bool ReadSubsampler::keep(const boost::string_view read_name) const
+{
+    if (keep_all) {
+        return true;
+    }
+
+    // FNV-1a over the name, then mixed, as FNV alone is poorly distributed in its
+    // high bits for short, similar names (e.g. read1, read2, ...)
+    uint64_t name_hash { 14695981039346656037ULL };
+    for (const char c : read_name) {
+        name_hash ^= (unsigned char)c;
+        name_hash *= 1099511628211ULL;
+    }
+    return hash64(name_hash, std::numeric_limits<uint64_t>::max()) < max_kept_hash;
+}
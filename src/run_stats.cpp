@@ -0,0 +1,298 @@
+#include <iomanip>
+#include <sys/resource.h>
+#include <boost/filesystem/fstream.hpp>
+#include "run_stats.h"
+#include "trace.h"
+#include "fatal_error.h"
+
+double get_cpu_seconds()
+{
+    double cpu_seconds = 0;
+    for (const int who : { RUSAGE_SELF, RUSAGE_CHILDREN }) {
+        struct rusage usage;
+        if (getrusage(who, &usage) == 0) {
+            cpu_seconds += usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        }
+    }
+    return cpu_seconds;
+}
+
+uint64_t get_peak_rss_bytes()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss; // in bytes on macOS
+#else
+    return (uint64_t)usage.ru_maxrss * 1024; // in kilobytes on Linux
+#endif
+}
+
+// writes the given string as a JSON string
+void write_json_string(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (const char c : str) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c
+                    << std::dec << std::setfill(' ');
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    for (uint32_t bucket = 0; bucket < number_of_buckets; ++bucket) {
+        bucket_counts[bucket] += other.bucket_counts[bucket];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+// writes the histogram as a JSON object, with only its non-empty buckets
+void write_histogram(std::ostream& out, const Histogram& histogram,
+    const std::string& pad)
+{
+    out << "{\n" << pad << "  \"count\": " << histogram.get_count() << ",\n";
+    out << pad << "  \"mean\": " << histogram.get_mean() << ",\n";
+    out << pad << "  \"max\": " << histogram.get_max() << ",\n";
+    out << pad << "  \"buckets\": [";
+    bool first_bucket = true;
+    for (uint32_t bucket = 0; bucket < Histogram::number_of_buckets; ++bucket) {
+        if (histogram.get_bucket_count(bucket) == 0) {
+            continue;
+        }
+        out << (first_bucket ? "\n" : ",\n") << pad << "    {\"min\": "
+            << Histogram::bucket_min(bucket)
+            << ", \"max\": " << Histogram::bucket_max(bucket)
+            << ", \"count\": " << histogram.get_bucket_count(bucket) << "}";
+        first_bucket = false;
+    }
+    out << (first_bucket ? "" : "\n" + pad + "  ") << "]\n" << pad << "}";
+}
+
+RunStats::RunStats(const std::string& command)
+    : command(command)
+    , start_time(std::chrono::steady_clock::now())
+    , start_cpu_seconds(get_cpu_seconds())
+{
+}
+
+size_t RunStats::start_phase(const std::string& name)
+{
+    const size_t phase_index = phases.size();
+    if (open_phases.empty()) {
+        top_level_phases.push_back(phase_index);
+    } else {
+        phases[open_phases.back()].subphases.push_back(phase_index);
+    }
+    open_phases.push_back(phase_index);
+
+    Phase phase;
+    phase.name = name;
+    phase.start_time = std::chrono::steady_clock::now();
+    phase.start_cpu_seconds = get_cpu_seconds();
+    phase.start_trace_us = trace_timestamp();
+    phases.push_back(std::move(phase));
+    return phase_index;
+}
+
+void RunStats::end_phase()
+{
+    if (open_phases.empty()) {
+        fatal_error("Error when timing the run: ending a phase while none is started");
+    }
+    end_innermost_phase();
+}
+
+void RunStats::end_phase(const size_t phase_index)
+{
+    if (std::find(open_phases.begin(), open_phases.end(), phase_index)
+        == open_phases.end()) {
+        return;
+    }
+    while (open_phases.back() != phase_index) {
+        end_innermost_phase();
+    }
+    end_innermost_phase();
+}
+
+void RunStats::end_innermost_phase()
+{
+    Phase& phase = phases[open_phases.back()];
+    open_phases.pop_back();
+
+    const std::chrono::duration<double> wall_time
+        = std::chrono::steady_clock::now() - phase.start_time;
+    phase.wall_seconds = wall_time.count();
+    phase.cpu_seconds = get_cpu_seconds() - phase.start_cpu_seconds;
+    phase.process_peak_rss_bytes = get_peak_rss_bytes();
+    phase.memory_bytes = get_memory_breakdown();
+
+    Tracer* tracer = get_run_tracer();
+    if (tracer) {
+        tracer->add_span(phase.name, "phase", phase.start_trace_us, tracer->now());
+    }
+
+    if (memory_report_requested()) {
+        log_memory_breakdown("after " + phase.name, phase.memory_bytes);
+    }
+}
+
+void RunStats::track_memory(
+    const std::string& name, std::function<uint64_t()> estimator)
+{
+    untrack_memory(name);
+    memory_estimators.emplace_back(name, std::move(estimator));
+}
+
+void RunStats::untrack_memory(const std::string& name)
+{
+    for (auto it = memory_estimators.begin(); it != memory_estimators.end(); ++it) {
+        if (it->first == name) {
+            memory_estimators.erase(it);
+            return;
+        }
+    }
+}
+
+MemoryBreakdown RunStats::get_memory_breakdown() const
+{
+    MemoryBreakdown breakdown;
+    for (const auto& name_and_estimator : memory_estimators) {
+        breakdown.emplace_back(name_and_estimator.first, name_and_estimator.second());
+    }
+    return breakdown;
+}
+
+void RunStats::add_count(const std::string& item, const uint64_t count)
+{
+    if (open_phases.empty()) {
+        fatal_error("Error when timing the run: counting ", item,
+            " while no phase is started");
+    }
+    phases[open_phases.back()].counts.emplace_back(item, count);
+}
+
+void RunStats::add_histogram(const std::string& name, const Histogram& histogram)
+{
+    if (open_phases.empty()) {
+        fatal_error("Error when timing the run: adding the histogram of ", name,
+            " while no phase is started");
+    }
+    phases[open_phases.back()].histograms.emplace_back(name, histogram);
+}
+
+void RunStats::write_phase(
+    std::ostream& out, const size_t phase_index, const uint32_t indent) const
+{
+    const Phase& phase = phases[phase_index];
+    const std::string pad(indent, ' ');
+    out << pad << "{\n";
+    out << pad << "  \"name\": ";
+    write_json_string(out, phase.name);
+    out << ",\n";
+    out << pad << "  \"wall_seconds\": " << phase.wall_seconds << ",\n";
+    out << pad << "  \"cpu_seconds\": " << phase.cpu_seconds << ",\n";
+    out << pad << "  \"process_peak_rss_bytes\": " << phase.process_peak_rss_bytes;
+
+    if (not phase.memory_bytes.empty()) {
+        out << ",\n" << pad << "  \"memory_bytes\": {";
+        for (size_t i = 0; i < phase.memory_bytes.size(); ++i) {
+            out << (i == 0 ? "\n" : ",\n") << pad << "    ";
+            write_json_string(out, phase.memory_bytes[i].first);
+            out << ": " << phase.memory_bytes[i].second;
+        }
+        out << "\n" << pad << "  }";
+    }
+
+    if (not phase.counts.empty()) {
+        out << ",\n" << pad << "  \"counts\": {";
+        for (size_t i = 0; i < phase.counts.size(); ++i) {
+            out << (i == 0 ? "\n" : ",\n") << pad << "    ";
+            write_json_string(out, phase.counts[i].first);
+            out << ": " << phase.counts[i].second;
+        }
+        out << "\n" << pad << "  },\n" << pad << "  \"throughput_per_second\": {";
+        for (size_t i = 0; i < phase.counts.size(); ++i) {
+            out << (i == 0 ? "\n" : ",\n") << pad << "    ";
+            write_json_string(out, phase.counts[i].first);
+            out << ": "
+                << (phase.wall_seconds > 0 ? phase.counts[i].second / phase.wall_seconds
+                                           : 0);
+        }
+        out << "\n" << pad << "  }";
+    }
+
+    if (not phase.histograms.empty()) {
+        out << ",\n" << pad << "  \"histograms\": {";
+        for (size_t i = 0; i < phase.histograms.size(); ++i) {
+            out << (i == 0 ? "\n" : ",\n") << pad << "    ";
+            write_json_string(out, phase.histograms[i].first);
+            out << ": ";
+            write_histogram(out, phase.histograms[i].second, pad + "    ");
+        }
+        out << "\n" << pad << "  }";
+    }
+
+    if (not phase.subphases.empty()) {
+        out << ",\n" << pad << "  \"phases\": [\n";
+        for (size_t i = 0; i < phase.subphases.size(); ++i) {
+            write_phase(out, phase.subphases[i], indent + 4);
+            out << (i + 1 < phase.subphases.size() ? ",\n" : "\n");
+        }
+        out << pad << "  ]";
+    }
+    out << "\n" << pad << "}";
+}
+
+void RunStats::save(const fs::path& filepath)
+{
+    while (not open_phases.empty()) {
+        end_phase();
+    }
+    const std::chrono::duration<double> wall_time
+        = std::chrono::steady_clock::now() - start_time;
+
+    fs::ofstream out(filepath);
+    if (not out.is_open()) {
+        fatal_error("Error opening file ", filepath, " to write the run stats");
+    }
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"command\": ";
+    write_json_string(out, command);
+    out << ",\n";
+    out << "  \"wall_seconds\": " << wall_time.count() << ",\n";
+    out << "  \"cpu_seconds\": " << get_cpu_seconds() - start_cpu_seconds << ",\n";
+    out << "  \"peak_rss_bytes\": " << get_peak_rss_bytes() << ",\n";
+    out << "  \"phases\": [\n";
+    for (size_t i = 0; i < top_level_phases.size(); ++i) {
+        write_phase(out, top_level_phases[i], 4);
+        out << (i + 1 < top_level_phases.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
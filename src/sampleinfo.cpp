@@ -1,4 +1,5 @@
 #include "sampleinfo.h"
+#include "memory_usage.h"
 
 void SampleInfo::set_coverage_information(
     const std::vector<std::vector<uint32_t>>& allele_to_forward_coverages,
@@ -411,4 +412,16 @@ void SampleInfo::set_number_of_alleles_and_resize_coverage_information(
         fatal_error("Error when setting number of alleles for sample: "
                     "coverage information left inconsistent");
     }
-}
\ No newline at end of file
+}
+uint64_t SampleInfo::estimate_heap_memory_usage() const
+{
+    uint64_t bytes = ::estimate_heap_memory_usage(allele_to_forward_coverages)
+        + ::estimate_heap_memory_usage(allele_to_reverse_coverages);
+    for (const auto& coverages : allele_to_forward_coverages) {
+        bytes += ::estimate_heap_memory_usage(coverages);
+    }
+    for (const auto& coverages : allele_to_reverse_coverages) {
+        bytes += ::estimate_heap_memory_usage(coverages);
+    }
+    return bytes;
+}
@@ -11,20 +11,80 @@
 
 using std::vector;
 
+Seq::Seq()
+    : owns_data(false)
+    , id(0)
+{
+}
+
 Seq::Seq(uint32_t i, const std::string& n, const std::string& p, uint32_t w, uint32_t k)
-    : id(i)
-    , name(n)
-    , seq(p)
+    : owned_name(n)
+    , owned_seq(p)
+    , owns_data(true)
+    , id(i)
 {
+    bind_views_to_owned_data();
     minimizer_sketch(w, k);
 }
 
+Seq::Seq(const Seq& other)
+    : owned_name(other.owned_name)
+    , owned_seq(other.owned_seq)
+    , owns_data(other.owns_data)
+    , id(other.id)
+    , name(other.name)
+    , seq(other.seq)
+    , sketch(other.sketch)
+{
+    if (owns_data) {
+        bind_views_to_owned_data();
+    }
+}
+
+Seq& Seq::operator=(const Seq& other)
+{
+    if (this != &other) {
+        owned_name = other.owned_name;
+        owned_seq = other.owned_seq;
+        owns_data = other.owns_data;
+        id = other.id;
+        name = other.name;
+        seq = other.seq;
+        sketch = other.sketch;
+        if (owns_data) {
+            bind_views_to_owned_data();
+        }
+    }
+    return *this;
+}
+
 Seq::~Seq() { sketch.clear(); }
 
+void Seq::bind_views_to_owned_data()
+{
+    name = boost::string_view(owned_name);
+    seq = boost::string_view(owned_seq);
+}
+
 void Seq::initialize(
     uint32_t i, const std::string& n, const std::string& p, uint32_t w, uint32_t k)
 {
     id = i;
+    owned_name = n;
+    owned_seq = p;
+    owns_data = true;
+    bind_views_to_owned_data();
+    sketch.clear();
+    minimizer_sketch(w, k);
+}
+
+void Seq::initialize_view(uint32_t i, boost::string_view n, boost::string_view p,
+    uint32_t w, uint32_t k)
+{
+    id = i;
+    owned_name.clear();
+    owned_seq.clear();
+    owns_data = false;
     name = n;
     seq = p;
     sketch.clear();
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "simulate.h"
+#include "utils.h"
+
+// a site or allele marker of a PRG, as opposed to a sequence
+bool is_marker(const std::string& token)
+{
+    return std::all_of(token.begin(), token.end(), ::isdigit);
+}
+
+Simulator::Simulator(const uint32_t seed)
+    : rng(seed)
+{
+}
+
+std::string Simulator::random_sequence(const size_t length)
+{
+    static const char bases[] = "ACGT";
+    std::uniform_int_distribution<uint32_t> base(0, 3);
+    std::string sequence(length, 'A');
+    for (auto& c : sequence) {
+        c = bases[base(rng)];
+    }
+    return sequence;
+}
+
+void Simulator::add_random_site(std::string& prg, uint32_t& next_site_id,
+    const uint32_t allele_length, const uint32_t nb_alleles,
+    const uint32_t nesting_depth)
+{
+    const uint32_t site_id = next_site_id;
+    next_site_id += 2;
+    const std::string site_marker = " " + std::to_string(site_id) + " ";
+    const std::string allele_marker = " " + std::to_string(site_id + 1) + " ";
+
+    prg += site_marker;
+    for (uint32_t allele = 0; allele < nb_alleles; ++allele) {
+        if (allele > 0) {
+            prg += allele_marker;
+        }
+        // the nested site is surrounded by at least one base of the allele
+        const uint32_t left_length = std::max(allele_length / 2, (uint32_t)1);
+        prg += random_sequence(left_length);
+        if (nesting_depth > 0 and allele == 0) {
+            add_random_site(
+                prg, next_site_id, allele_length, nb_alleles, nesting_depth - 1);
+            prg += random_sequence(std::max(allele_length - left_length, (uint32_t)1));
+        } else {
+            prg += random_sequence(
+                allele_length - std::min(allele_length, left_length));
+        }
+    }
+    prg += site_marker;
+}
+
+std::string Simulator::random_prg(const uint32_t nb_sites, const uint32_t site_spacing,
+    const uint32_t allele_length, const uint32_t nb_alleles,
+    const uint32_t nesting_depth)
+{
+    std::string prg;
+    uint32_t next_site_id = 5;
+    for (uint32_t site = 0; site < nb_sites; ++site) {
+        prg += random_sequence(site_spacing);
+        add_random_site(prg, next_site_id, allele_length, nb_alleles, nesting_depth);
+    }
+    prg += random_sequence(site_spacing);
+    return prg;
+}
+
+size_t Simulator::add_random_path(const std::vector<std::string>& prg_tokens, size_t i,
+    std::string& path, const uint32_t enclosing_site_id)
+{
+    while (i < prg_tokens.size()) {
+        const std::string& token = prg_tokens[i];
+        if (not is_marker(token)) {
+            path += token;
+            ++i;
+            continue;
+        }
+
+        const uint32_t site_id = std::stoul(token);
+        if (enclosing_site_id != 0
+            and (site_id == enclosing_site_id or site_id == enclosing_site_id + 1)) {
+            return i;
+        }
+
+        // reservoir sampling of one allele, as the number of alleles is not known yet
+        std::string chosen_allele_path;
+        uint32_t nb_alleles = 0;
+        ++i;
+        while (true) {
+            std::string allele_path;
+            i = add_random_path(prg_tokens, i, allele_path, site_id);
+            ++nb_alleles;
+            if (std::uniform_int_distribution<uint32_t>(0, nb_alleles - 1)(rng) == 0) {
+                chosen_allele_path = allele_path;
+            }
+            if (i >= prg_tokens.size() or std::stoul(prg_tokens[i]) == site_id) {
+                break;
+            }
+            ++i; // skips the allele marker
+        }
+        ++i; // skips the site end marker
+        path += chosen_allele_path;
+    }
+    return i;
+}
+
+std::string Simulator::random_path(const std::string& prg)
+{
+    std::string path;
+    add_random_path(split(prg, " "), 0, path, 0);
+    return path;
+}
+
+std::string Simulator::add_errors(const std::string& sequence,
+    const double substitution_rate, const double insertion_rate,
+    const double deletion_rate)
+{
+    static const char bases[] = "ACGT";
+    std::bernoulli_distribution is_substitution(substitution_rate);
+    std::bernoulli_distribution is_insertion(insertion_rate);
+    std::bernoulli_distribution is_deletion(deletion_rate);
+    std::uniform_int_distribution<uint32_t> base(0, 3);
+    std::uniform_int_distribution<uint32_t> other_base_offset(1, 3);
+
+    std::string sequence_with_errors;
+    sequence_with_errors.reserve(sequence.size());
+    for (const char c : sequence) {
+        if (insertion_rate > 0 and is_insertion(rng)) {
+            sequence_with_errors += bases[base(rng)];
+        }
+        if (deletion_rate > 0 and is_deletion(rng)) {
+            continue;
+        }
+        if (substitution_rate > 0 and is_substitution(rng)) {
+            const char* base_in_bases = std::find(bases, bases + 4, ::toupper(c));
+            const uint32_t base_index = base_in_bases - bases;
+            sequence_with_errors += base_index < 4
+                ? bases[(base_index + other_base_offset(rng)) % 4]
+                : bases[base(rng)];
+        } else {
+            sequence_with_errors += c;
+        }
+    }
+    return sequence_with_errors;
+}
+
+std::string Simulator::random_read(const std::string& genome,
+    const uint32_t read_length, const double substitution_rate,
+    const double insertion_rate, const double deletion_rate)
+{
+    const size_t length = std::min((size_t)read_length, genome.size());
+    std::uniform_int_distribution<size_t> start(0, genome.size() - length);
+    std::string read = genome.substr(start(rng), length);
+    if (std::bernoulli_distribution(0.5)(rng)) {
+        read = rev_complement(read);
+    }
+    return add_errors(read, substitution_rate, insertion_rate, deletion_rate);
+}
+
+uint64_t Simulator::number_of_reads_for_depth(
+    const uint64_t genome_length, const uint32_t read_length, const double depth)
+{
+    if (read_length == 0) {
+        return 0;
+    }
+    const uint64_t read_bases = std::min((uint64_t)read_length, genome_length);
+    if (read_bases == 0) {
+        return 0;
+    }
+    return (uint64_t)std::ceil(depth * genome_length / read_bases);
+}
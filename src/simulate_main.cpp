@@ -0,0 +1,228 @@
+#include <cmath>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include "simulate_main.h"
+
+void setup_simulate_subcommand(CLI::App& app)
+{
+    auto opt = std::make_shared<SimulateOptions>();
+
+    std::string description
+        = "Simulate a PanRG, truth genomes sampled from it, and reads from these "
+          "genomes with errors";
+    auto* simulate_subcmd = app.add_subcommand("simulate", description);
+
+    simulate_subcmd
+        ->add_option("-o,--outdir", opt->outdir, "Directory to write output files to")
+        ->type_name("DIR")
+        ->capture_default_str()
+        ->transform(make_absolute)
+        ->group("Input/Output");
+
+    simulate_subcmd->add_flag(
+        "-z,--compress", opt->compress, "Compress the output files with gzip")
+        ->group("Input/Output");
+
+    simulate_subcmd
+        ->add_option("--loci", opt->num_loci, "Number of loci (PRGs) in the PanRG")
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--sites", opt->num_sites, "Number of variant sites per locus")
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--site-spacing", opt->site_spacing,
+            "Number of invariant bases between consecutive sites")
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--allele-length", opt->allele_length,
+            "Number of bases of each allele (excluding nested sites)")
+        ->capture_default_str()
+        ->check(CLI::Range(1, 1000000))
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--alleles", opt->num_alleles, "Number of alleles per site")
+        ->capture_default_str()
+        ->check(CLI::Range(2, 1000))
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--nesting", opt->nesting_depth,
+            "Nesting depth of sites: each site of depth lower than this has a site "
+            "nested in its first allele")
+        ->capture_default_str()
+        ->check(CLI::Range(0, 10))
+        ->type_name("INT")
+        ->group("PanRG");
+
+    simulate_subcmd
+        ->add_option("--genomes", opt->num_genomes,
+            "Number of truth genomes (samples) sampled from the PanRG")
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Genomes");
+
+    simulate_subcmd
+        ->add_option("--intergenic-length", opt->intergenic_length,
+            "Number of random bases between consecutive loci of a genome")
+        ->capture_default_str()
+        ->type_name("INT")
+        ->group("Genomes");
+
+    simulate_subcmd
+        ->add_option("--depth", opt->depth, "Depth of coverage of the reads")
+        ->capture_default_str()
+        ->check(CLI::NonNegativeNumber)
+        ->type_name("FLOAT")
+        ->group("Reads");
+
+    simulate_subcmd
+        ->add_option("--read-length", opt->read_length, "Length of the reads")
+        ->capture_default_str()
+        ->check(CLI::Range(1, 100000000))
+        ->type_name("INT")
+        ->group("Reads");
+
+    simulate_subcmd
+        ->add_option("--substitution-rate", opt->substitution_rate,
+            "Probability of a substitution at each base of a read")
+        ->capture_default_str()
+        ->check(CLI::Range(0.0, 1.0))
+        ->type_name("FLOAT")
+        ->group("Reads");
+
+    simulate_subcmd
+        ->add_option("--insertion-rate", opt->insertion_rate,
+            "Probability of an insertion before each base of a read")
+        ->capture_default_str()
+        ->check(CLI::Range(0.0, 1.0))
+        ->type_name("FLOAT")
+        ->group("Reads");
+
+    simulate_subcmd
+        ->add_option("--deletion-rate", opt->deletion_rate,
+            "Probability of a deletion of each base of a read")
+        ->capture_default_str()
+        ->check(CLI::Range(0.0, 1.0))
+        ->type_name("FLOAT")
+        ->group("Reads");
+
+    simulate_subcmd
+        ->add_option("--seed", opt->seed, "Seed of the random number generator")
+        ->capture_default_str()
+        ->type_name("INT");
+
+    simulate_subcmd->add_flag(
+        "-v", opt->verbosity, "Verbosity of logging. Repeat for increased verbosity");
+
+    simulate_subcmd->callback([opt]() { pandora_simulate(*opt); });
+}
+
+// opens the given file for writing, with gzip compression if compress
+void open_output_file(boost::iostreams::filtering_ostream& out,
+    const fs::path& filepath, const bool compress)
+{
+    if (compress) {
+        out.push(boost::iostreams::gzip_compressor());
+    }
+    out.push(boost::iostreams::file_sink(
+        filepath.string(), std::ios_base::out | std::ios_base::binary));
+    if (not out.good()) {
+        fatal_error("Unable to open ", filepath, " for writing");
+    }
+}
+
+int pandora_simulate(SimulateOptions const& opt)
+{
+    auto log_level = boost::log::trivial::info;
+    if (opt.verbosity == 1) {
+        log_level = boost::log::trivial::debug;
+    } else if (opt.verbosity > 1) {
+        log_level = boost::log::trivial::trace;
+    }
+    boost::log::core::get()->set_filter(boost::log::trivial::severity >= log_level);
+
+    fs::create_directories(opt.outdir);
+    const std::string extension = opt.compress ? ".gz" : "";
+    Simulator simulator(opt.seed);
+
+    BOOST_LOG_TRIVIAL(info) << "Simulating a PanRG of " << opt.num_loci
+                            << " loci with " << opt.num_sites << " sites each";
+    std::vector<std::string> prgs;
+    prgs.reserve(opt.num_loci);
+    {
+        const fs::path prg_filepath = opt.outdir / ("simulated.prg.fa" + extension);
+        boost::iostreams::filtering_ostream prg_file;
+        open_output_file(prg_file, prg_filepath, opt.compress);
+        for (uint32_t locus = 0; locus < opt.num_loci; ++locus) {
+            prgs.push_back(simulator.random_prg(opt.num_sites, opt.site_spacing,
+                opt.allele_length, opt.num_alleles, opt.nesting_depth));
+            prg_file << ">locus" << locus << "\n" << prgs.back() << "\n";
+        }
+    }
+
+    // a read quality matching the total error rate of the reads
+    const double error_rate
+        = std::min(1.0, opt.substitution_rate + opt.insertion_rate + opt.deletion_rate);
+    const uint32_t phred_quality = error_rate > 0
+        ? std::min(40u, (uint32_t)std::round(-10 * std::log10(error_rate)))
+        : 40u;
+    const char quality_char = (char)(33 + phred_quality);
+
+    fs::ofstream read_index(opt.outdir / "read_index.tsv");
+    for (uint32_t genome_index = 0; genome_index < opt.num_genomes; ++genome_index) {
+        const std::string sample_name = "sample" + std::to_string(genome_index);
+
+        // the truth genome is the loci, each on a random path of its PRG, separated
+        // by random intergenic sequences; the truth path of each locus is saved
+        std::string genome;
+        {
+            const fs::path truth_filepath
+                = opt.outdir / (sample_name + ".truth.fa" + extension);
+            boost::iostreams::filtering_ostream truth_file;
+            open_output_file(truth_file, truth_filepath, opt.compress);
+            for (uint32_t locus = 0; locus < opt.num_loci; ++locus) {
+                const std::string locus_path = simulator.random_path(prgs[locus]);
+                truth_file << ">locus" << locus << "\n" << locus_path << "\n";
+                genome += simulator.random_sequence(opt.intergenic_length);
+                genome += locus_path;
+            }
+            genome += simulator.random_sequence(opt.intergenic_length);
+        }
+
+        const uint64_t number_of_reads = Simulator::number_of_reads_for_depth(
+            genome.size(), opt.read_length, opt.depth);
+        BOOST_LOG_TRIVIAL(info) << "Simulating " << number_of_reads << " reads of "
+                                << sample_name << " (genome of " << genome.size()
+                                << " bases)";
+        const fs::path reads_filepath
+            = opt.outdir / (sample_name + ".reads.fq" + extension);
+        {
+            boost::iostreams::filtering_ostream reads_file;
+            open_output_file(reads_file, reads_filepath, opt.compress);
+            for (uint64_t i = 0; i < number_of_reads; ++i) {
+                const std::string read = simulator.random_read(genome, opt.read_length,
+                    opt.substitution_rate, opt.insertion_rate, opt.deletion_rate);
+                reads_file << "@" << sample_name << "_read" << i << "\n"
+                           << read << "\n+\n"
+                           << std::string(read.size(), quality_char) << "\n";
+            }
+        }
+        read_index << sample_name << "\t" << reads_filepath.string() << "\n";
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Simulated data written to " << opt.outdir;
+    return 0;
+}
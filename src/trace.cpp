@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <iomanip>
+#include <unistd.h>
+#include <omp.h>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/log/trivial.hpp>
+#include "trace.h"
+#include "run_stats.h"
+#include "fatal_error.h"
+
+// the tracer of the run, see set_run_tracer()
+Tracer* run_tracer = nullptr;
+
+Tracer::Tracer(const std::string& process_name, const uint32_t threads)
+    : process_name(process_name)
+    , pid(getpid())
+    , start_time(std::chrono::steady_clock::now())
+    , events_per_thread(std::max<uint32_t>(threads, omp_get_max_threads()))
+{
+}
+
+double Tracer::now() const
+{
+    const std::chrono::duration<double, std::micro> elapsed
+        = std::chrono::steady_clock::now() - start_time;
+    return elapsed.count();
+}
+
+void Tracer::add_span(const std::string& name, const std::string& category,
+    const double start_us, const double end_us, TraceArgs args)
+{
+    const uint32_t thread = omp_get_thread_num();
+    Event event { name, category, start_us, end_us - start_us, pid, thread,
+        std::move(args) };
+
+    // in a nested parallel region, several threads have the same thread number
+    const bool own_buffer
+        = omp_get_level() <= 1 and thread < events_per_thread.size();
+    if (own_buffer) {
+        events_per_thread[thread].push_back(std::move(event));
+    } else {
+        std::lock_guard<std::mutex> lock(shared_events_mutex);
+        shared_events.push_back(std::move(event));
+    }
+}
+
+void Tracer::add_process_span(const std::string& name, const std::string& category,
+    const int32_t process_id, const double start_us, const double end_us,
+    TraceArgs args)
+{
+    Event event { name, category, start_us, end_us - start_us, process_id, 0,
+        std::move(args) };
+    std::lock_guard<std::mutex> lock(shared_events_mutex);
+    shared_events.push_back(std::move(event));
+}
+
+std::vector<Tracer::Event> Tracer::get_events() const
+{
+    std::vector<Event> events;
+    for (const auto& thread_events : events_per_thread) {
+        events.insert(events.end(), thread_events.begin(), thread_events.end());
+    }
+    events.insert(events.end(), shared_events.begin(), shared_events.end());
+    return events;
+}
+
+// writes a metadata event naming a process or a thread of the timeline
+void write_trace_name(std::ostream& out, const char* metadata, const int32_t pid,
+    const uint32_t tid, const std::string& name)
+{
+    out << "{\"name\": \"" << metadata << "\", \"ph\": \"M\", \"pid\": " << pid
+        << ", \"tid\": " << tid << ", \"args\": {\"name\": ";
+    write_json_string(out, name);
+    out << "}}";
+}
+
+void Tracer::save(const fs::path& filepath) const
+{
+    fs::ofstream out(filepath);
+    if (not out.is_open()) {
+        fatal_error("Error opening file ", filepath, " to write the trace");
+    }
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    write_trace_name(out, "process_name", pid, 0, "pandora " + process_name);
+    for (uint32_t thread = 0; thread < events_per_thread.size(); ++thread) {
+        if (not events_per_thread[thread].empty()) {
+            out << ",\n";
+            write_trace_name(
+                out, "thread_name", pid, thread, "thread " + std::to_string(thread));
+        }
+    }
+
+    for (const auto& event : get_events()) {
+        out << ",\n{\"name\": ";
+        write_json_string(out, event.name);
+        out << ", \"cat\": ";
+        write_json_string(out, event.category);
+        out << ", \"ph\": \"X\", \"ts\": " << event.start_us
+            << ", \"dur\": " << event.duration_us << ", \"pid\": " << event.pid
+            << ", \"tid\": " << event.tid;
+        if (not event.args.empty()) {
+            out << ", \"args\": {";
+            for (size_t i = 0; i < event.args.size(); ++i) {
+                out << (i == 0 ? "" : ", ");
+                write_json_string(out, event.args[i].first);
+                out << ": ";
+                write_json_string(out, event.args[i].second);
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+void set_run_tracer(Tracer* tracer) { run_tracer = tracer; }
+
+Tracer* get_run_tracer() { return run_tracer; }
+
+double trace_timestamp() { return run_tracer ? run_tracer->now() : 0; }
+
+void trace_lock_wait(const char* critical_section_name, const double wait_start_us)
+{
+    if (run_tracer == nullptr) {
+        return;
+    }
+    const double end_us = run_tracer->now();
+    if (end_us - wait_start_us >= 1) {
+        run_tracer->add_span(std::string("wait ") + critical_section_name, "lock_wait",
+            wait_start_us, end_us);
+    }
+}
+
+ScopedRunTracer::ScopedRunTracer(
+    const fs::path& filepath, const std::string& command, const uint32_t threads)
+    : filepath(filepath)
+{
+    if (not filepath.empty()) {
+        tracer.reset(new Tracer(command, threads));
+        set_run_tracer(tracer.get());
+    }
+}
+
+ScopedRunTracer::~ScopedRunTracer()
+{
+    if (tracer == nullptr) {
+        return;
+    }
+    set_run_tracer(nullptr);
+    try {
+        tracer->save(filepath);
+        BOOST_LOG_TRIVIAL(info) << "Trace written to " << filepath;
+    } catch (const std::exception& error) {
+        BOOST_LOG_TRIVIAL(error) << "Could not write the trace: " << error.what();
+    }
+}
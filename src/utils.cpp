@@ -7,7 +7,10 @@
 #include <set>
 #include <memory>
 #include <ctime>
+#include <chrono>
+#include <atomic>
 #include <algorithm>
+#include <numeric>
 #include <boost/filesystem.hpp>
 
 #include "utils.h"
@@ -17,6 +20,10 @@
 #include "noise_filtering.h"
 #include "minihit.h"
 #include "fastaq_handler.h"
+#include "read_batch.h"
+#include "read_subsampler.h"
+#include "run_stats.h"
+#include "memory_usage.h"
 
 std::string now()
 {
@@ -172,100 +179,263 @@ void load_vcf_refs_file(const fs::path& filepath, VCFRefs& vcf_refs)
     }
 }
 
-void add_read_hits(const Seq& sequence,
-    const std::shared_ptr<MinimizerHits>& minimizer_hits, const Index& index)
+void MappingHistograms::merge(const MappingHistograms& other)
 {
-    // creates Seq object for the read, then looks up minimizers in the Seq sketch and
-    // adds hits to a global MinimizerHits object
-    // Seq s(id, name, seq, w, k);
-    for (auto sequenceSketchIt = sequence.sketch.begin();
-         sequenceSketchIt != sequence.sketch.end(); ++sequenceSketchIt) {
-        auto minhashIt = index.minhash.find((*sequenceSketchIt).canonical_kmer_hash);
+    sketch_size.merge(other.sketch_size);
+    index_hits.merge(other.index_hits);
+    hits_per_prg.merge(other.hits_per_prg);
+    candidate_cluster_size.merge(other.candidate_cluster_size);
+    clusters_before_filter.merge(other.clusters_before_filter);
+    clusters_after_filter.merge(other.clusters_after_filter);
+    nb_clusters_below_min_cluster_size += other.nb_clusters_below_min_cluster_size;
+    nb_clusters_below_length_threshold += other.nb_clusters_below_length_threshold;
+    nb_clusters_overlapping += other.nb_clusters_overlapping;
+}
+
+ReadHitsStatus add_read_hits(const Seq& sequence,
+    const std::shared_ptr<MinimizerHits>& minimizer_hits, const Index& index,
+    const uint32_t min_cluster_size, const uint32_t max_hits, const uint32_t max_prgs,
+    MappingHistograms* histograms, ReadHitsScratch* scratch)
+{
+    ReadHitsScratch own_scratch;
+    auto& read_index_entries = (scratch ? *scratch : own_scratch).index_entries;
+    auto& hit_prg_ids = (scratch ? *scratch : own_scratch).hit_prg_ids;
+    read_index_entries.clear();
+    hit_prg_ids.clear();
+
+    // looks up the minimizers of the read sketch in the index
+    for (const Minimizer& minimizer : sequence.sketch) {
+        auto minhashIt = index.minhash.find(minimizer.canonical_kmer_hash);
         if (minhashIt != index.minhash.end()) { // checks if the kmer is in the index
-            // yes, add all hits of this minimizer hit to this kmer
+            read_index_entries.emplace_back(&minimizer, minhashIt->second);
             for (const MiniRecord& miniRecord : *(minhashIt->second)) {
-                minimizer_hits->add_hit(sequence.id, *sequenceSketchIt, miniRecord);
+                hit_prg_ids.push_back(miniRecord.prg_id);
+            }
+        }
+    }
+
+    if (histograms) {
+        histograms->sketch_size.add(sequence.sketch.size());
+        histograms->index_hits.add(hit_prg_ids.size());
+    }
+
+    // pathological reads (e.g. chimeric or low complexity) can have so many hits that
+    // clustering them stalls a thread, they are skipped
+    if (max_hits > 0 and hit_prg_ids.size() > max_hits) {
+        return ReadHitsStatus::TooManyHits;
+    }
+
+    // a cluster has more than min_cluster_size hits on the same PRG, so a read without
+    // such a PRG has no cluster, and is rejected before any hit is built
+    if (hit_prg_ids.size() <= min_cluster_size) {
+        return ReadHitsStatus::TooFewHits;
+    }
+    std::sort(hit_prg_ids.begin(), hit_prg_ids.end());
+    bool has_enough_hits_on_a_prg = false;
+    uint32_t nb_prgs = 0;
+    for (uint32_t run_begin = 0, run_end = 0; run_begin < hit_prg_ids.size();
+         run_begin = run_end) {
+        while (run_end < hit_prg_ids.size()
+            and hit_prg_ids[run_end] == hit_prg_ids[run_begin]) {
+            ++run_end;
+        }
+        has_enough_hits_on_a_prg
+            = has_enough_hits_on_a_prg or run_end - run_begin > min_cluster_size;
+        ++nb_prgs;
+        if (histograms) {
+            histograms->hits_per_prg.add(run_end - run_begin);
+        } else if (has_enough_hits_on_a_prg and max_prgs == 0) {
+            break; // no need to count all PRGs
+        }
+    }
+    if (not has_enough_hits_on_a_prg) {
+        return ReadHitsStatus::TooFewHits;
+    }
+    if (max_prgs > 0 and nb_prgs > max_prgs) {
+        return ReadHitsStatus::TooManyPrgs;
+    }
+
+    // adds all hits of the read to minimizer_hits
+    for (const auto& read_index_entry : read_index_entries) {
+        for (const MiniRecord& miniRecord : *read_index_entry.second) {
+            minimizer_hits->add_hit(sequence.id, *read_index_entry.first, miniRecord);
+        }
+    }
+    minimizer_hits->sort();
+    return ReadHitsStatus::Added;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> chain_hits(std::vector<MinimizerHit>& hits,
+    const uint32_t begin, const uint32_t end, const int max_diff)
+{
+    // minimap2-like colinear chaining: each hit is a seed at (read position, PRG
+    // position), where the PRG position is the start of the kmer path in the PRG, i.e.
+    // the order of the kmer graph nodes
+    constexpr uint32_t max_chain_predecessors = 50; // band of the DP
+    const uint32_t nb_hits = end - begin;
+    const bool is_forward = hits[begin].is_forward();
+    std::vector<double> scores(nb_hits);
+    std::vector<int64_t> predecessors(nb_hits, -1);
+
+    for (uint32_t i = 0; i < nb_hits; ++i) {
+        const MinimizerHit& hit_i = hits[begin + i];
+        const double kmer_length = hit_i.get_prg_path().length();
+        scores[i] = kmer_length;
+
+        const uint32_t first_predecessor
+            = i > max_chain_predecessors ? i - max_chain_predecessors : 0;
+        for (int64_t j = (int64_t)i - 1; j >= (int64_t)first_predecessor; --j) {
+            const MinimizerHit& hit_j = hits[begin + j];
+            const int64_t read_gap = (int64_t)hit_i.get_read_start_position()
+                - hit_j.get_read_start_position();
+            if (read_gap > max_diff) {
+                break; // hits are sorted by read position
+            }
+            const int64_t prg_gap = is_forward
+                ? (int64_t)hit_i.get_prg_path().get_start()
+                    - hit_j.get_prg_path().get_start()
+                : (int64_t)hit_j.get_prg_path().get_start()
+                    - hit_i.get_prg_path().get_start();
+            const bool is_colinear = read_gap > 0 and prg_gap > 0;
+            if (not is_colinear) {
+                continue;
+            }
+
+            const double gap_difference = std::abs(read_gap - prg_gap);
+            const double gap_cost
+                = 0.01 * kmer_length * gap_difference + 0.5 * log2(gap_difference + 1);
+            const double bases_added
+                = std::min((double)std::min(read_gap, prg_gap), kmer_length);
+            const double score = scores[j] + bases_added - gap_cost;
+            if (score > scores[i]) {
+                scores[i] = score;
+                predecessors[i] = j;
             }
         }
     }
+
+    // extract the chains from the best scoring ends, each hit being in only one chain
+    std::vector<uint32_t> chain_ends(nb_hits);
+    std::iota(chain_ends.begin(), chain_ends.end(), 0);
+    std::stable_sort(chain_ends.begin(), chain_ends.end(),
+        [&scores](const uint32_t lhs, const uint32_t rhs) {
+            return scores[lhs] > scores[rhs];
+        });
+    std::vector<bool> is_chained(nb_hits, false);
+    std::vector<MinimizerHit> chained_hits;
+    chained_hits.reserve(nb_hits);
+    std::vector<std::pair<uint32_t, uint32_t>> chains;
+    std::vector<uint32_t> chain;
+    for (const uint32_t chain_end : chain_ends) {
+        chain.clear();
+        for (int64_t hit = chain_end; hit != -1 and not is_chained[hit];
+             hit = predecessors[hit]) {
+            chain.push_back(hit);
+            is_chained[hit] = true;
+        }
+        if (chain.empty()) {
+            continue;
+        }
+
+        const uint32_t chain_begin = begin + chained_hits.size();
+        for (auto hit = chain.rbegin(); hit != chain.rend(); ++hit) {
+            chained_hits.push_back(hits[begin + *hit]);
+        }
+        chains.emplace_back(chain_begin, begin + chained_hits.size());
+    }
+
+    std::copy(chained_hits.begin(), chained_hits.end(), hits.begin() + begin);
+    return chains;
 }
 
-void define_clusters(std::set<MinimizerHitCluster, clusterComp>& clusters_of_hits,
+void define_clusters(std::vector<MinimizerHitClusterRange>& clusters_of_hits,
     const std::vector<std::shared_ptr<LocalPRG>>& prgs,
     std::shared_ptr<MinimizerHits> minimizer_hits, const int max_diff,
     const float& fraction_kmers_required_for_cluster, const uint32_t min_cluster_size,
-    const uint32_t expected_number_kmers_in_read_sketch)
+    const uint32_t expected_number_kmers_in_read_sketch, const bool chain,
+    MappingHistograms* histograms)
 {
-    BOOST_LOG_TRIVIAL(trace) << "Define clusters of hits from the "
-                             << minimizer_hits->hits.size() << " hits";
+    std::vector<MinimizerHit>& hits = minimizer_hits->hits;
+    BOOST_LOG_TRIVIAL(trace) << "Define clusters of hits from the " << hits.size()
+                             << " hits";
 
-    if (minimizer_hits->hits.empty()) {
+    if (hits.empty()) {
         return;
     }
 
+    // keep clusters which cover at least 1/2 the expected number of minihits
+    const auto keep_cluster_if_big_enough
+        = [&](const uint32_t cluster_begin, const uint32_t cluster_end) {
+              const MinimizerHitClusterRange cluster(hits, cluster_begin, cluster_end);
+              const uint32_t length_based_threshold
+                  = std::min(prgs[cluster.prg_id]->kmer_prg.min_path_length(),
+                        expected_number_kmers_in_read_sketch)
+                  * fraction_kmers_required_for_cluster;
+              BOOST_LOG_TRIVIAL(trace)
+                  << "Length based cluster threshold min("
+                  << prgs[cluster.prg_id]->kmer_prg.min_path_length() << ", "
+                  << expected_number_kmers_in_read_sketch << ") * "
+                  << fraction_kmers_required_for_cluster << " = "
+                  << length_based_threshold;
+
+              if (histograms) {
+                  histograms->candidate_cluster_size.add(cluster.size());
+              }
+
+              if (cluster.size() > std::max(length_based_threshold, min_cluster_size)) {
+                  clusters_of_hits.push_back(cluster);
+              } else {
+                  if (histograms and cluster.size() <= min_cluster_size) {
+                      ++histograms->nb_clusters_below_min_cluster_size;
+                  } else if (histograms) {
+                      ++histograms->nb_clusters_below_length_threshold;
+                  }
+                  BOOST_LOG_TRIVIAL(trace)
+                      << "Rejected cluster of size " << cluster.size() << " < max("
+                      << length_based_threshold << ", " << min_cluster_size << ")";
+              }
+          };
+
+    // if chaining, each cluster is refined into its colinear chains
+    const auto add_cluster
+        = [&](const uint32_t cluster_begin, const uint32_t cluster_end) {
+              if (not chain) {
+                  keep_cluster_if_big_enough(cluster_begin, cluster_end);
+                  return;
+              }
+              for (const auto& chain_range :
+                  chain_hits(hits, cluster_begin, cluster_end, max_diff)) {
+                  keep_cluster_if_big_enough(chain_range.first, chain_range.second);
+              }
+          };
+
     // A cluster of hits should match same localPRG, each hit not more than max_diff
     // read bases from the last hit (this last bit is to handle repeat genes).
-    auto mh_previous = minimizer_hits->hits.begin();
-    MinimizerHitCluster current_cluster;
-    current_cluster.insert(*mh_previous);
-    uint32_t length_based_threshold;
-    for (auto mh_current = ++minimizer_hits->hits.begin();
-         mh_current != minimizer_hits->hits.end(); ++mh_current) {
-        if ((*mh_current)->get_read_id() != (*mh_previous)->get_read_id()
-            or (*mh_current)->get_prg_id() != (*mh_previous)->get_prg_id()
-            or (*mh_current)->is_forward() != (*mh_previous)->is_forward()
-            or (abs((int)(*mh_current)->get_read_start_position()
-                   - (int)(*mh_previous)->get_read_start_position()))
+    // As hits are sorted, a cluster is a range of consecutive hits
+    uint32_t cluster_begin = 0;
+    for (uint32_t current = 1; current < hits.size(); ++current) {
+        const MinimizerHit& mh_current = hits[current];
+        const MinimizerHit& mh_previous = hits[current - 1];
+        if (mh_current.get_read_id() != mh_previous.get_read_id()
+            or mh_current.get_prg_id() != mh_previous.get_prg_id()
+            or mh_current.is_forward() != mh_previous.is_forward()
+            or (abs((int)mh_current.get_read_start_position()
+                   - (int)mh_previous.get_read_start_position()))
                 > max_diff) {
-            // keep clusters which cover at least 1/2 the expected number of minihits
-            length_based_threshold
-                = std::min(
-                      prgs[(*mh_previous)->get_prg_id()]->kmer_prg.min_path_length(),
-                      expected_number_kmers_in_read_sketch)
-                * fraction_kmers_required_for_cluster;
-            BOOST_LOG_TRIVIAL(trace)
-                << "Length based cluster threshold min("
-                << prgs[(*mh_previous)->get_prg_id()]->kmer_prg.min_path_length()
-                << ", " << expected_number_kmers_in_read_sketch << ") * "
-                << fraction_kmers_required_for_cluster << " = "
-                << length_based_threshold;
-
-            if (current_cluster.size()
-                > std::max(length_based_threshold, min_cluster_size)) {
-                clusters_of_hits.insert(current_cluster);
-            } else {
-                BOOST_LOG_TRIVIAL(trace)
-                    << "Rejected cluster of size " << current_cluster.size()
-                    << " < max(" << length_based_threshold << ", " << min_cluster_size
-                    << ")";
-            }
-            current_cluster.clear();
+            add_cluster(cluster_begin, current);
+            cluster_begin = current;
         }
-        current_cluster.insert(*mh_current);
-        mh_previous = mh_current;
-    }
-    length_based_threshold
-        = std::min(prgs[(*mh_previous)->get_prg_id()]->kmer_prg.min_path_length(),
-              expected_number_kmers_in_read_sketch)
-        * fraction_kmers_required_for_cluster;
-    BOOST_LOG_TRIVIAL(trace)
-        << "Length based cluster threshold min("
-        << prgs[(*mh_previous)->get_prg_id()]->kmer_prg.min_path_length() << ", "
-        << expected_number_kmers_in_read_sketch << ") * "
-        << fraction_kmers_required_for_cluster << " = " << length_based_threshold;
-    if (current_cluster.size() > std::max(length_based_threshold, min_cluster_size)) {
-        clusters_of_hits.insert(current_cluster);
-    } else {
-        BOOST_LOG_TRIVIAL(trace)
-            << "Rejected cluster of size " << current_cluster.size() << " < max("
-            << length_based_threshold << ", " << min_cluster_size << ")";
     }
+    add_cluster(cluster_begin, hits.size());
+
+    std::sort(
+        clusters_of_hits.begin(), clusters_of_hits.end(), clusterRangeComp { hits });
 
     BOOST_LOG_TRIVIAL(trace) << "Found " << clusters_of_hits.size()
                              << " clusters of hits";
 }
 
-void filter_clusters(std::set<MinimizerHitCluster, clusterComp>& clusters_of_hits)
+void filter_clusters(std::vector<MinimizerHitClusterRange>& clusters_of_hits)
 {
     // Next order clusters, choose between those that overlap by too much
     BOOST_LOG_TRIVIAL(trace) << "Filter the " << clusters_of_hits.size()
@@ -273,41 +443,38 @@ void filter_clusters(std::set<MinimizerHitCluster, clusterComp>& clusters_of_hit
     if (clusters_of_hits.empty()) {
         return;
     }
-    // to do this consider pairs of clusters in turn
+    // to do this consider pairs of clusters in turn: the kept clusters are compacted
+    // at the start of the vector, the last of them being the previous cluster
     auto c_previous = clusters_of_hits.begin();
-    for (auto c_current = ++clusters_of_hits.begin();
+    for (auto c_current = clusters_of_hits.begin() + 1;
          c_current != clusters_of_hits.end(); ++c_current) {
-        if (((*(*c_current).begin())->get_read_id()
-                == (*(*c_previous).begin())->get_read_id())
+        if ((c_current->read_id == c_previous->read_id)
             && // if on same read and either
-            ((((*(*c_current).begin())->get_prg_id()
-                  == (*(*c_previous).begin())->get_prg_id())
+            (((c_current->prg_id == c_previous->prg_id)
                  && // same prg, different strand
-                 ((*(*c_current).begin())->is_forward()
-                     != (*(*c_previous).begin())->is_forward()))
+                 (c_current->is_forward != c_previous->is_forward))
                 or // or cluster is contained
-                ((*--(*c_current).end())->get_read_start_position()
-                    <= (*--(*c_previous).end())
-                           ->get_read_start_position()))) // i.e. not least one hit
-                                                          // outside overlap
+                (c_current->last_read_start_position
+                    <= c_previous->last_read_start_position))) // i.e. not least one
+                                                               // hit outside overlap
         // NB we expect noise in the k-1 kmers overlapping the boundary of two clusters,
         // but could also impose no more than 2k hits in overlap
         {
-            if (c_previous->size() >= c_current->size()) {
-                clusters_of_hits.erase(c_current);
-                c_current = c_previous;
-            } else {
-                clusters_of_hits.erase(c_previous);
+            if (c_previous->size() < c_current->size()) {
+                *c_previous = *c_current;
             }
+        } else {
+            ++c_previous;
+            *c_previous = *c_current;
         }
-        c_previous = c_current;
     }
+    clusters_of_hits.erase(c_previous + 1, clusters_of_hits.end());
     BOOST_LOG_TRIVIAL(trace) << "Now have " << clusters_of_hits.size()
                              << " clusters of hits";
 }
 
-void filter_clusters2(std::set<MinimizerHitCluster, clusterComp>& clusters_of_hits,
-    const uint32_t& genome_size)
+void filter_clusters2(std::vector<MinimizerHitClusterRange>& clusters_of_hits,
+    const std::vector<MinimizerHit>& hits, const uint32_t& genome_size)
 {
     // Sort clusters by size, and filter out those small clusters which are entirely
     // contained in bigger clusters on reads
@@ -317,59 +484,147 @@ void filter_clusters2(std::set<MinimizerHitCluster, clusterComp>& clusters_of_hi
         return;
     }
 
-    std::set<MinimizerHitCluster, clusterComp_size> clusters_by_size(
-        clusters_of_hits.begin(), clusters_of_hits.end());
+    std::vector<uint32_t> clusters_by_size(clusters_of_hits.size());
+    std::iota(clusters_by_size.begin(), clusters_by_size.end(), 0);
+    const clusterRangeComp_size compare_size { hits };
+    std::sort(clusters_by_size.begin(), clusters_by_size.end(),
+        [&](const uint32_t lhs, const uint32_t rhs) {
+            return compare_size(clusters_of_hits[lhs], clusters_of_hits[rhs]);
+        });
 
+    std::vector<bool> is_contained(clusters_of_hits.size(), false);
     auto it = clusters_by_size.begin();
     std::vector<int> read_v(genome_size, 0);
-    fill(read_v.begin() + (*(it->begin()))->get_read_start_position(),
-        read_v.begin() + (*--(it->end()))->get_read_start_position(), 1);
-    bool contained;
-    for (auto it_next = ++clusters_by_size.begin(); it_next != clusters_by_size.end();
-         ++it_next) {
-        if ((*(it_next->begin()))->get_read_id() == (*(it->begin()))->get_read_id()) {
+    fill(read_v.begin() + clusters_of_hits[*it].first_read_start_position,
+        read_v.begin() + clusters_of_hits[*it].last_read_start_position, 1);
+    for (auto it_next = clusters_by_size.begin() + 1;
+         it_next != clusters_by_size.end(); ++it_next) {
+        const MinimizerHitClusterRange& next_cluster = clusters_of_hits[*it_next];
+        if (next_cluster.read_id == clusters_of_hits[*it].read_id) {
             // check if have any 0s in interval of read_v between first and last
-            contained = true;
-            for (uint32_t i = (*(it_next->begin()))->get_read_start_position();
-                 i < (*--(it_next->end()))->get_read_start_position(); ++i) {
+            bool contained = true;
+            for (uint32_t i = next_cluster.first_read_start_position;
+                 i < next_cluster.last_read_start_position; ++i) {
                 if (read_v[i] == 0) {
                     contained = false;
                     fill(read_v.begin() + i,
-                        read_v.begin()
-                            + (*--(it_next->end()))->get_read_start_position(),
-                        1);
+                        read_v.begin() + next_cluster.last_read_start_position, 1);
                     break;
                 }
             }
-            if (contained) {
-                clusters_of_hits.erase(*it_next);
-            }
+            is_contained[*it_next] = contained;
         } else {
             // consider new read
             fill(read_v.begin(), read_v.end(), 0);
         }
         ++it;
     }
+
+    uint32_t nb_kept_clusters = 0;
+    for (uint32_t i = 0; i < clusters_of_hits.size(); ++i) {
+        if (not is_contained[i]) {
+            clusters_of_hits[nb_kept_clusters++] = clusters_of_hits[i];
+        }
+    }
+    clusters_of_hits.erase(
+        clusters_of_hits.begin() + nb_kept_clusters, clusters_of_hits.end());
     BOOST_LOG_TRIVIAL(trace) << "Now have " << clusters_of_hits.size()
                              << " clusters of hits";
 }
 
-void add_clusters_to_pangraph(
-    std::set<MinimizerHitCluster, clusterComp>& clusters_of_hits,
-    std::shared_ptr<pangenome::Graph> pangraph,
+void add_clusters_coverage_to_pangraph(
+    const std::vector<MinimizerHitClusterRange>& clusters_of_hits,
+    const std::vector<MinimizerHit>& hits, std::shared_ptr<pangenome::Graph> pangraph,
     const std::vector<std::shared_ptr<LocalPRG>>& prgs)
+{
+    // A pangraph storing the reads counts a read once per cluster on a node, and
+    // add_hits_to_kmergraphs() then adds all the hits of the read on the node once per
+    // copy of the read. To get the same coverages, the clusters of a read (which are
+    // contiguous) on the same PRG are merged, and added once per cluster.
+    std::vector<MinimizerHit> hits_of_read_on_prg;
+    auto read_begin = clusters_of_hits.begin();
+    while (read_begin != clusters_of_hits.end()) {
+        const uint32_t read_id = read_begin->read_id;
+        const auto read_end = std::find_if(read_begin, clusters_of_hits.end(),
+            [read_id](const MinimizerHitClusterRange& cluster) {
+                return cluster.read_id != read_id;
+            });
+
+        for (auto cluster = read_begin; cluster != read_end; ++cluster) {
+            const uint32_t prg_id = cluster->prg_id;
+            const auto is_on_prg = [prg_id](const MinimizerHitClusterRange& other) {
+                return other.prg_id == prg_id;
+            };
+            if (std::any_of(read_begin, cluster, is_on_prg)) {
+                continue; // already added with the first cluster on this PRG
+            }
+
+            hits_of_read_on_prg.clear();
+            uint32_t number_of_clusters = 0;
+            for (auto other = cluster; other != read_end; ++other) {
+                if (is_on_prg(*other)) {
+                    hits_of_read_on_prg.insert(hits_of_read_on_prg.end(),
+                        hits.begin() + other->begin, hits.begin() + other->end);
+                    ++number_of_clusters;
+                }
+            }
+            pangraph->add_coverage_between_PRG_and_read(prgs[prg_id], read_id,
+                hits_of_read_on_prg.cbegin(), hits_of_read_on_prg.cend(),
+                number_of_clusters);
+        }
+        read_begin = read_end;
+    }
+}
+
+void add_clusters_to_pangraph(
+    const std::vector<MinimizerHitClusterRange>& clusters_of_hits,
+    const std::vector<MinimizerHit>& hits, std::shared_ptr<pangenome::Graph> pangraph,
+    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const bool coverage_only)
 {
     BOOST_LOG_TRIVIAL(trace) << "Add inferred order to PanGraph";
     if (clusters_of_hits.empty()) {
         return;
     }
 
+    if (coverage_only) {
+        add_clusters_coverage_to_pangraph(clusters_of_hits, hits, pangraph, prgs);
+        return;
+    }
+
     // to do this consider pairs of clusters in turn
-    for (auto cluster : clusters_of_hits) {
+    for (const auto& cluster : clusters_of_hits) {
+        pangraph->add_hits_between_PRG_and_read(prgs[cluster.prg_id], cluster.read_id,
+            hits.begin() + cluster.begin, hits.begin() + cluster.end);
+    }
+}
 
-        pangraph->add_hits_between_PRG_and_read(prgs[(*cluster.begin())->get_prg_id()],
-            (*cluster.begin())->get_read_id(), cluster);
+void stage_localPRG_order_for_read(const std::vector<std::shared_ptr<LocalPRG>>& prgs,
+    std::shared_ptr<MinimizerHits> minimizer_hits,
+    MinimizerHitClusters& staged_clusters, const int max_diff,
+    const float& fraction_kmers_required_for_cluster, const uint32_t min_cluster_size,
+    const uint32_t expected_number_kmers_in_read_sketch, const bool chain,
+    MappingHistograms* histograms)
+{
+    if (minimizer_hits->hits.empty()) {
+        return;
     }
+
+    std::vector<MinimizerHitClusterRange> clusters_of_hits;
+    define_clusters(clusters_of_hits, prgs, minimizer_hits, max_diff,
+        fraction_kmers_required_for_cluster, min_cluster_size,
+        expected_number_kmers_in_read_sketch, chain, histograms);
+
+    const size_t nb_clusters_before_filter = clusters_of_hits.size();
+    filter_clusters(clusters_of_hits);
+    if (histograms) {
+        histograms->clusters_before_filter.add(nb_clusters_before_filter);
+        histograms->clusters_after_filter.add(clusters_of_hits.size());
+        histograms->nb_clusters_overlapping
+            += nb_clusters_before_filter - clusters_of_hits.size();
+    }
+    // filter_clusters2(clusters_of_hits, minimizer_hits->hits, genome_size);
+
+    staged_clusters.add(clusters_of_hits, minimizer_hits->hits);
 }
 
 void infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>>& prgs,
@@ -377,148 +632,355 @@ void infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>>
     std::shared_ptr<pangenome::Graph> pangraph, const int max_diff,
     const uint32_t& genome_size, const float& fraction_kmers_required_for_cluster,
     const uint32_t min_cluster_size,
-    const uint32_t expected_number_kmers_in_read_sketch)
+    const uint32_t expected_number_kmers_in_read_sketch, const bool chain)
 {
     // this step infers the gene order for a read and adds this to the pangraph
     // by defining clusters of hits, keeping those which are not noise and
     // then adding the inferred gene ordering
-    if (minimizer_hits->hits.empty()) {
-        return;
-    }
-
-    std::set<MinimizerHitCluster, clusterComp> clusters_of_hits;
-    define_clusters(clusters_of_hits, prgs, minimizer_hits, max_diff,
+    MinimizerHitClusters clusters;
+    stage_localPRG_order_for_read(prgs, minimizer_hits, clusters, max_diff,
         fraction_kmers_required_for_cluster, min_cluster_size,
-        expected_number_kmers_in_read_sketch);
-
-    filter_clusters(clusters_of_hits);
-    // filter_clusters2(clusters_of_hits, genome_size);
+        expected_number_kmers_in_read_sketch, chain);
 
 #pragma omp critical(pangraph)
     {
-        add_clusters_to_pangraph(clusters_of_hits, pangraph, prgs);
+        add_clusters_to_pangraph(clusters.clusters, clusters.hits, pangraph, prgs);
     }
 }
 
 // TODO: this should be in a constructor of pangenome::Graph or in a factory class
 uint32_t pangraph_from_read_file(const std::string& filepath,
     std::shared_ptr<pangenome::Graph> pangraph, std::shared_ptr<Index> index,
-    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const uint32_t w,
-    const uint32_t k, const int max_diff, const float& e_rate,
-    const uint32_t min_cluster_size, const uint32_t genome_size, const bool illumina,
-    const bool clean, const uint32_t max_covg, uint32_t threads)
+    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const MappingOptions& options,
+    MappingStats* mapping_stats)
+{
+    return pangraph_from_read_file(std::vector<std::string> { filepath }, pangraph,
+        index, prgs, options, mapping_stats);
+}
+
+uint32_t pangraph_from_read_file(const std::vector<std::string>& filepaths,
+    std::shared_ptr<pangenome::Graph> pangraph, std::shared_ptr<Index> index,
+    const std::vector<std::shared_ptr<LocalPRG>>& prgs, const MappingOptions& options,
+    MappingStats* mapping_stats)
 {
     // constant variables
-    const double fraction_kmers_required_for_cluster = 0.5 / exp(e_rate * k);
-    const uint32_t nb_reads_to_map_in_a_batch = 1000; // nb of reads to map in a batch
+    const double fraction_kmers_required_for_cluster
+        = 0.5 / exp(options.error_rate * options.kmer_size);
 
-    // shared variable - controlled by critical(covg)
-    uint64_t covg { 0 };
+    // in coverage-only mode, hits are turned into kmer coverage as clusters are added,
+    // and reads are not kept, so the pangraph can not be cleaned using them
+    if (options.coverage_only and options.clean) {
+        fatal_error(
+            "A coverage-only pangraph can not be cleaned, as it keeps no reads");
+    }
+
+    // if subsampling, reads are randomly kept to get to max_covg, instead of mapping
+    // the first reads up to max_covg
+    ReadSubsampler subsampler;
+    if (options.subsample) {
+        const bool reads_from_stdin = std::find(filepaths.begin(), filepaths.end(),
+                                          FastaqHandler::stdin_filepath)
+            != filepaths.end();
+        if (reads_from_stdin) {
+            fatal_error("Cannot subsample reads read from the standard input, as "
+                        "the number of bases of the reads is estimated from the file "
+                        "sizes");
+        }
+        const uint64_t total_nb_bases
+            = ReadSubsampler::estimate_number_of_bases(filepaths);
+        BOOST_LOG_TRIVIAL(info) << "Estimated " << total_nb_bases
+                                << " bases in the reads from their first reads";
+        subsampler = ReadSubsampler(ReadSubsampler::fraction_for_target_covg(
+            total_nb_bases, options.genome_size, options.max_covg));
+        BOOST_LOG_TRIVIAL(info)
+            << "Subsampling " << subsampler.get_fraction() * 100
+            << "% of the reads to get to a coverage of " << options.max_covg;
+    }
 
-    // shared variables - controlled by critical(ReadFileMutex)
-    FastaqHandler fh(filepath);
+    // shared variables - the coverage budget. Each thread accumulates the bases of its
+    // batch locally and adds them to covg once per batch, so max_covg can be exceeded
+    // by at most one batch per thread
+    std::atomic<uint64_t> covg { 0 };
+    std::atomic<bool> max_covg_exceeded { false };
+    const uint64_t max_nb_bases
+        = ((uint64_t)options.max_covg + 1) * options.genome_size;
+
+    // shared variables - the number of reads sketched, of those rejected because they
+    // have too few hits to have a cluster, and of those skipped because they exceed
+    // max_read_hits or max_read_prgs
+    std::atomic<uint64_t> nb_reads_sketched { 0 };
+    std::atomic<uint64_t> nb_reads_rejected { 0 };
+    std::atomic<uint64_t> nb_reads_with_too_many_hits { 0 };
+    std::atomic<uint64_t> nb_reads_with_too_many_prgs { 0 };
+
+    // shared variable - the histograms of each thread, merged at the end of the mapping
+    // under critical(mapping_histograms)
+    MappingHistograms histograms;
+
+    // shared variables - controlled by critical(ReadFileMutex). Exceptions can not
+    // leave the parallel region, so an error reading the files stops all threads and
+    // is reported after it
+    FastaqHandler fh(filepaths);
     uint32_t id { 0 };
+    uint64_t nb_bases_read { 0 };
+    std::string read_file_error;
 
 // parallel region
-#pragma omp parallel num_threads(threads)
+#pragma omp parallel num_threads(options.threads)
     {
-        // will hold the reads batch
-        std::vector<Seq> sequencesBuffer(
-            nb_reads_to_map_in_a_batch, Seq(0, "null", "", w, k));
+        // will hold the reads batch: the reads are stored contiguously in the batch and
+        // the Seq is just a view over the read being mapped, so no read is copied or
+        // allocated individually
+        ReadBatch batch;
+        Seq sequence;
+
+        // the hits of the read being mapped, and the buffers used to look them up,
+        // reused for all reads of this thread
+        auto minimizer_hits = std::make_shared<MinimizerHits>();
+        ReadHitsScratch read_hits_scratch;
+
+        // the clusters of the reads of the batch, added to the pangraph in bulk at the
+        // end of the batch, so that threads contend on the pangraph once per batch
+        // instead of once per read
+        MinimizerHitClusters staged_clusters;
+
+        // the histograms of the reads of this thread, only filled if asked for as they
+        // prevent add_read_hits() from stopping early
+        MappingHistograms thread_histograms;
+        MappingHistograms* const histograms_to_fill
+            = options.mapping_histograms ? &thread_histograms : nullptr;
+
+        // batches are bounded by number of bases, and resized from the time each
+        // batch takes to be mapped
+        ReadBatchSizer batch_sizer;
         while (true) {
             // read the next batch of reads
-            uint32_t nbOfReads = 0;
+            batch.clear();
 
 // read the reads in batch
 #pragma omp critical(ReadFileMutex)
             {
-                for (auto& sequence : sequencesBuffer) {
+                while (read_file_error.empty()
+                    and batch.get_number_of_bases() < batch_sizer.get_nb_bases()) {
                     if (id && id % 100000 == 0) {
                         BOOST_LOG_TRIVIAL(info) << id << " reads processed...";
                     }
                     try {
-                        fh.get_next();
+                        fh.get_next(batch, id);
                     } catch (std::out_of_range& err) {
                         break;
+                    } catch (std::runtime_error& err) {
+                        read_file_error = err.what();
+                        break;
                     }
-                    sequence.initialize(id, fh.name, fh.read, w, k);
-                    ++nbOfReads;
                     ++id;
                 }
+                nb_bases_read += batch.get_number_of_bases();
             }
+            const uint32_t nbOfReads = batch.size();
 
             if (nbOfReads == 0)
                 break; // we reached the end of the file, nothing else to map
 
             // quasimap the batch of reads
+            const auto batch_start_time = std::chrono::steady_clock::now();
             bool coverageExceeded = false;
+            uint64_t batch_covg { 0 };
+            uint64_t batch_nb_reads_sketched { 0 }, batch_nb_reads_rejected { 0 },
+                batch_nb_reads_with_too_many_hits { 0 },
+                batch_nb_reads_with_too_many_prgs { 0 };
             for (uint32_t i = 0; i < nbOfReads; i++) {
-                const auto& sequence = sequencesBuffer[i];
+                if (max_covg_exceeded.load(std::memory_order_relaxed)) {
+                    // another thread realised that we went past the max_covg
+                    coverageExceeded = true;
+                    break;
+                }
+
+                if (not subsampler.keep(batch.get_name(i))) {
+                    continue;
+                }
+
+                sequence.initialize_view(batch.get_id(i), batch.get_name(i),
+                    batch.get_sequence(i), options.window_size, options.kmer_size);
 
                 // checks if we are still good regarding coverage
-                if (!sequence.sketch.empty()) {
-#pragma omp critical(covg)
-                    {
-                        // check if the max_covg was already exceeded
-                        if (covg / genome_size > max_covg) {
-                            // if reached here, it means that another thread realised
-                            // that we went past the max_covg, so we just exit
-                            coverageExceeded = true;
-                        } else {
-                            // no other thread still signalized exceeding max coverage
-                            covg += sequence.seq.length();
-                            if (covg / genome_size > max_covg) {
-                                // oops, we are the first one to see max_covg being
-                                // exceeded, print and exit!
-                                BOOST_LOG_TRIVIAL(warning)
-                                    << "Stop processing reads as have reached max "
-                                       "coverage";
-                                coverageExceeded = true;
-                            }
-                        }
+                if (sequence.sketch.empty()) {
+                    continue;
+                }
+                batch_covg += sequence.seq.length();
+                if (covg.load(std::memory_order_relaxed) + batch_covg >= max_nb_bases) {
+                    const bool first_to_exceed = not max_covg_exceeded.exchange(true);
+                    if (first_to_exceed) {
+                        BOOST_LOG_TRIVIAL(warning)
+                            << "Stop processing reads as have reached max coverage";
                     }
+                    coverageExceeded = true;
+                    break; // max covg exceeded, get out
+                }
 
-                    if (coverageExceeded)
-                        break; // max covg exceeded, get out
-                } else {
+                const auto expected_number_kmers_in_read_sketch { sequence.seq.length()
+                    * 2 / (options.window_size + 1) };
+
+                // get the minizer hits, unless the read has too few hits to have a
+                // cluster, or too many to be mapped
+                minimizer_hits->clear();
+                ++batch_nb_reads_sketched;
+                const ReadHitsStatus read_hits_status
+                    = add_read_hits(sequence, minimizer_hits, *index,
+                        options.min_cluster_size, options.max_read_hits,
+                        options.max_read_prgs, histograms_to_fill, &read_hits_scratch);
+                if (read_hits_status != ReadHitsStatus::Added) {
+                    switch (read_hits_status) {
+                    case ReadHitsStatus::TooFewHits:
+                        ++batch_nb_reads_rejected;
+                        break;
+                    case ReadHitsStatus::TooManyHits:
+                        ++batch_nb_reads_with_too_many_hits;
+                        break;
+                    default:
+                        ++batch_nb_reads_with_too_many_prgs;
+                        break;
+                    }
                     continue;
                 }
 
-                const auto expected_number_kmers_in_read_sketch { sequence.seq.length()
-                    * 2 / (w + 1) };
+                // infer
+                stage_localPRG_order_for_read(prgs, minimizer_hits, staged_clusters,
+                    options.max_diff, fraction_kmers_required_for_cluster,
+                    options.min_cluster_size, expected_number_kmers_in_read_sketch,
+                    options.chain_hits, histograms_to_fill);
+            }
 
-                // get the minizer hits
-                auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
-                add_read_hits(sequence, minimizer_hits, *index);
+            if (not staged_clusters.empty()) {
+#pragma omp critical(pangraph)
+                {
+                    add_clusters_to_pangraph(staged_clusters.clusters,
+                        staged_clusters.hits, pangraph, prgs, options.coverage_only);
+                }
+                staged_clusters.clear();
+            }
 
-                // infer
-                infer_localPRG_order_for_reads(prgs, minimizer_hits, pangraph, max_diff,
-                    genome_size, fraction_kmers_required_for_cluster, min_cluster_size,
-                    expected_number_kmers_in_read_sketch);
+            // a SIGUSR1 report while mapping, when the pangraph can be inspected
+            if (memory_report_requested()) {
+#pragma omp critical(pangraph)
+                {
+                    MemoryBreakdown breakdown;
+                    breakdown.emplace_back("index", index->estimate_memory_usage());
+                    breakdown.emplace_back(
+                        "pangraph_reads", pangraph->estimate_reads_memory_usage());
+                    breakdown.emplace_back(
+                        "pangraph_nodes", pangraph->estimate_nodes_memory_usage());
+                    breakdown.emplace_back("kmer_graph_coverages",
+                        pangraph->estimate_kmer_graph_coverages_memory_usage());
+                    log_memory_breakdown("while mapping reads", breakdown);
+                }
             }
 
+            covg.fetch_add(batch_covg, std::memory_order_relaxed);
+            nb_reads_sketched.fetch_add(
+                batch_nb_reads_sketched, std::memory_order_relaxed);
+            nb_reads_rejected.fetch_add(
+                batch_nb_reads_rejected, std::memory_order_relaxed);
+            nb_reads_with_too_many_hits.fetch_add(
+                batch_nb_reads_with_too_many_hits, std::memory_order_relaxed);
+            nb_reads_with_too_many_prgs.fetch_add(
+                batch_nb_reads_with_too_many_prgs, std::memory_order_relaxed);
+
+            const std::chrono::duration<double> batch_time
+                = std::chrono::steady_clock::now() - batch_start_time;
+            batch_sizer.update(batch.get_number_of_bases(), batch_time.count());
+
             if (coverageExceeded)
                 break; // max_covg exceeded, get out
         }
+
+#pragma omp critical(mapping_histograms)
+        {
+            histograms.merge(thread_histograms);
+        }
+    }
+    if (not read_file_error.empty()) {
+        fatal_error("Error reading the read files: ", read_file_error);
     }
     BOOST_LOG_TRIVIAL(info) << "Processed " << id << " reads";
+    if (nb_reads_sketched > 0) {
+        BOOST_LOG_TRIVIAL(info)
+            << "Rejected " << nb_reads_rejected << " reads ("
+            << 100.0 * nb_reads_rejected / nb_reads_sketched
+            << "%) with too few hits to have a cluster of more than "
+            << options.min_cluster_size << " hits";
+    }
+    if (nb_reads_with_too_many_hits > 0) {
+        BOOST_LOG_TRIVIAL(info)
+            << "Skipped " << nb_reads_with_too_many_hits << " reads with more than "
+            << options.max_read_hits << " hits";
+    }
+    if (nb_reads_with_too_many_prgs > 0) {
+        BOOST_LOG_TRIVIAL(info)
+            << "Skipped " << nb_reads_with_too_many_prgs
+            << " reads with hits on more than " << options.max_read_prgs << " PRGs";
+    }
+
+    if (mapping_stats != nullptr) {
+        mapping_stats->nb_reads = id;
+        mapping_stats->nb_bases = nb_bases_read;
+        mapping_stats->nb_reads_sketched = nb_reads_sketched;
+        mapping_stats->nb_reads_rejected = nb_reads_rejected;
+        mapping_stats->nb_reads_with_too_many_hits = nb_reads_with_too_many_hits;
+        mapping_stats->nb_reads_with_too_many_prgs = nb_reads_with_too_many_prgs;
+        mapping_stats->has_histograms = options.mapping_histograms;
+        mapping_stats->histograms = histograms;
+    }
 
     BOOST_LOG_TRIVIAL(debug) << "Pangraph has " << pangraph->nodes.size() << " nodes";
+    pangraph->sort_node_reads(options.threads);
 
-    covg = covg / genome_size;
-    BOOST_LOG_TRIVIAL(debug) << "Estimated coverage: " << covg;
+    const uint64_t estimated_covg = covg.load() / options.genome_size;
+    BOOST_LOG_TRIVIAL(debug) << "Estimated coverage: " << estimated_covg;
 
-    if (illumina and clean) {
-        clean_pangraph_with_debruijn_graph(pangraph, 2, 1, illumina);
+    if (options.illumina and options.clean) {
+        clean_pangraph_with_debruijn_graph(
+            pangraph, 2, 1, options.illumina, options.threads);
         BOOST_LOG_TRIVIAL(debug)
             << "After cleaning, pangraph has " << pangraph->nodes.size() << " nodes";
-    } else if (clean) {
-        clean_pangraph_with_debruijn_graph(pangraph, 3, 1, illumina);
+    } else if (options.clean) {
+        clean_pangraph_with_debruijn_graph(
+            pangraph, 3, 1, options.illumina, options.threads);
         BOOST_LOG_TRIVIAL(debug)
             << "After cleaning, pangraph has " << pangraph->nodes.size() << " nodes";
     }
 
-    return covg;
+    return estimated_covg;
+}
+
+void add_mapping_counts(RunStats& run_stats, const MappingStats& mapping_stats)
+{
+    run_stats.add_count("reads", mapping_stats.nb_reads);
+    run_stats.add_count("bases", mapping_stats.nb_bases);
+    run_stats.add_count("reads_sketched", mapping_stats.nb_reads_sketched);
+    run_stats.add_count("reads_with_too_few_hits", mapping_stats.nb_reads_rejected);
+    run_stats.add_count(
+        "reads_with_too_many_hits", mapping_stats.nb_reads_with_too_many_hits);
+    run_stats.add_count(
+        "reads_with_too_many_loci", mapping_stats.nb_reads_with_too_many_prgs);
+
+    if (not mapping_stats.has_histograms) {
+        return;
+    }
+    const MappingHistograms& histograms = mapping_stats.histograms;
+    run_stats.add_count("clusters_below_min_cluster_size",
+        histograms.nb_clusters_below_min_cluster_size);
+    run_stats.add_count("clusters_below_length_threshold",
+        histograms.nb_clusters_below_length_threshold);
+    run_stats.add_count("clusters_overlapping", histograms.nb_clusters_overlapping);
+    run_stats.add_histogram("sketch_size", histograms.sketch_size);
+    run_stats.add_histogram("index_hits", histograms.index_hits);
+    run_stats.add_histogram("hits_per_locus", histograms.hits_per_prg);
+    run_stats.add_histogram(
+        "candidate_cluster_size", histograms.candidate_cluster_size);
+    run_stats.add_histogram(
+        "clusters_before_filter", histograms.clusters_before_filter);
+    run_stats.add_histogram("clusters_after_filter", histograms.clusters_after_filter);
 }
 
 void open_file_for_reading(const std::string& file_path, std::ifstream& stream)
@@ -591,25 +1053,34 @@ std::string transform_cli_gsize(std::string str)
     return int_to_string(strtogs(str.c_str()));
 }
 
-std::string make_absolute(std::string str) { return fs::absolute(str).string(); }
+std::string make_absolute(std::string str)
+{
+    if (str == FastaqHandler::stdin_filepath) {
+        return str;
+    }
+    return fs::absolute(str).string();
+}
 
-std::vector<std::pair<SampleIdText, SampleFpath>> load_read_index(
+std::vector<std::pair<SampleIdText, SampleFpaths>> load_read_index(
     const fs::path& read_index_fpath)
 {
-    std::map<SampleIdText, SampleFpath> samples;
+    std::map<SampleIdText, SampleFpaths> samples;
     std::string name, reads_path, line;
     fs::ifstream instream(read_index_fpath);
     if (instream.is_open()) {
         while (getline(instream, line).good()) {
             std::istringstream linestream(line);
             if (std::getline(linestream, name, '\t')) {
-                linestream >> reads_path;
                 if (samples.find(name) != samples.end()) {
                     BOOST_LOG_TRIVIAL(warning)
                         << "Warning: non-unique sample ids given! Only the last "
                            "of these will be kept";
                 }
-                samples[name] = reads_path;
+                SampleFpaths reads_paths;
+                while (linestream >> reads_path) {
+                    reads_paths.push_back(reads_path);
+                }
+                samples[name] = reads_paths;
             }
         }
     } else {
@@ -617,7 +1088,7 @@ std::vector<std::pair<SampleIdText, SampleFpath>> load_read_index(
     }
     BOOST_LOG_TRIVIAL(info) << "Finished loading " << samples.size()
                             << " samples from read index";
-    return std::vector<std::pair<SampleIdText, SampleFpath>>(
+    return std::vector<std::pair<SampleIdText, SampleFpaths>>(
         samples.begin(), samples.end());
 }
 
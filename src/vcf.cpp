@@ -1,4 +1,5 @@
 #include "vcf.h"
+#include "memory_usage.h"
 
 void VCF::add_record_core(const VCFRecord& vr)
 {
@@ -582,6 +583,16 @@ bool VCF::operator==(const VCF& y) const
     return true;
 }
 
+uint64_t VCF::estimate_memory_usage() const
+{
+    uint64_t bytes = sizeof(VCF) + ::estimate_heap_memory_usage(records);
+    for (const auto& record : records) {
+        bytes += shared_ptr_control_block_bytes + sizeof(VCFRecord)
+            + record->estimate_heap_memory_usage();
+    }
+    return bytes;
+}
+
 bool VCF::operator!=(const VCF& y) const { return !(*this == y); }
 
 void VCF::concatenate_VCFs(const std::vector<fs::path>& VCF_paths_to_be_concatenated,
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <boost/log/trivial.hpp>
 #include <vcfrecord.h>
+#include "memory_usage.h"
 
 VCFRecord::VCFRecord(VCF const* parent_vcf, const std::string& chrom, uint32_t pos,
     const std::string& ref, const std::string& alt, const std::string& info,
@@ -135,6 +136,24 @@ bool VCFRecord::operator==(const VCFRecord& y) const
 
 bool VCFRecord::operator!=(const VCFRecord& y) const { return !(*this == y); }
 
+uint64_t VCFRecord::estimate_heap_memory_usage() const
+{
+    uint64_t bytes = ::estimate_heap_memory_usage(id)
+        + ::estimate_heap_memory_usage(qual) + ::estimate_heap_memory_usage(filter)
+        + ::estimate_heap_memory_usage(info) + ::estimate_heap_memory_usage(ref)
+        + ::estimate_heap_memory_usage(alts) + ::estimate_heap_memory_usage(chrom);
+    for (const std::string& alt : alts) {
+        bytes += ::estimate_heap_memory_usage(alt);
+    }
+    bytes += ::estimate_heap_memory_usage(
+        sampleIndex_to_sampleInfo.sample_index_to_sample_info_container);
+    for (const SampleInfo& sample_info :
+        sampleIndex_to_sampleInfo.sample_index_to_sample_info_container) {
+        bytes += sample_info.estimate_heap_memory_usage();
+    }
+    return bytes;
+}
+
 bool VCFRecord::operator<(const VCFRecord& y) const
 {
     if (chrom < y.chrom) {
@@ -2,6 +2,8 @@
 #include <deque>
 #include <unordered_set>
 #include <unordered_map>
+#include <random>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "test_macro.cpp"
@@ -12,11 +14,17 @@ using namespace debruijn;
 
 TEST(DeBruijnGraphCreate, Initialize_SetsSizeAndNextId)
 {
-    GraphTester g(5);
-    EXPECT_EQ(g.size, (uint)5);
+    GraphTester g(4);
+    EXPECT_EQ(g.size, (uint)4);
     EXPECT_EQ(g.next_id, (uint)0);
 }
 
+TEST(DeBruijnGraphCreate, SizeOverPackedNodeIdsMaxSize_FatalRuntimeError)
+{
+    ASSERT_EXCEPTION(GraphTester(5), FatalRuntimeError,
+        "the size of its nodes (5) can not be more than 4");
+}
+
 TEST(DeBruijnGraphAddNode, AddNode_NodeHashInIndex)
 {
     GraphTester g(3);
@@ -25,7 +33,7 @@ TEST(DeBruijnGraphAddNode, AddNode_NodeHashInIndex)
     uint32_t read_id = 0;
     g.add_node(v, read_id);
 
-    bool found = g.node_hash.find(v) != g.node_hash.end();
+    bool found = g.node_hash.contains(pack_node_ids(v));
     EXPECT_TRUE(found);
 }
 
@@ -779,3 +787,65 @@ TEST(DeBruijnGraphTest, equals)
     EXPECT_NE(g1, g2);
     EXPECT_NE(g2, g1);
 }
+
+TEST(DeBruijnGraphBuild, SeveralThreads_SameGraphAsAddingNodesAndEdgesAlongSequences)
+{
+    // few distinct hashed node ids, so that windows repeat, also as reverse complements
+    // and palindromes, and a sequence too short for a window
+    std::mt19937 random_generator(42);
+    std::vector<uint32_t> read_ids;
+    std::vector<std::vector<uint_least32_t>> sequences;
+    for (uint32_t read_id = 0; read_id < 40; ++read_id) {
+        read_ids.push_back(read_id * 2);
+        sequences.emplace_back();
+        const uint32_t length = read_id == 7 ? 2 : 3 + random_generator() % 20;
+        for (uint32_t i = 0; i < length; ++i) {
+            sequences.back().push_back(random_generator() % 6);
+        }
+    }
+
+    GraphTester expected(3);
+    for (uint32_t s = 0; s < sequences.size(); ++s) {
+        OrientedNodePtr prev = std::make_pair(nullptr, false);
+        for (uint32_t i = 0; i + 3 <= sequences[s].size(); ++i) {
+            const std::deque<uint_least32_t> window(
+                sequences[s].begin() + i, sequences[s].begin() + i + 3);
+            OrientedNodePtr current = expected.add_node(window, read_ids[s]);
+            if (prev.first != nullptr) {
+                expected.add_edge(prev, current);
+            }
+            prev = current;
+        }
+    }
+
+    std::vector<uint_least32_t> hashed_node_ids;
+    std::vector<size_t> sequence_starts = { 0 };
+    for (const auto& sequence : sequences) {
+        hashed_node_ids.insert(hashed_node_ids.end(), sequence.begin(), sequence.end());
+        sequence_starts.push_back(hashed_node_ids.size());
+    }
+
+    for (const uint32_t threads : { 1, 4 }) {
+        GraphTester graph(3);
+        graph.build(read_ids, hashed_node_ids, sequence_starts, threads);
+
+        EXPECT_EQ(expected, graph);
+        EXPECT_EQ(expected.next_id, graph.next_id);
+        // the same ids, read ids, edges and order of the nodes
+        auto expected_it = expected.nodes.begin();
+        for (const auto& node_entry : graph.nodes) {
+            ASSERT_EQ(expected_it->first, node_entry.first);
+            const auto& expected_node = *expected_it->second;
+            EXPECT_ITERABLE_EQ(std::deque<uint_least32_t>,
+                expected_node.hashed_node_ids, node_entry.second->hashed_node_ids);
+            EXPECT_EQ(expected_node.read_ids, node_entry.second->read_ids);
+            EXPECT_EQ(expected_node.out_nodes, node_entry.second->out_nodes);
+            EXPECT_EQ(expected_node.in_nodes, node_entry.second->in_nodes);
+            EXPECT_EQ(
+                expected.node_hash.at(pack_node_ids(expected_node.hashed_node_ids)),
+                graph.node_hash.at(pack_node_ids(node_entry.second->hashed_node_ids)));
+            ++expected_it;
+        }
+        EXPECT_EQ(expected.get_unitigs(), graph.get_unitigs());
+    }
+}
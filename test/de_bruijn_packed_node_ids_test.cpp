@@ -0,0 +1,97 @@
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test_macro.cpp"
+#include "de_bruijn/packed_node_ids.h"
+#include "noise_filtering.h"
+#include "test_helpers.h"
+
+using namespace debruijn;
+
+TEST(DeBruijnPackNodeIds, FourNodeIds_UnpackedInOrder)
+{
+    const std::deque<uint_least32_t> hashed_node_ids = { 7, 0, UINT32_MAX - 1, 42 };
+
+    const PackedNodeIds ids = pack_node_ids(hashed_node_ids);
+
+    for (uint32_t i = 0; i < hashed_node_ids.size(); ++i) {
+        EXPECT_EQ(hashed_node_ids[i], ids.get(i));
+    }
+}
+
+TEST(DeBruijnPackNodeIds, FewerNodeIds_UnusedSlotsZero)
+{
+    const std::vector<uint_least32_t> hashed_node_ids = { 7, 3, 5, 42 };
+
+    const PackedNodeIds ids = pack_node_ids(hashed_node_ids.data(), 3);
+
+    EXPECT_EQ(pack_node_ids({ 7, 3, 5 }), ids);
+    EXPECT_EQ((uint_least32_t)5, ids.get(2));
+    EXPECT_EQ((uint_least32_t)0, ids.get(3));
+}
+
+TEST(DeBruijnPackNodeIds, ComparePacked_ComparesNodeIdsLexicographically)
+{
+    EXPECT_TRUE(pack_node_ids({ 1, 9, 9 }) < pack_node_ids({ 2, 0, 0 }));
+    EXPECT_TRUE(pack_node_ids({ 2, 0, 8 }) < pack_node_ids({ 2, 1, 0 }));
+    EXPECT_TRUE(pack_node_ids({ 2, 1, 0 }) < pack_node_ids({ 2, 1, 1 }));
+    EXPECT_FALSE(pack_node_ids({ 2, 1, 1 }) < pack_node_ids({ 2, 1, 1 }));
+    EXPECT_NE(pack_node_ids({ 2, 1 }), pack_node_ids({ 2, 1, 1 }));
+}
+
+TEST(DeBruijnPackNodeIds, TooManyNodeIds_FatalRuntimeError)
+{
+    ASSERT_EXCEPTION(pack_node_ids({ 1, 2, 3, 4, 5 }), FatalRuntimeError,
+        "at most 4 node ids can be packed, got 5");
+}
+
+TEST(DeBruijnPackNodeIds, ReverseComplement_SameAsRcHashedNodeIds)
+{
+    const std::deque<uint_least32_t> hashed_node_ids = { 4, 7, 10, 1 };
+    for (uint32_t size = 1; size <= PackedNodeIds::max_size; ++size) {
+        const std::deque<uint_least32_t> node(
+            hashed_node_ids.begin(), hashed_node_ids.begin() + size);
+
+        const PackedNodeIds rc = rc_packed_node_ids(pack_node_ids(node), size);
+
+        EXPECT_EQ(pack_node_ids(rc_hashed_node_ids(node)), rc);
+        EXPECT_EQ(pack_node_ids(node), rc_packed_node_ids(rc, size));
+    }
+}
+
+TEST(DeBruijnPackedNodeIdsMap, Emplace_FirstValueKept)
+{
+    PackedNodeIdsMap map;
+    EXPECT_TRUE(map.empty());
+
+    EXPECT_EQ(
+        std::make_pair((uint32_t)3, true), map.emplace(pack_node_ids({ 4, 6 }), 3));
+    EXPECT_EQ(
+        std::make_pair((uint32_t)3, false), map.emplace(pack_node_ids({ 4, 6 }), 5));
+
+    EXPECT_EQ((size_t)1, map.size());
+    EXPECT_TRUE(map.contains(pack_node_ids({ 4, 6 })));
+    EXPECT_FALSE(map.contains(pack_node_ids({ 6, 4 })));
+    EXPECT_EQ((uint32_t)3, map.at(pack_node_ids({ 4, 6 })));
+    EXPECT_THROW(map.at(pack_node_ids({ 6, 4 })), std::out_of_range);
+}
+
+TEST(DeBruijnPackedNodeIdsMap, ManyEntries_AllFoundAfterGrowing)
+{
+    PackedNodeIdsMap map;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        map.emplace(pack_node_ids({ i, i % 7, 3 }), i);
+    }
+
+    EXPECT_EQ((size_t)1000, map.size());
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(i, map.at(pack_node_ids({ i, i % 7, 3 })));
+    }
+    EXPECT_FALSE(map.contains(pack_node_ids({ 1000, 1000 % 7, 3 })));
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(pack_node_ids({ 0, 0, 3 })));
+}
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+#include "pangenome/dense_id_map.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+TEST(DenseIdMapTest, operatorBrackets_NewIds_EntriesInsertedOnce)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+    EXPECT_TRUE(map.empty());
+
+    map[5] = std::make_shared<int>(50);
+    map[2] = std::make_shared<int>(20);
+    map[5] = std::make_shared<int>(51);
+
+    EXPECT_EQ((size_t)2, map.size());
+    EXPECT_EQ((uint32_t)6, map.id_bound());
+    EXPECT_TRUE(map.contains(2));
+    EXPECT_FALSE(map.contains(3));
+    EXPECT_FALSE(map.contains(6));
+    EXPECT_EQ(51, *map.at(5));
+    EXPECT_EQ((size_t)1, map.count(2));
+    EXPECT_EQ((size_t)0, map.count(100));
+}
+
+TEST(DenseIdMapTest, operatorBrackets_AbsentId_DefaultValueInserted)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+
+    EXPECT_EQ(nullptr, map[3]);
+
+    EXPECT_EQ((size_t)1, map.size());
+    EXPECT_TRUE(map.find(3) != map.end());
+}
+
+TEST(DenseIdMapTest, at_AbsentId_OutOfRange)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+    map[1] = std::make_shared<int>(1);
+
+    EXPECT_THROW(map.at(0), std::out_of_range);
+    EXPECT_THROW(map.at(2), std::out_of_range);
+}
+
+TEST(DenseIdMapTest, iterate_EntriesVisitedInIdOrder)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+    for (const uint32_t id : { 7, 0, 3 }) {
+        map[id] = std::make_shared<int>(id * 10);
+    }
+
+    std::vector<uint32_t> ids;
+    for (const auto& entry : map) {
+        EXPECT_EQ((int)entry.first * 10, *entry.second);
+        ids.push_back(entry.first);
+    }
+    EXPECT_EQ((std::vector<uint32_t> { 0, 3, 7 }), ids);
+
+    const auto& const_map = map;
+    const auto it = std::find_if(const_map.begin(), const_map.end(),
+        [](const std::pair<uint32_t, std::shared_ptr<int>>& entry) {
+            return *entry.second == 30;
+        });
+    EXPECT_EQ((uint32_t)3, it->first);
+}
+
+TEST(DenseIdMapTest, erase_ById_EntryRemovedAndValueReleased)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+    auto value = std::make_shared<int>(1);
+    map[4] = value;
+
+    EXPECT_EQ((size_t)1, map.erase(4));
+    EXPECT_EQ((size_t)0, map.erase(4));
+    EXPECT_EQ((size_t)0, map.erase(40));
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(4));
+    EXPECT_TRUE(map.find(4) == map.end());
+    EXPECT_EQ(1, value.use_count());
+}
+
+TEST(DenseIdMapTest, erase_WhileIterating_NextEntryReturned)
+{
+    DenseIdMap<std::shared_ptr<int>> map;
+    for (uint32_t id = 0; id < 6; ++id) {
+        map[id] = std::make_shared<int>(id);
+    }
+
+    for (auto it = map.begin(); it != map.end();) {
+        if (*it->second % 2 == 0) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<uint32_t> ids;
+    for (const auto& entry : map) {
+        ids.push_back(entry.first);
+    }
+    EXPECT_EQ((std::vector<uint32_t> { 1, 3, 5 }), ids);
+    EXPECT_EQ((size_t)3, map.size());
+}
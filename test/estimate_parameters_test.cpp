@@ -1,4 +1,6 @@
 #include <stdint.h>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include "gtest/gtest.h"
 #include "pangenome/pangraph.h"
@@ -183,6 +185,117 @@ void setup_index_estimate_parameters(
     prgs[2]->minimizer_sketch(index, 1, 6);
 }
 
+// the options to map the reads of estimate_parameters_reads.fa to the PRGs of
+// setup_index_estimate_parameters()
+MappingOptions estimate_parameters_mapping_options()
+{
+    MappingOptions options;
+    options.window_size = 1;
+    options.kmer_size = 6;
+    options.max_diff = 1;
+    options.error_rate = 0.01;
+    options.min_cluster_size = 1;
+    options.genome_size = 22;
+    options.illumina = true;
+    return options;
+}
+
+TEST(EstimateParameters_AddHitsToKmergraphs, SeveralThreads_SameCoveragesAsOneThread)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    auto index = std::make_shared<Index>();
+    setup_index_estimate_parameters(prgs, index);
+
+    const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads.fa";
+    auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
+    pangraph->add_hits_to_kmergraphs(0, 1);
+    auto pangraph_threads = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    pangraph_from_read_file(filepath, pangraph_threads, index, prgs,
+        estimate_parameters_mapping_options());
+    pangraph_threads->add_hits_to_kmergraphs(0, 4);
+
+    ASSERT_FALSE(pangraph->nodes.empty());
+    ASSERT_EQ(pangraph->nodes.size(), pangraph_threads->nodes.size());
+    for (const auto& node_entry : pangraph->nodes) {
+        const auto& kg = node_entry.second->kmer_prg_with_coverage;
+        const auto& kg_threads
+            = pangraph_threads->nodes.at(node_entry.first)->kmer_prg_with_coverage;
+        EXPECT_EQ(kg.get_num_reads(), kg_threads.get_num_reads());
+        for (uint32_t i = 0; i < kg.kmer_prg->nodes.size(); ++i) {
+            EXPECT_EQ(kg.get_forward_covg(i, 0), kg_threads.get_forward_covg(i, 0));
+            EXPECT_EQ(kg.get_reverse_covg(i, 0), kg_threads.get_reverse_covg(i, 0));
+        }
+    }
+}
+
+// maps the reads into pangraph, and without storing them (--coverage-only) into
+// another pangraph, and checks both give the same node and kmer coverages
+void expect_coverage_only_same_coverages(
+    const std::string& filepath, std::shared_ptr<pangenome::Graph>& pangraph)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    auto index = std::make_shared<Index>();
+    setup_index_estimate_parameters(prgs, index);
+
+    pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
+    pangraph->add_hits_to_kmergraphs();
+    auto coverage_only_pangraph
+        = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    MappingOptions coverage_only_options = estimate_parameters_mapping_options();
+    coverage_only_options.threads = 2;
+    coverage_only_options.coverage_only = true;
+    pangraph_from_read_file(
+        filepath, coverage_only_pangraph, index, prgs, coverage_only_options);
+
+    EXPECT_TRUE(coverage_only_pangraph->reads.empty());
+    ASSERT_FALSE(pangraph->nodes.empty());
+    ASSERT_EQ(pangraph->nodes.size(), coverage_only_pangraph->nodes.size());
+    for (const auto& node_entry : pangraph->nodes) {
+        const auto& coverage_only_node
+            = coverage_only_pangraph->nodes.at(node_entry.first);
+        EXPECT_TRUE(coverage_only_node->reads.empty());
+        EXPECT_EQ(node_entry.second->covg, coverage_only_node->covg);
+        const auto& kg = node_entry.second->kmer_prg_with_coverage;
+        const auto& coverage_only_kg = coverage_only_node->kmer_prg_with_coverage;
+        EXPECT_EQ(kg.get_num_reads(), coverage_only_kg.get_num_reads());
+        for (uint32_t i = 0; i < kg.kmer_prg->nodes.size(); ++i) {
+            EXPECT_EQ(
+                kg.get_forward_covg(i, 0), coverage_only_kg.get_forward_covg(i, 0));
+            EXPECT_EQ(
+                kg.get_reverse_covg(i, 0), coverage_only_kg.get_reverse_covg(i, 0));
+        }
+    }
+}
+
+TEST(EstimateParameters_AddHitsToKmergraphs, CoverageOnly_SameCoveragesWithoutReads)
+{
+    std::shared_ptr<pangenome::Graph> pangraph;
+    expect_coverage_only_same_coverages(
+        TEST_CASE_DIR + "estimate_parameters_reads.fa", pangraph);
+}
+
+TEST(EstimateParameters_AddHitsToKmergraphs,
+    CoverageOnlyReadCoveringLocusTwice_SameCoveragesWithoutReads)
+{
+    // the read has two clusters on the first PRG, so it is counted twice on its node
+    const std::string filepath = std::string(std::tmpnam(nullptr)) + ".fa";
+    {
+        std::ofstream reads_file(filepath);
+        reads_file << ">0\nAAAGGGGTTTTTTTTACAGACGTCCCCCCCCCCAAAGGGGTTTTTTTTACAGACGT\n";
+    }
+
+    std::shared_ptr<pangenome::Graph> pangraph;
+    expect_coverage_only_same_coverages(filepath, pangraph);
+    std::remove(filepath.c_str());
+
+    ASSERT_TRUE(pangraph->nodes.contains(0));
+    EXPECT_EQ((uint32_t)2, pangraph->nodes.at(0)->covg);
+}
+
 TEST(EstimateParameters_EstimateParameters, NoPangraphNodes)
 {
     auto outdir = "test";
@@ -204,15 +317,14 @@ TEST(EstimateParameters_EstimateParameters, PangraphWithNodes_SimpleBinomial)
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 10, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 10, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = true, illumina = true;
+    bool bin = true;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -228,15 +340,14 @@ TEST(
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 10, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 10, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = true, illumina = true;
+    bool bin = true;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads3.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -251,15 +362,14 @@ TEST(EstimateParameters_EstimateParameters, PangraphWithNodes_SimpleNegativeBino
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 10, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 10, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = false, illumina = true;
+    bool bin = false;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -275,15 +385,14 @@ TEST(EstimateParameters_EstimateParameters,
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 32, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 32, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = false, illumina = true;
+    bool bin = false;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads4.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -300,15 +409,14 @@ TEST(EstimateParameters_EstimateParameters,
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 32, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 32, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = true, illumina = true;
+    bool bin = true;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads4.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -324,15 +432,14 @@ TEST(EstimateParameters_EstimateParameters, PangraphWithNodes_NoiseReads)
     setup_index_estimate_parameters(prgs, index);
 
     auto outdir = "estimate_parameters_test";
-    uint32_t w = 1, k = 6, covg = 10, sample_id = 0, min_cluster_size = 1,
-             genome_size = 22;
+    uint32_t k = 6, covg = 10, sample_id = 0;
     float e_rate = 0.01;
-    bool bin = false, illumina = true;
+    bool bin = false;
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
     const auto filepath = TEST_CASE_DIR + "estimate_parameters_reads2.fa";
-    pangraph_from_read_file(filepath, pangraph, index, prgs, w, k, 1, e_rate,
-        min_cluster_size, genome_size, illumina);
+    pangraph_from_read_file(
+        filepath, pangraph, index, prgs, estimate_parameters_mapping_options());
     pangraph->add_hits_to_kmergraphs();
 
     auto expected_depth_covg
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include "gtest/gtest.h"
 #include "fastaq_handler.h"
+#include "fatal_error.h"
+#include "test_helpers.h"
 
 using namespace std;
 
@@ -10,7 +12,8 @@ const std::string TEST_CASE_DIR = "../../test/test_cases/";
 
 TEST(FastaqHandlerTest, non_existant_file_throws_exception)
 {
-    EXPECT_THROW(FastaqHandler fh("fake.file"), std::ios_base::failure);
+    ASSERT_EXCEPTION(FastaqHandler fh("fake.file"), FatalRuntimeError,
+        "Unable to open read file fake.file");
 }
 
 TEST(FastaqHandlerTest, create_fa)
@@ -73,6 +76,32 @@ TEST(FastaqHandlerTest, get_next)
     EXPECT_THROW(fh.get_next(), std::out_of_range);
 }
 
+TEST(FastaqHandlerTest, get_next_into_batch)
+{
+    FastaqHandler fh(TEST_CASE_DIR + "reads.fa");
+    ReadBatch batch;
+    fh.get_next(batch, 10);
+    fh.get_next(batch, 11);
+    EXPECT_EQ((uint32_t)2, fh.num_reads_parsed);
+    EXPECT_TRUE(fh.name.empty());
+    EXPECT_TRUE(fh.read.empty());
+
+    EXPECT_EQ((size_t)2, batch.size());
+    EXPECT_EQ((uint32_t)10, batch.get_id(0));
+    EXPECT_EQ("read0", batch.get_name(0));
+    EXPECT_EQ("to be ignored", batch.get_sequence(0));
+    EXPECT_EQ((uint32_t)11, batch.get_id(1));
+    EXPECT_EQ("read1", batch.get_name(1));
+    EXPECT_EQ("should copy the phrase *should*", batch.get_sequence(1));
+
+    fh.get_next(batch, 12);
+    fh.get_next(batch, 13);
+    fh.get_next(batch, 14);
+    EXPECT_EQ((size_t)5, batch.size());
+    EXPECT_THROW(fh.get_next(batch, 15), std::out_of_range);
+    EXPECT_EQ((size_t)5, batch.size());
+}
+
 TEST(FastaqHandlerTest, eof)
 {
     FastaqHandler fh(TEST_CASE_DIR + "reads.fa");
@@ -316,4 +345,72 @@ TEST(FastaqHandlerTest, get_next_on_empty_file_throws_exception)
     FastaqHandler fh(filepath);
     EXPECT_FALSE(fh.eof());
     EXPECT_THROW(fh.get_next(), std::out_of_range);
-}
\ No newline at end of file
+}
+TEST(FastaqHandlerTest, multiple_files_are_read_as_one_stream)
+{
+    const std::string empty_filepath = std::tmpnam(nullptr);
+    {
+        std::ofstream outstream(empty_filepath);
+        outstream << "";
+    }
+
+    FastaqHandler fh(std::vector<std::string> { TEST_CASE_DIR + "reads.fa",
+        empty_filepath, TEST_CASE_DIR + "reads.fq.gz" });
+    EXPECT_EQ(TEST_CASE_DIR + "reads.fa", fh.filepath);
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        fh.get_next();
+        EXPECT_EQ("read" + std::to_string(i), fh.name);
+    }
+    EXPECT_FALSE(fh.eof());
+
+    fh.get_next();
+    EXPECT_EQ(TEST_CASE_DIR + "reads.fq.gz", fh.filepath);
+    EXPECT_EQ((uint32_t)6, fh.num_reads_parsed);
+    EXPECT_EQ("read0", fh.name);
+    EXPECT_EQ("to be ignored", fh.read);
+
+    for (uint32_t i = 1; i < 5; ++i) {
+        fh.get_next();
+        EXPECT_EQ("read" + std::to_string(i), fh.name);
+    }
+    EXPECT_EQ((uint32_t)10, fh.num_reads_parsed);
+    EXPECT_THROW(fh.get_next(), std::out_of_range);
+}
+
+TEST(FastaqHandlerTest, get_nth_read_across_multiple_files)
+{
+    FastaqHandler fh(std::vector<std::string> { TEST_CASE_DIR + "reads.fa",
+        TEST_CASE_DIR + "reads.fq.gz" });
+
+    fh.get_nth_read(6);
+    EXPECT_EQ((uint32_t)7, fh.num_reads_parsed);
+    EXPECT_EQ("read1", fh.name);
+    EXPECT_EQ("should copy the phrase *should*", fh.read);
+
+    fh.get_nth_read(2);
+    EXPECT_EQ((uint32_t)3, fh.num_reads_parsed);
+    EXPECT_EQ(TEST_CASE_DIR + "reads.fa", fh.filepath);
+    EXPECT_EQ("read2", fh.name);
+    EXPECT_EQ("this time we should get *is time *", fh.read);
+}
+
+TEST(FastaqHandlerTest, no_files_throws_exception)
+{
+    EXPECT_THROW(FastaqHandler fh(std::vector<std::string> {}), std::ios_base::failure);
+}
+
+TEST(FastaqHandlerTest, stdin_given_twice_throws_exception)
+{
+    EXPECT_THROW(FastaqHandler fh(std::vector<std::string> {
+                     FastaqHandler::stdin_filepath, FastaqHandler::stdin_filepath }),
+        std::ios_base::failure);
+}
+
+TEST(FastaqHandlerTest, non_existant_second_file_throws_exception_before_reading)
+{
+    const std::vector<std::string> filepaths { TEST_CASE_DIR + "reads.fa",
+        "fake.file" };
+    ASSERT_EXCEPTION(FastaqHandler fh(filepaths), FatalRuntimeError,
+        "Unable to open read file fake.file");
+}
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "memory_usage.h"
+#include "index.h"
+#include "inthash.h"
+#include "pangenome/pangraph.h"
+#include "test_helpers.h"
+#include "vcf.h"
+#include <csignal>
+#include <deque>
+#include <unordered_map>
+
+TEST(MemoryUsageTest, estimateHeapMemoryUsage_Vector_CapacityTimesElementSize)
+{
+    std::vector<uint32_t> v;
+    v.reserve(100);
+    EXPECT_EQ(400, estimate_heap_memory_usage(v));
+}
+
+TEST(MemoryUsageTest, estimateHeapMemoryUsage_ShortString_NoHeapAllocation)
+{
+    EXPECT_EQ(0, estimate_heap_memory_usage(std::string("ACGT")));
+    EXPECT_GT(estimate_heap_memory_usage(std::string(100, 'A')), 100);
+}
+
+TEST(MemoryUsageTest, estimateHashTableHeapMemoryUsage_MoreEntries_MoreMemory)
+{
+    std::unordered_map<uint64_t, uint64_t> table;
+    const uint64_t empty_bytes = estimate_hash_table_heap_memory_usage(table);
+    for (uint64_t i = 0; i < 100; ++i) {
+        table[i] = i;
+    }
+    EXPECT_GE(estimate_hash_table_heap_memory_usage(table),
+        empty_bytes + 100 * sizeof(std::pair<const uint64_t, uint64_t>));
+}
+
+TEST(MemoryUsageTest, getCurrentRssBytes_Positive)
+{
+    EXPECT_GT(get_current_rss_bytes(), 0);
+}
+
+TEST(MemoryUsageTest, memoryReportRequested_Sigusr1Raised_RequestedOnce)
+{
+    install_memory_report_signal_handler();
+    EXPECT_FALSE(memory_report_requested());
+    std::raise(SIGUSR1);
+    EXPECT_TRUE(memory_report_requested());
+    EXPECT_FALSE(memory_report_requested());
+}
+
+TEST(MemoryUsageTest, indexEstimateMemoryUsage_RecordsAdded_MemoryIncreases)
+{
+    Index index;
+    const uint64_t empty_bytes = index.estimate_memory_usage();
+    EXPECT_GE(empty_bytes, sizeof(Index));
+
+    KmerHash hash;
+    std::deque<Interval> intervals = { Interval(3, 5), Interval(9, 12) };
+    prg::Path path;
+    path.initialize(intervals);
+    const auto kmer_hash = hash.kmerhash("ACGTA", 5);
+    index.add_record(std::min(kmer_hash.first, kmer_hash.second), 1, path, 0, 0);
+
+    EXPECT_GE(index.estimate_memory_usage(),
+        empty_bytes + sizeof(MiniRecord) + 2 * sizeof(Interval));
+}
+
+TEST(MemoryUsageTest, pangraphEstimateMemoryUsage_ReadsAndNodesAdded_MemoryIncreases)
+{
+    pangenome::Graph pangraph;
+    const uint64_t empty_reads_bytes = pangraph.estimate_reads_memory_usage();
+    const uint64_t empty_nodes_bytes = pangraph.estimate_nodes_memory_usage();
+
+    pangraph.add_read(0);
+    pangraph.add_node(std::make_shared<LocalPRG>(0, "prg", "A"));
+
+    EXPECT_GE(pangraph.estimate_reads_memory_usage(),
+        empty_reads_bytes + sizeof(pangenome::Read));
+    EXPECT_GE(pangraph.estimate_nodes_memory_usage(),
+        empty_nodes_bytes + sizeof(pangenome::Node));
+}
+
+TEST(MemoryUsageTest, vcfEstimateMemoryUsage_RecordsAdded_MemoryIncreases)
+{
+    VCF vcf = create_VCF_with_default_parameters();
+    const uint64_t empty_bytes = vcf.estimate_memory_usage();
+
+    vcf.add_record("chrom1", 5, "A", "G");
+    vcf.add_record("chrom1", 10, std::string(100, 'A'), "G");
+
+    EXPECT_GE(vcf.estimate_memory_usage(), empty_bytes + 2 * sizeof(VCFRecord) + 100);
+}
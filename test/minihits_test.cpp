@@ -6,6 +6,8 @@
 #include "interval.h"
 #include "prg/path.h"
 #include "inthash.h"
+#include "fatal_error.h"
+#include "test_helpers.h"
 #include <stdint.h>
 #include <iostream>
 #include <algorithm>
@@ -85,13 +87,13 @@ TEST(MinimizerHitsTest, pComp)
     mhits.add_hit(1, m3, mr3);
     expected.push_back(MinimizerHit(1, m3, mr3));
 
+    mhits.sort();
     uint32_t j(1);
-    for (set<MinimizerHitPtr, pComp>::iterator it = mhits.hits.begin();
-         it != --mhits.hits.end(); ++it) {
-        EXPECT_EQ(expected[j], **it);
+    for (auto it = mhits.hits.begin(); it != --mhits.hits.end(); ++it) {
+        EXPECT_EQ(expected[j], *it);
         j++;
     }
-    EXPECT_EQ(expected[0], **(--mhits.hits.end()));
+    EXPECT_EQ(expected[0], *(--mhits.hits.end()));
 }
 
 TEST(MinimizerHitsTest, pComp_path)
@@ -131,9 +133,9 @@ TEST(MinimizerHitsTest, pComp_path)
     mhits.add_hit(1, m4, mr4);
     expected.push_front(MinimizerHit(1, m4, mr4));
 
-    for (set<MinimizerHitPtr, pComp>::iterator it = mhits.hits.begin();
-         it != --mhits.hits.end(); ++it) {
-        mhitspath.insert(*it);
+    mhits.sort();
+    for (auto it = mhits.hits.begin(); it != --mhits.hits.end(); ++it) {
+        mhitspath.insert(make_shared<MinimizerHit>(*it));
     }
     uint32_t j(0);
     for (set<MinimizerHitPtr, pComp_path>::iterator it = mhitspath.begin();
@@ -143,6 +145,55 @@ TEST(MinimizerHitsTest, pComp_path)
     }
 }
 
+TEST(MinimizerHitsTest, sort_orders_as_operator_less_and_removes_duplicates)
+{
+    MinimizerHits mhits;
+    vector<MinimizerHit> expected;
+    vector<MiniRecord> records;
+    for (uint32_t prg_id : { 0, 3, 300, 70000 }) {
+        for (uint32_t path_start : { 4, 1 }) {
+            deque<Interval> d = { Interval(path_start, path_start + 5) };
+            prg::Path p;
+            p.initialize(d);
+            records.emplace_back(prg_id, p, 0, prg_id % 2);
+        }
+    }
+
+    // hits are added in an order that is not sorted, on several reads, with reads
+    // positions spanning several bytes, and each hit is added twice
+    for (uint32_t read_id : { 257, 2, 0 }) {
+        for (uint32_t read_pos : { 100000, 3, 512, 0 }) {
+            for (bool read_strand : { true, false }) {
+                for (const auto& record : records) {
+                    Minimizer m(0, read_pos, read_pos + 5, read_strand);
+                    mhits.add_hit(read_id, m, record);
+                    mhits.add_hit(read_id, m, record);
+                    expected.emplace_back(read_id, m, record);
+                }
+            }
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    mhits.sort();
+
+    EXPECT_EQ(expected, mhits.hits);
+}
+
+TEST(MinimizerHitsTest, sort_prg_id_too_large_FatalRuntimeError)
+{
+    deque<Interval> d = { Interval(0, 5) };
+    prg::Path p;
+    p.initialize(d);
+    MinimizerHits mhits;
+    for (uint32_t prg_id : { (uint32_t)3, MinimizerHits::max_sortable_prg_id + 3 }) {
+        Minimizer m(0, 0, 5, true);
+        mhits.add_hit(0, m, MiniRecord(prg_id, p, 0, 0));
+    }
+
+    ASSERT_EXCEPTION(mhits.sort(), FatalRuntimeError, "PRG id 2147483651 is too large");
+}
+
 TEST(MinimizerHitsTest, clusterComp)
 {
     set<set<MinimizerHitPtr, pComp>, clusterComp> clusters_of_hits;
@@ -208,3 +259,37 @@ TEST(MinimizerHitsTest, clusterComp)
             true);
     }
 }
+
+TEST(MinimizerHitClustersTest, add_copies_only_the_hits_of_the_clusters)
+{
+    deque<Interval> d = { Interval(0, 5) };
+    prg::Path p;
+    p.initialize(d);
+    MiniRecord mr0(0, p, 0, 0);
+    MiniRecord mr1(1, p, 0, 0);
+
+    MinimizerHits mhits;
+    for (uint32_t i = 0; i != 3; ++i) {
+        mhits.add_hit(1, Minimizer(0, i, i + 5, 0), mr0);
+        mhits.add_hit(1, Minimizer(0, i, i + 5, 0), mr1);
+    }
+    mhits.sort();
+    std::vector<MinimizerHitClusterRange> clusters { { mhits.hits, 3, 6 } };
+
+    MinimizerHitClusters staged;
+    staged.add(clusters, mhits.hits);
+    staged.add(clusters, mhits.hits);
+
+    EXPECT_EQ(staged.clusters.size(), (uint)2);
+    EXPECT_EQ(staged.hits.size(), (uint)6);
+    EXPECT_EQ(staged.clusters[1].begin, (uint)3);
+    EXPECT_EQ(staged.clusters[1].end, (uint)6);
+    EXPECT_EQ(staged.clusters[1].prg_id, (uint)1);
+    for (const auto& hit : staged.hits) {
+        EXPECT_EQ(hit.get_prg_id(), (uint)1);
+    }
+
+    staged.clear();
+    EXPECT_TRUE(staged.empty());
+    EXPECT_TRUE(staged.hits.empty());
+}
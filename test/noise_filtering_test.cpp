@@ -530,7 +530,8 @@ TEST(NoiseFilteringRemoveLeaves, OneLoopAndDeviantPath_OneLeafRemoved)
     EXPECT_EQ(pangraph->nodes.size(), pg_size - 1);
     EXPECT_TRUE(pangraph->nodes.find(7) == pangraph->nodes.end());
     EXPECT_EQ(dbg.nodes.size(), dbg_size - 1);
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 4, 6, 14 }]) == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 4, 6, 14 })))
+        == dbg.nodes.end());
 }
 
 TEST(NoiseFilteringRemoveLeaves, OneLoopAndIncorrectPath_TwoLeavesRemoved)
@@ -576,8 +577,10 @@ TEST(NoiseFilteringRemoveLeaves, OneLoopAndIncorrectPath_TwoLeavesRemoved)
 
     EXPECT_EQ(pangraph->nodes.size(), pg_size);
     EXPECT_EQ(dbg.nodes.size(), dbg_size - 2);
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 0, 10, 6 }]) == dbg.nodes.end());
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 10, 6, 8 }]) == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 0, 10, 6 })))
+        == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 10, 6, 8 })))
+        == dbg.nodes.end());
 }
 
 TEST(NoiseFilteringRemoveLeaves, OneLoopAndDeviatesInMiddle_NoLeavesRemoved)
@@ -674,9 +677,12 @@ TEST(NoiseFilteringRemoveLeaves, OneLoopAndLongerWrongPath_LeavesRemoved)
     EXPECT_TRUE(pangraph->nodes.find(6) == pangraph->nodes.end());
     EXPECT_TRUE(pangraph->nodes.find(7) == pangraph->nodes.end());
     EXPECT_EQ(dbg.nodes.size(), dbg_size - 3);
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 12, 2, 14 }]) == dbg.nodes.end());
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 2, 14, 12 }]) == dbg.nodes.end());
-    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash[{ 14, 12, 6 }]) == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 12, 2, 14 })))
+        == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 2, 14, 12 })))
+        == dbg.nodes.end());
+    EXPECT_TRUE(dbg.nodes.find(dbg.node_hash.at(debruijn::pack_node_ids({ 14, 12, 6 })))
+        == dbg.nodes.end());
 }
 
 TEST(NoiseFilteringRemoveLeaves, AllTogether_GraphsLookCorrect)
@@ -1524,6 +1530,48 @@ TEST(NoiseFilteringFilterUnitigs, AllTogether_PanGraphIsAsExpected)
     EXPECT_EQ(pg_exp, *pangraph);
 }
 
+TEST(NoiseFilteringFilterUnitigs, SeveralThreads_SameAsOneThread)
+{
+    set<MinimizerHitPtr, pComp> dummy_cluster;
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    for (uint32_t id = 0; id < 24; ++id) {
+        prgs.push_back(std::make_shared<LocalPRG>(id, std::to_string(id), ""));
+    }
+    // two copies of the reads of the AllTogether test, on disjoint PRGs so that the dbg
+    // has two components
+    const std::vector<std::vector<uint32_t>> prgs_of_reads = { { 0, 1, 2, 3, 4, 5 },
+        { 1, 2, 3, 7 }, { 0, 5, 3, 4 }, { 0, 1, 2, 6, 3, 4, 5 },
+        { 0, 1, 2, 9, 10, 11, 3, 4, 5 } };
+    const auto make_pangraph = [&]() {
+        auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+        uint32_t read_id = 0;
+        for (const uint32_t offset : { 0, 12 }) {
+            for (const auto& prgs_of_read : prgs_of_reads) {
+                for (const auto& prg_id : prgs_of_read) {
+                    pangraph->add_hits_between_PRG_and_read(
+                        prgs[prg_id + offset], read_id, dummy_cluster);
+                }
+                ++read_id;
+            }
+        }
+        return pangraph;
+    };
+
+    auto pangraph_one_thread = make_pangraph();
+    debruijn::Graph dbg_one_thread(3);
+    construct_debruijn_graph(pangraph_one_thread, dbg_one_thread);
+    filter_unitigs(pangraph_one_thread, dbg_one_thread, 1);
+
+    auto pangraph = make_pangraph();
+    debruijn::Graph dbg(3);
+    construct_debruijn_graph(pangraph, dbg, 4);
+    filter_unitigs(pangraph, dbg, 1, 4);
+
+    EXPECT_EQ(*pangraph_one_thread, *pangraph);
+    EXPECT_EQ(dbg_one_thread, dbg);
+    EXPECT_NE(pangraph->nodes.size(), make_pangraph()->nodes.size());
+}
+
 /*TEST(NoiseFilteringFilterUnitigs,AllTogether_DbgIsAsExpected)
 {
     set<MinimizerHitPtr, pComp> mhs;
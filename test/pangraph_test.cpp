@@ -208,7 +208,7 @@ TEST(PangenomeGraph_add_hits_between_PRG_and_read, AddClusters)
         EXPECT_EQ(pg.get_node(prg_id_1)->covg, 1); // is the coverage of the node 1?
         EXPECT_EQ(pg.get_node(prg_id_1)->reads.size(),
             1); // is the read really inserted in the node?
-        EXPECT_EQ(pg.get_node(prg_id_1)->reads.begin()->get()->id,
+        EXPECT_EQ((*pg.get_node(prg_id_1)->reads.begin())->id,
             read_id_1); // is the read really inserted in the node?
         EXPECT_EQ(pg.reads.size(), 1);
         EXPECT_EQ(pg.get_read(read_id_1)->id, read_id_1); // is the read really
@@ -249,9 +249,9 @@ TEST(PangenomeGraph_add_hits_between_PRG_and_read, AddClusters)
             1); // is the read really inserted in the node?
         EXPECT_EQ(pg.get_node(prg_id_2)->reads.size(),
             1); // is the read really inserted in the node?
-        EXPECT_EQ(pg.get_node(prg_id_1)->reads.begin()->get()->id,
+        EXPECT_EQ((*pg.get_node(prg_id_1)->reads.begin())->id,
             read_id_1); // is the read really inserted in the node?
-        EXPECT_EQ(pg.get_node(prg_id_2)->reads.begin()->get()->id,
+        EXPECT_EQ((*pg.get_node(prg_id_2)->reads.begin())->id,
             read_id_1); // is the read really inserted in the node?
         EXPECT_EQ(pg.reads.size(), 1);
         EXPECT_EQ(pg.get_read(read_id_1)->id, read_id_1); // is the read really
@@ -295,7 +295,7 @@ TEST(PangenomeGraph_add_hits_between_PRG_and_read, AddClusters)
         EXPECT_EQ(pg.get_node(prg_id_2)->reads.size(),
             1); // is the read really inserted in the node?
 
-        std::vector<ReadPtr> reads_in_node_as_vector(
+        std::vector<pangenome::Read*> reads_in_node_as_vector(
             pg.get_node(prg_id_1)->reads.begin(), pg.get_node(prg_id_1)->reads.end());
         EXPECT_TRUE((reads_in_node_as_vector[0]->id == read_id_1
                         && reads_in_node_as_vector[1]->id == read_id_3)
@@ -386,7 +386,7 @@ TEST(PangenomeGraph_add_hits_between_PRG_and_read, AddTheSameClusterTwice)
         EXPECT_EQ(pg.get_node(prg_id_1)->covg, 1); // is the coverage of the node 1?
         EXPECT_EQ(pg.get_node(prg_id_1)->reads.size(),
             1); // is the read really inserted in the node?
-        EXPECT_EQ(pg.get_node(prg_id_1)->reads.begin()->get()->id,
+        EXPECT_EQ((*pg.get_node(prg_id_1)->reads.begin())->id,
             read_id_1); // is the read really inserted in the node?
         EXPECT_EQ(pg.reads.size(), 1);
         EXPECT_EQ(pg.get_read(read_id_1)->id, read_id_1); // is the read really
@@ -1125,7 +1125,7 @@ TEST(PangenomeGraphTest, save_mapped_read_strings)
 {
     PGraphTester pg;
     pangenome::ReadPtr pr;
-    MinimizerHits mhits;
+    MinimizerHitCluster mhits;
     std::deque<Interval> d;
     prg::Path p;
 
@@ -1134,23 +1134,23 @@ TEST(PangenomeGraphTest, save_mapped_read_strings)
     d = { Interval(7, 8), Interval(10, 14) };
     p.initialize(d);
     MiniRecord mr1(0, p, 0, 0);
-    mhits.add_hit(1, m1, mr1); // read 1
+    mhits.insert(std::make_shared<MinimizerHit>(1, m1, mr1)); // read 1
 
     Minimizer m2(0, 0, 5, 0);
     d = { Interval(6, 10), Interval(11, 12) };
     p.initialize(d);
     MiniRecord mr2(0, p, 0, 0);
-    mhits.add_hit(1, m2, mr2);
+    mhits.insert(std::make_shared<MinimizerHit>(1, m2, mr2));
 
     Minimizer m3(0, 0, 5, 0);
     d = { Interval(6, 10), Interval(12, 13) };
     p.initialize(d);
     MiniRecord mr3(0, p, 0, 0);
-    mhits.add_hit(1, m3, mr3);
+    mhits.insert(std::make_shared<MinimizerHit>(1, m3, mr3));
 
     auto l0 = std::make_shared<LocalPRG>(LocalPRG(0, "zero", ""));
     pg.add_node(l0);
-    pg.add_hits_between_PRG_and_read(l0, 1, mhits.hits);
+    pg.add_hits_between_PRG_and_read(l0, 1, mhits);
     mhits.clear();
 
     // read 2
@@ -1158,15 +1158,15 @@ TEST(PangenomeGraphTest, save_mapped_read_strings)
     d = { Interval(6, 10), Interval(11, 12) };
     p.initialize(d);
     MiniRecord mr4(0, p, 0, 0);
-    mhits.add_hit(2, m4, mr4);
+    mhits.insert(std::make_shared<MinimizerHit>(2, m4, mr4));
 
     Minimizer m5(0, 5, 10, 1);
     d = { Interval(6, 10), Interval(12, 13) };
     p.initialize(d);
     MiniRecord mr5(0, p, 0, 0);
-    mhits.add_hit(2, m5, mr5);
+    mhits.insert(std::make_shared<MinimizerHit>(2, m5, mr5));
 
-    pg.add_hits_between_PRG_and_read(l0, 2, mhits.hits);
+    pg.add_hits_between_PRG_and_read(l0, 2, mhits);
 
     std::string expected1
         = ">read1 pandora: 1 0:6 + \nshould\n>read2 pandora: 2 2:10 - \nis time \n";
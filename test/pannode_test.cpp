@@ -25,6 +25,47 @@ TEST(PangenomeNodeTest, create)
     EXPECT_EQ((uint)0, pan_node.samples.size());
 }
 
+TEST(PangenomeNodeTest, nodeReads_ReadsInsertedOutOfOrder_LookupsFindAllCopies)
+{
+    std::vector<ReadPtr> reads;
+    for (uint32_t read_id = 0; read_id < 4; ++read_id) {
+        reads.push_back(std::make_shared<pangenome::Read>(read_id));
+    }
+    NodeReads node_reads;
+    node_reads.insert(reads[2]);
+    node_reads.insert(reads[0]);
+    node_reads.insert(reads[2]);
+    node_reads.insert(reads[1]);
+
+    EXPECT_FALSE(node_reads.is_sorted_by_id());
+    EXPECT_EQ((size_t)4, node_reads.size());
+    EXPECT_EQ((size_t)2, node_reads.count(reads[2]));
+    EXPECT_EQ((size_t)0, node_reads.count(reads[3]));
+    EXPECT_EQ(reads[0].get(), *node_reads.find(reads[0]));
+    EXPECT_TRUE(node_reads.find(reads[3]) == node_reads.end());
+
+    // the lookups do not reorder the reads, sort_by_id() does
+    EXPECT_EQ(reads[2].get(), *node_reads.begin());
+    node_reads.sort_by_id();
+    EXPECT_TRUE(node_reads.is_sorted_by_id());
+    EXPECT_EQ((size_t)2, node_reads.count(reads[2]));
+    EXPECT_EQ((size_t)0, node_reads.count(reads[3]));
+    EXPECT_EQ(reads[1].get(), *node_reads.find(reads[1]));
+    EXPECT_TRUE(node_reads.find(reads[3]) == node_reads.end());
+
+    std::vector<uint32_t> read_ids;
+    for (const auto& read : node_reads) {
+        read_ids.push_back(read->id);
+    }
+    EXPECT_EQ((std::vector<uint32_t> { 0, 1, 2, 2 }), read_ids);
+
+    node_reads.erase(node_reads.find(reads[2]));
+    EXPECT_EQ((size_t)1, node_reads.count(reads[2]));
+    EXPECT_EQ((size_t)1, node_reads.erase(reads[2]));
+    EXPECT_EQ((size_t)0, node_reads.erase(reads[2]));
+    EXPECT_EQ((size_t)2, node_reads.size());
+}
+
 TEST(PangenomeNodeTest, get_name)
 {
     auto l1 { std::make_shared<LocalPRG>(3, "3", "") };
@@ -97,7 +138,9 @@ TEST(PangenomeNodeTest, get_read_overlap_coordinates)
     auto local_prg_ptr { std::make_shared<LocalPRG>(3, "3", "") };
     auto pan_node_ptr = std::make_shared<pangenome::Node>(local_prg_ptr);
     pangenome::ReadPtr pr;
-    MinimizerHits mhits;
+    // the node does not own its reads, they are kept alive here
+    std::vector<pangenome::ReadPtr> reads_of_node;
+    MinimizerHitCluster mhits;
 
     std::deque<Interval> d;
     prg::Path p;
@@ -107,23 +150,24 @@ TEST(PangenomeNodeTest, get_read_overlap_coordinates)
     d = { Interval(7, 8), Interval(10, 14) };
     p.initialize(d);
     MiniRecord mr1(3, p, 0, 0);
-    mhits.add_hit(1, m1, mr1); // read 1
+    mhits.insert(std::make_shared<MinimizerHit>(1, m1, mr1)); // read 1
 
     Minimizer m2(0, 0, 5, 0);
     d = { Interval(6, 10), Interval(11, 12) };
     p.initialize(d);
     MiniRecord mr2(3, p, 0, 0);
-    mhits.add_hit(1, m2, mr2);
+    mhits.insert(std::make_shared<MinimizerHit>(1, m2, mr2));
 
     Minimizer m3(0, 0, 5, 0);
     d = { Interval(6, 10), Interval(12, 13) };
     p.initialize(d);
     MiniRecord mr3(3, p, 0, 0);
-    mhits.add_hit(1, m3, mr3);
+    mhits.insert(std::make_shared<MinimizerHit>(1, m3, mr3));
 
     pr = std::make_shared<pangenome::Read>(1);
-    pr->add_hits(pan_node_ptr, mhits.hits);
+    pr->add_hits(pan_node_ptr, mhits);
     pan_node_ptr->reads.insert(pr);
+    reads_of_node.push_back(pr);
     mhits.clear();
 
     // read 2
@@ -131,17 +175,18 @@ TEST(PangenomeNodeTest, get_read_overlap_coordinates)
     d = { Interval(6, 10), Interval(11, 12) };
     p.initialize(d);
     MiniRecord mr4(3, p, 0, 0);
-    mhits.add_hit(2, m4, mr4);
+    mhits.insert(std::make_shared<MinimizerHit>(2, m4, mr4));
 
     Minimizer m5(0, 5, 10, 1);
     d = { Interval(6, 10), Interval(12, 13) };
     p.initialize(d);
     MiniRecord mr5(3, p, 0, 0);
-    mhits.add_hit(2, m5, mr5);
+    mhits.insert(std::make_shared<MinimizerHit>(2, m5, mr5));
 
     pr = std::make_shared<pangenome::Read>(2);
-    pr->add_hits(pan_node_ptr, mhits.hits);
+    pr->add_hits(pan_node_ptr, mhits);
     pan_node_ptr->reads.insert(pr);
+    reads_of_node.push_back(pr);
     mhits.clear();
 
     std::vector<std::vector<uint32_t>> read_overlap_coordinates;
@@ -914,6 +959,8 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
     auto local_prg_ptr { std::make_shared<LocalPRG>(prg_id, "three", "") };
     PanNodePtr pan_node = make_shared<pangenome::Node>(local_prg_ptr);
     PanReadPtr pr = make_shared<pangenome::Read>(read_id);
+    // the node does not own its reads, they are kept alive here
+    std::vector<PanReadPtr> reads_of_node;
     set<MinimizerHitPtr, pComp> hits;
 
     // READ 0
@@ -965,6 +1012,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 1
@@ -1043,6 +1091,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 2
@@ -1121,6 +1170,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 3
@@ -1175,6 +1225,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 4
@@ -1221,6 +1272,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // RUN GET_READ_OVERLAPS
@@ -1263,6 +1315,8 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
     auto local_prg_ptr { std::make_shared<LocalPRG>(prg_id, "three", "") };
     PanNodePtr pan_node = make_shared<pangenome::Node>(local_prg_ptr);
     PanReadPtr pr = make_shared<pangenome::Read>(read_id);
+    // the node does not own its reads, they are kept alive here
+    std::vector<PanReadPtr> reads_of_node;
 
     set<MinimizerHitPtr, pComp> hits;
 
@@ -1315,6 +1369,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 1
@@ -1393,6 +1448,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 2
@@ -1471,6 +1527,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 3
@@ -1525,6 +1582,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 4
@@ -1571,6 +1629,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // READ 5
@@ -1625,6 +1684,7 @@ TEST(ExtractReadsTest, get_read_overlap_coordinates_no_duplicates)
 
     pr->add_hits(pan_node, hits);
     pan_node->reads.insert(pr);
+    reads_of_node.push_back(pr);
     hits.clear();
 
     // RUN GET_READ_OVERLAPS
@@ -105,6 +105,66 @@ TEST(ReadAddHits, AddSecondCluster_ReadHitsMapContainsCorrectPrgIds)
     EXPECT_TRUE(result);
 }
 
+TEST(ReadAddHits, AddClustersOutOfPrgOrder_HitsAreMergedInOrder)
+{
+    uint32_t read_id = 1;
+    Read read(read_id);
+    std::deque<Interval> raw_path = { Interval(7, 8), Interval(10, 14) };
+    prg::Path path;
+    path.initialize(raw_path);
+    MiniRecord mr4(4, path, 0, 0), mr5(5, path, 0, 0);
+    Minimizer m1(0, 0, 5, 0), m2(0, 2, 7, 0), m3(0, 4, 9, 0);
+    const std::vector<MinimizerHit> cluster5 { MinimizerHit(read_id, m1, mr5) };
+    const std::vector<MinimizerHit> cluster4 { MinimizerHit(read_id, m3, mr4),
+        MinimizerHit(read_id, m2, mr4) };
+
+    auto pan_node_4 = make_shared<pangenome::Node>(
+        std::make_shared<LocalPRG>(4, "four", ""));
+    auto pan_node_5 = make_shared<pangenome::Node>(
+        std::make_shared<LocalPRG>(5, "five", ""));
+    read.add_hits(pan_node_5, cluster5.begin(), cluster5.end());
+    read.add_hits(pan_node_4, cluster4.begin(), cluster4.end());
+
+    auto hits = read.get_hits_as_unordered_map();
+    ASSERT_EQ((uint)2, hits[4].size());
+    EXPECT_EQ((uint)2, hits[4][0]->get_read_start_position());
+    EXPECT_EQ((uint)4, hits[4][1]->get_read_start_position());
+    ASSERT_EQ((uint)1, hits[5].size());
+    EXPECT_EQ((uint)0, hits[5][0]->get_read_start_position());
+    ASSERT_EXCEPTION(read.add_hits(pan_node_5, cluster5.begin(), cluster5.end()),
+        FatalRuntimeError, "Error when adding hits to Pangraph read");
+}
+
+TEST(ReadGetHitsOfNode, SeveralNodes_RangeOverHitsOfEachNode)
+{
+    uint32_t read_id = 1;
+    Read read(read_id);
+    std::deque<Interval> raw_path = { Interval(7, 8), Interval(10, 14) };
+    prg::Path path;
+    path.initialize(raw_path);
+    MiniRecord mr4(4, path, 0, 0), mr5(5, path, 0, 0);
+    Minimizer m1(0, 0, 5, 0), m2(0, 2, 7, 0), m3(0, 4, 9, 0);
+    const std::vector<MinimizerHit> cluster4 { MinimizerHit(read_id, m2, mr4),
+        MinimizerHit(read_id, m3, mr4) };
+    const std::vector<MinimizerHit> cluster5 { MinimizerHit(read_id, m1, mr5) };
+    read.add_hits(make_shared<pangenome::Node>(std::make_shared<LocalPRG>(4, "4", "")),
+        cluster4.begin(), cluster4.end());
+    read.add_hits(make_shared<pangenome::Node>(std::make_shared<LocalPRG>(5, "5", "")),
+        cluster5.begin(), cluster5.end());
+
+    const auto hits4 = read.get_hits_of_node(4);
+    ASSERT_EQ(2, hits4.second - hits4.first);
+    EXPECT_EQ(cluster4[0], *hits4.first);
+    EXPECT_EQ(cluster4[1], *(hits4.first + 1));
+
+    const auto hits5 = read.get_hits_of_node(5);
+    ASSERT_EQ(1, hits5.second - hits5.first);
+    EXPECT_EQ(cluster5[0], *hits5.first);
+
+    const auto hits6 = read.get_hits_of_node(6);
+    EXPECT_EQ(hits6.first, hits6.second);
+}
+
 TEST(PangenomeReadTest, find_position)
 {
     std::set<MinimizerHitPtr, pComp> dummy_cluster;
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "read_batch.h"
+#include <string>
+
+TEST(ReadBatchTest, create)
+{
+    ReadBatch batch;
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ((size_t)0, batch.size());
+    EXPECT_EQ((uint64_t)0, batch.get_number_of_bases());
+}
+
+TEST(ReadBatchTest, add)
+{
+    ReadBatch batch;
+    const std::string name1 { "read1" }, seq1 { "ACGT" };
+    const std::string name2 { "read2 with comment" }, seq2 { "GGGTTTAA" };
+    batch.add(3, name1.data(), name1.size(), seq1.data(), seq1.size());
+    batch.add(4, name2.data(), name2.size(), seq2.data(), seq2.size());
+
+    EXPECT_FALSE(batch.empty());
+    EXPECT_EQ((size_t)2, batch.size());
+    EXPECT_EQ((uint64_t)12, batch.get_number_of_bases());
+    EXPECT_EQ((uint32_t)3, batch.get_id(0));
+    EXPECT_EQ(name1, batch.get_name(0));
+    EXPECT_EQ(seq1, batch.get_sequence(0));
+    EXPECT_EQ((uint32_t)4, batch.get_id(1));
+    EXPECT_EQ(name2, batch.get_name(1));
+    EXPECT_EQ(seq2, batch.get_sequence(1));
+}
+
+TEST(ReadBatchTest, sequences_are_stored_contiguously)
+{
+    ReadBatch batch;
+    batch.add(0, "a", 1, "ACGT", 4);
+    batch.add(1, "b", 1, "TTT", 3);
+
+    EXPECT_EQ(batch.get_sequence(0).data() + 4, batch.get_sequence(1).data());
+}
+
+TEST(ReadBatchTest, empty_read)
+{
+    ReadBatch batch;
+    batch.add(0, "a", 1, "", 0);
+    batch.add(1, "b", 1, "AC", 2);
+
+    EXPECT_EQ((size_t)2, batch.size());
+    EXPECT_TRUE(batch.get_sequence(0).empty());
+    EXPECT_EQ("AC", batch.get_sequence(1));
+}
+
+TEST(ReadBatchTest, clear)
+{
+    ReadBatch batch;
+    batch.add(0, "a", 1, "ACGT", 4);
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ((uint64_t)0, batch.get_number_of_bases());
+
+    batch.add(7, "b", 1, "TT", 2);
+    EXPECT_EQ((size_t)1, batch.size());
+    EXPECT_EQ((uint32_t)7, batch.get_id(0));
+    EXPECT_EQ("b", batch.get_name(0));
+    EXPECT_EQ("TT", batch.get_sequence(0));
+}
+
+TEST(ReadBatchSizerTest, initial_size_is_clamped)
+{
+    EXPECT_EQ((uint64_t)100, ReadBatchSizer(10, 100, 1000).get_nb_bases());
+    EXPECT_EQ((uint64_t)1000, ReadBatchSizer(5000, 100, 1000).get_nb_bases());
+    EXPECT_EQ((uint64_t)500, ReadBatchSizer(500, 100, 1000).get_nb_bases());
+}
+
+TEST(ReadBatchSizerTest, update_without_feedback_keeps_size)
+{
+    ReadBatchSizer sizer(500, 100, 1000, 1.0);
+    sizer.update(0, 1.0);
+    EXPECT_EQ((uint64_t)500, sizer.get_nb_bases());
+    sizer.update(500, 0.0);
+    EXPECT_EQ((uint64_t)500, sizer.get_nb_bases());
+}
+
+TEST(ReadBatchSizerTest, slow_batches_shrink_size)
+{
+    // 500 bases in 5s -> ideal is 100 bases per 1s batch, move halfway: 300
+    ReadBatchSizer sizer(500, 100, 1000, 1.0);
+    sizer.update(500, 5.0);
+    EXPECT_EQ((uint64_t)300, sizer.get_nb_bases());
+}
+
+TEST(ReadBatchSizerTest, fast_batches_grow_size)
+{
+    // 500 bases in 0.5s -> ideal is 1000 bases per 1s batch, move halfway: 750
+    ReadBatchSizer sizer(500, 100, 1000, 1.0);
+    sizer.update(500, 0.5);
+    EXPECT_EQ((uint64_t)750, sizer.get_nb_bases());
+}
+
+TEST(ReadBatchSizerTest, size_never_leaves_bounds)
+{
+    ReadBatchSizer sizer(500, 100, 1000, 1.0);
+    for (int i = 0; i < 20; ++i) {
+        sizer.update(1000, 0.001);
+    }
+    EXPECT_EQ((uint64_t)1000, sizer.get_nb_bases());
+    for (int i = 0; i < 20; ++i) {
+        sizer.update(100, 1000.0);
+    }
+    EXPECT_EQ((uint64_t)100, sizer.get_nb_bases());
+}
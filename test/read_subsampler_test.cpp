@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include "read_subsampler.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <zlib.h>
+
+TEST(ReadSubsamplerTest, fractionForTargetCovg_ReadsBelowTarget_KeepAll)
+{
+    EXPECT_DOUBLE_EQ(1.0, ReadSubsampler::fraction_for_target_covg(1000, 100, 10));
+    EXPECT_DOUBLE_EQ(1.0, ReadSubsampler::fraction_for_target_covg(999, 100, 10));
+    EXPECT_DOUBLE_EQ(1.0, ReadSubsampler::fraction_for_target_covg(0, 100, 10));
+}
+
+TEST(ReadSubsamplerTest, fractionForTargetCovg_ReadsAboveTarget_KeepFraction)
+{
+    EXPECT_DOUBLE_EQ(0.25, ReadSubsampler::fraction_for_target_covg(4000, 100, 10));
+}
+
+TEST(ReadSubsamplerTest, keep_FractionOne_KeepsAllReads)
+{
+    const ReadSubsampler subsampler(1.0);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(subsampler.keep("read" + std::to_string(i)));
+    }
+}
+
+TEST(ReadSubsamplerTest, keep_FractionZero_KeepsNoRead)
+{
+    const ReadSubsampler subsampler(0.0);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_FALSE(subsampler.keep("read" + std::to_string(i)));
+    }
+}
+
+TEST(ReadSubsamplerTest, keep_FractionIsClamped)
+{
+    EXPECT_DOUBLE_EQ(1.0, ReadSubsampler(2.0).get_fraction());
+    EXPECT_DOUBLE_EQ(0.0, ReadSubsampler(-1.0).get_fraction());
+}
+
+TEST(ReadSubsamplerTest, keep_Fraction_KeepsAboutFractionOfReads)
+{
+    const ReadSubsampler subsampler(0.3);
+    const uint32_t nb_reads = 100000;
+    uint32_t nb_kept { 0 };
+    for (uint32_t i = 0; i < nb_reads; ++i) {
+        nb_kept += subsampler.keep("read" + std::to_string(i));
+    }
+    EXPECT_NEAR(0.3, (double)nb_kept / nb_reads, 0.01);
+}
+
+TEST(ReadSubsamplerTest, keep_IsDeterministicAndNested)
+{
+    // a read kept at a fraction is also kept at any larger fraction
+    const ReadSubsampler subsampler1(0.2), subsampler2(0.2), subsampler3(0.5);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const std::string name { "read" + std::to_string(i) };
+        EXPECT_EQ(subsampler1.keep(name), subsampler2.keep(name));
+        if (subsampler1.keep(name)) {
+            EXPECT_TRUE(subsampler3.keep(name));
+        }
+    }
+}
+
+TEST(ReadSubsamplerTest, estimateNumberOfBases_FilesShorterThanPrefix_CountedExactly)
+{
+    const std::vector<std::string> filepaths { "../../test/test_cases/read2.fa",
+        "../../test/test_cases/read2.fa" };
+    EXPECT_EQ((uint64_t)2 * 46, ReadSubsampler::estimate_number_of_bases(filepaths));
+}
+
+TEST(ReadSubsamplerTest, estimateNumberOfBases_GzippedFileLongerThanPrefix_Estimated)
+{
+    const std::string filepath = std::string(std::tmpnam(nullptr)) + ".fq.gz";
+    const uint64_t nb_reads = 20000;
+    const uint64_t read_length = 100;
+    {
+        std::mt19937 generator(42);
+        const std::string bases = "ACGT";
+        gzFile outfile = gzopen(filepath.c_str(), "wb");
+        for (uint64_t i = 0; i < nb_reads; ++i) {
+            std::string read(read_length, 'A');
+            for (auto& base : read) {
+                base = bases[generator() % 4];
+            }
+            const std::string record = "@read" + std::to_string(i) + "\n" + read
+                + "\n+\n" + std::string(read_length, '^') + "\n";
+            gzwrite(outfile, record.c_str(), record.size());
+        }
+        gzclose(outfile);
+    }
+
+    const uint64_t estimate = ReadSubsampler::estimate_number_of_bases(
+        { filepath }, nb_reads * read_length / 10);
+
+    const double nb_bases = nb_reads * read_length;
+    EXPECT_NEAR(nb_bases, (double)estimate, 0.05 * nb_bases);
+    std::remove(filepath.c_str());
+}
@@ -0,0 +1,252 @@
+#include "gtest/gtest.h"
+#include "run_stats.h"
+#include "test_helpers.h"
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <numeric>
+#include <string>
+
+TEST(RunStatsTest, startAndEndPhases_NestedPhases_PhasesAreInStartOrderWithSubphases)
+{
+    RunStats run_stats("test");
+    run_stats.start_phase("phase1");
+    run_stats.start_phase("phase1.1");
+    run_stats.end_phase();
+    run_stats.start_phase("phase1.2");
+    run_stats.end_phase();
+    run_stats.end_phase();
+    run_stats.start_phase("phase2");
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    ASSERT_EQ(4, phases.size());
+    EXPECT_EQ("phase1", phases[0].name);
+    EXPECT_EQ(std::vector<size_t>({ 1, 2 }), phases[0].subphases);
+    EXPECT_EQ("phase1.1", phases[1].name);
+    EXPECT_EQ("phase1.2", phases[2].name);
+    EXPECT_EQ("phase2", phases[3].name);
+    EXPECT_TRUE(phases[3].subphases.empty());
+}
+
+TEST(RunStatsTest, endPhase_PhaseEnded_TimesAndMemoryRecorded)
+{
+    RunStats run_stats("test");
+    run_stats.start_phase("phase");
+    std::vector<uint64_t> data(1000000, 1);
+    EXPECT_EQ(1000000, std::accumulate(data.begin(), data.end(), (uint64_t)0));
+    run_stats.end_phase();
+
+    const auto& phase = run_stats.get_phases()[0];
+    EXPECT_GE(phase.wall_seconds, 0);
+    EXPECT_GE(phase.cpu_seconds, 0);
+    EXPECT_GE(phase.process_peak_rss_bytes, data.size() * sizeof(uint64_t));
+}
+
+TEST(RunStatsTest, endPhase_NoPhaseStarted_FatalRuntimeError)
+{
+    RunStats run_stats("test");
+    ASSERT_EXCEPTION(run_stats.end_phase(), FatalRuntimeError,
+        "ending a phase while none is started");
+}
+
+TEST(RunStatsTest, addCount_CountsAddedToInnermostPhase)
+{
+    RunStats run_stats("test");
+    run_stats.start_phase("outer");
+    run_stats.start_phase("inner");
+    run_stats.add_count("reads", 10);
+    run_stats.end_phase();
+    run_stats.add_count("loci", 2);
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    EXPECT_EQ((std::vector<std::pair<std::string, uint64_t>> { { "loci", 2 } }),
+        phases[0].counts);
+    EXPECT_EQ((std::vector<std::pair<std::string, uint64_t>> { { "reads", 10 } }),
+        phases[1].counts);
+}
+
+TEST(RunStatsTest, scopedPhase_PhaseEndsWhenOutOfScope)
+{
+    RunStats run_stats("test");
+    {
+        ScopedPhase outer(run_stats, "outer");
+        ScopedPhase inner(run_stats, "inner");
+    }
+    run_stats.start_phase("next");
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    ASSERT_EQ(3, phases.size());
+    EXPECT_EQ(std::vector<size_t>({ 1 }), phases[0].subphases);
+    EXPECT_TRUE(phases[1].subphases.empty());
+}
+
+TEST(RunStatsTest, scopedPhase_InnerPhaseLeftOpen_EndsOwnPhaseAndInnerOne)
+{
+    RunStats run_stats("test");
+    {
+        ScopedPhase outer(run_stats, "outer");
+        run_stats.start_phase("inner");
+    }
+    run_stats.start_phase("next");
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    ASSERT_EQ(3, phases.size());
+    EXPECT_EQ(std::vector<size_t>({ 1 }), phases[0].subphases);
+    EXPECT_TRUE(phases[2].subphases.empty());
+    ASSERT_EXCEPTION(run_stats.end_phase(), FatalRuntimeError,
+        "ending a phase while none is started");
+}
+
+TEST(RunStatsTest, scopedPhase_PhaseAlreadyEnded_NothingEnded)
+{
+    RunStats run_stats("test");
+    run_stats.start_phase("outer");
+    {
+        ScopedPhase inner(run_stats, "inner");
+        run_stats.end_phase();
+    }
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    ASSERT_EQ(2, phases.size());
+    EXPECT_EQ(std::vector<size_t>({ 1 }), phases[0].subphases);
+    ASSERT_EXCEPTION(run_stats.end_phase(), FatalRuntimeError,
+        "ending a phase while none is started");
+}
+
+TEST(RunStatsTest, save_OpenPhases_ValidJsonWithAllPhasesEnded)
+{
+    RunStats run_stats("test \"command\"");
+    run_stats.start_phase("phase1");
+    run_stats.start_phase("phase1.1");
+    run_stats.add_count("reads", 10);
+    run_stats.end_phase();
+    run_stats.end_phase();
+    run_stats.start_phase("phase2");
+
+    const std::string filepath = "run_stats_test.stats.json";
+    run_stats.save(filepath);
+
+    boost::property_tree::ptree json;
+    boost::property_tree::read_json(filepath, json);
+    EXPECT_EQ("test \"command\"", json.get<std::string>("command"));
+    EXPECT_GE(json.get<double>("wall_seconds"), 0);
+    const auto& phases = json.get_child("phases");
+    ASSERT_EQ(2, phases.size());
+    const auto& phase1 = phases.begin()->second;
+    EXPECT_EQ("phase1", phase1.get<std::string>("name"));
+    const auto& phase1_1 = phase1.get_child("phases").begin()->second;
+    EXPECT_EQ("phase1.1", phase1_1.get<std::string>("name"));
+    EXPECT_EQ(10, phase1_1.get<uint64_t>("counts.reads"));
+    EXPECT_GE(phase1_1.get<double>("throughput_per_second.reads"), 0);
+    EXPECT_EQ("phase2", std::next(phases.begin())->second.get<std::string>("name"));
+}
+
+TEST(RunStatsTest, trackMemory_TrackedUntilUntracked_RecordedWhenPhasesEnd)
+{
+    RunStats run_stats("test");
+    uint64_t reads_bytes = 10;
+    run_stats.track_memory("reads", [&reads_bytes]() { return reads_bytes; });
+    run_stats.track_memory("nodes", []() { return (uint64_t)5; });
+
+    run_stats.start_phase("phase1");
+    reads_bytes = 20;
+    run_stats.end_phase();
+    run_stats.untrack_memory("reads");
+    run_stats.start_phase("phase2");
+    run_stats.end_phase();
+
+    const auto& phases = run_stats.get_phases();
+    EXPECT_EQ((MemoryBreakdown { { "reads", 20 }, { "nodes", 5 } }),
+        phases[0].memory_bytes);
+    EXPECT_EQ((MemoryBreakdown { { "nodes", 5 } }), phases[1].memory_bytes);
+}
+
+TEST(RunStatsTest, save_MemoryTracked_MemoryBreakdownInJson)
+{
+    RunStats run_stats("test");
+    run_stats.track_memory("index", []() { return (uint64_t)1024; });
+    run_stats.start_phase("phase");
+
+    const std::string filepath = "run_stats_test.memory.stats.json";
+    run_stats.save(filepath);
+
+    boost::property_tree::ptree json;
+    boost::property_tree::read_json(filepath, json);
+    const auto& phase = json.get_child("phases").begin()->second;
+    EXPECT_EQ(1024, phase.get<uint64_t>("memory_bytes.index"));
+}
+
+TEST(RunStatsTest, histogramAdd_ValuesInPowerOfTwoBuckets)
+{
+    Histogram histogram;
+    for (const uint64_t value : { 0, 1, 2, 3, 4, 7, 8, 1000 }) {
+        histogram.add(value);
+    }
+
+    EXPECT_EQ((uint64_t)8, histogram.get_count());
+    EXPECT_EQ((uint64_t)1025, histogram.get_sum());
+    EXPECT_EQ((uint64_t)1000, histogram.get_max());
+    EXPECT_EQ((uint64_t)1, histogram.get_bucket_count(0));
+    EXPECT_EQ((uint64_t)1, histogram.get_bucket_count(1));
+    EXPECT_EQ((uint64_t)2, histogram.get_bucket_count(2));
+    EXPECT_EQ((uint64_t)2, histogram.get_bucket_count(3));
+    EXPECT_EQ((uint64_t)1, histogram.get_bucket_count(4));
+    EXPECT_EQ((uint64_t)1, histogram.get_bucket_count(Histogram::bucket_of(1000)));
+    EXPECT_EQ((uint64_t)512, Histogram::bucket_min(Histogram::bucket_of(1000)));
+    EXPECT_EQ((uint64_t)1023, Histogram::bucket_max(Histogram::bucket_of(1000)));
+}
+
+TEST(RunStatsTest, histogramMerge_CountsSumsAndMaxCombined)
+{
+    Histogram histogram1, histogram2;
+    histogram1.add(1);
+    histogram1.add(5);
+    histogram2.add(6);
+    histogram2.add(20);
+
+    histogram1.merge(histogram2);
+
+    EXPECT_EQ((uint64_t)4, histogram1.get_count());
+    EXPECT_EQ((uint64_t)32, histogram1.get_sum());
+    EXPECT_EQ((uint64_t)20, histogram1.get_max());
+    EXPECT_EQ((uint64_t)2, histogram1.get_bucket_count(3));
+}
+
+TEST(RunStatsTest, addHistogram_NoPhaseStarted_FatalRuntimeError)
+{
+    RunStats run_stats("test");
+    const Histogram histogram;
+    ASSERT_EXCEPTION(run_stats.add_histogram("hits", histogram), FatalRuntimeError,
+        "adding the histogram of hits while no phase is started");
+}
+
+TEST(RunStatsTest, save_HistogramAdded_NonEmptyBucketsInJson)
+{
+    RunStats run_stats("test");
+    run_stats.start_phase("phase");
+    Histogram histogram;
+    histogram.add(2);
+    histogram.add(3);
+    histogram.add(8);
+    run_stats.add_histogram("hits", histogram);
+
+    const std::string filepath = "run_stats_test.histograms.stats.json";
+    run_stats.save(filepath);
+
+    boost::property_tree::ptree json;
+    boost::property_tree::read_json(filepath, json);
+    const auto& hits
+        = json.get_child("phases").begin()->second.get_child("histograms.hits");
+    EXPECT_EQ(3, hits.get<uint64_t>("count"));
+    EXPECT_EQ(8, hits.get<uint64_t>("max"));
+    const auto& buckets = hits.get_child("buckets");
+    ASSERT_EQ((size_t)2, buckets.size());
+    EXPECT_EQ(2, buckets.begin()->second.get<uint64_t>("min"));
+    EXPECT_EQ(3, buckets.begin()->second.get<uint64_t>("max"));
+    EXPECT_EQ(2, buckets.begin()->second.get<uint64_t>("count"));
+    EXPECT_EQ(8, std::next(buckets.begin())->second.get<uint64_t>("min"));
+}
@@ -24,6 +24,37 @@ TEST(SeqTest, initialize)
     EXPECT_EQ("AGCTAATGCATA", s1.seq);
 }
 
+TEST(SeqTest, initialize_view)
+{
+    const std::string name { "view" };
+    const std::string sequence { "AGCTAATGCATA" };
+    Seq s1(0, "0", "AGCTAATGCGTT", 11, 3);
+    s1.initialize_view(1, name, sequence, 9, 3);
+    EXPECT_EQ((uint)1, s1.id);
+    EXPECT_EQ("view", s1.name);
+    EXPECT_EQ("AGCTAATGCATA", s1.seq);
+    EXPECT_EQ(sequence.data(), s1.seq.data());
+
+    Seq s2(1, "new", "AGCTAATGCATA", 9, 3);
+    EXPECT_EQ(s2.sketch, s1.sketch);
+}
+
+TEST(SeqTest, copy_owning_seq_does_not_view_the_original)
+{
+    Seq s2;
+    {
+        Seq s1(0, "0", "AGCTAATGCGTT", 11, 3);
+        s2 = s1;
+        EXPECT_NE(s1.seq.data(), s2.seq.data());
+    }
+    EXPECT_EQ("0", s2.name);
+    EXPECT_EQ("AGCTAATGCGTT", s2.seq);
+
+    Seq s3(s2);
+    EXPECT_NE(s2.seq.data(), s3.seq.data());
+    EXPECT_EQ("AGCTAATGCGTT", s3.seq);
+}
+
 TEST(SeqTest, sketchShortReads)
 {
     Seq s1(0, "0", "AGCTAATGCGTT", 11, 3);
@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include "simulate.h"
+#include "localPRG.h"
+#include "utils.h"
+#include <set>
+#include <string>
+
+TEST(SimulatorTest, randomSequence_GivenLength_OnlyACGT)
+{
+    Simulator simulator(0);
+    const std::string sequence = simulator.random_sequence(1000);
+    EXPECT_EQ(1000, sequence.size());
+    EXPECT_EQ(std::string::npos, sequence.find_first_not_of("ACGT"));
+}
+
+TEST(SimulatorTest, randomPrg_SameSeed_SamePrg)
+{
+    Simulator simulator1(42), simulator2(42), simulator3(43);
+    const std::string prg = simulator1.random_prg(10, 20, 5, 3, 1);
+    EXPECT_EQ(prg, simulator2.random_prg(10, 20, 5, 3, 1));
+    EXPECT_NE(prg, simulator3.random_prg(10, 20, 5, 3, 1));
+}
+
+TEST(SimulatorTest, randomPrg_NotNested_ParsedByLocalPRGWithOneNodePerAllele)
+{
+    Simulator simulator(0);
+    const std::string prg = simulator.random_prg(10, 20, 5, 3);
+    const LocalPRG local_prg(0, "prg", prg);
+    // an invariant node before each site and at the end, and a node per allele
+    EXPECT_EQ(11 + 10 * 3, local_prg.prg.nodes.size());
+}
+
+TEST(SimulatorTest, randomPath_NotNested_PathLengthIsInvariantsAndOneAllelePerSite)
+{
+    Simulator simulator(0);
+    const std::string prg = simulator.random_prg(10, 20, 5, 3);
+    const std::string path = simulator.random_path(prg);
+    EXPECT_EQ(11 * 20 + 10 * 5, path.size());
+    EXPECT_EQ(std::string::npos, path.find_first_not_of("ACGT"));
+}
+
+TEST(SimulatorTest, randomPath_NestedPrg_OnlyPathsThroughThePrg)
+{
+    Simulator simulator(0);
+    const std::string prg = "A 5 C 7 G 8 T 7 6 AA 5 T";
+    for (uint32_t i = 0; i < 100; ++i) {
+        const std::string path = simulator.random_path(prg);
+        EXPECT_TRUE(path == "ACGT" or path == "ACTT" or path == "AAAT") << path;
+    }
+}
+
+TEST(SimulatorTest, randomPath_NestedPrg_AllAllelesSampled)
+{
+    Simulator simulator(0);
+    const std::string prg = "A 5 C 7 G 8 T 7 6 AA 5 T";
+    std::set<std::string> paths;
+    for (uint32_t i = 0; i < 100; ++i) {
+        paths.insert(simulator.random_path(prg));
+    }
+    EXPECT_EQ(std::set<std::string>({ "ACGT", "ACTT", "AAAT" }), paths);
+}
+
+TEST(SimulatorTest, addErrors_NoErrors_SameSequence)
+{
+    Simulator simulator(0);
+    const std::string sequence = simulator.random_sequence(1000);
+    EXPECT_EQ(sequence, simulator.add_errors(sequence, 0, 0, 0));
+}
+
+TEST(SimulatorTest, addErrors_OnlySubstitutions_EveryBaseChanged)
+{
+    Simulator simulator(0);
+    const std::string sequence = simulator.random_sequence(1000);
+    const std::string sequence_with_errors = simulator.add_errors(sequence, 1, 0, 0);
+    ASSERT_EQ(sequence.size(), sequence_with_errors.size());
+    for (uint32_t i = 0; i < sequence.size(); ++i) {
+        EXPECT_NE(sequence[i], sequence_with_errors[i]);
+    }
+}
+
+TEST(SimulatorTest, addErrors_OnlyInsertionsOrDeletions_LengthChanged)
+{
+    Simulator simulator(0);
+    const std::string sequence = simulator.random_sequence(1000);
+    EXPECT_EQ(2000, simulator.add_errors(sequence, 0, 1, 0).size());
+    EXPECT_TRUE(simulator.add_errors(sequence, 0, 0, 1).empty());
+}
+
+TEST(SimulatorTest, randomRead_NoErrors_ReadIsSubstringOfGenomeOnEitherStrand)
+{
+    Simulator simulator(0);
+    const std::string genome = simulator.random_sequence(1000);
+    const std::string genome_rev_complement = rev_complement(genome);
+    for (uint32_t i = 0; i < 100; ++i) {
+        const std::string read = simulator.random_read(genome, 100, 0, 0, 0);
+        EXPECT_EQ(100, read.size());
+        EXPECT_TRUE(genome.find(read) != std::string::npos
+            or genome_rev_complement.find(read) != std::string::npos);
+    }
+}
+
+TEST(SimulatorTest, randomRead_ReadLongerThanGenome_WholeGenome)
+{
+    Simulator simulator(0);
+    const std::string genome = simulator.random_sequence(50);
+    const std::string read = simulator.random_read(genome, 100, 0, 0, 0);
+    EXPECT_TRUE(read == genome or read == rev_complement(genome));
+}
+
+TEST(SimulatorTest, numberOfReadsForDepth)
+{
+    EXPECT_EQ(300, Simulator::number_of_reads_for_depth(10000, 1000, 30));
+    EXPECT_EQ(4, Simulator::number_of_reads_for_depth(1000, 300, 1));
+    EXPECT_EQ(30, Simulator::number_of_reads_for_depth(50, 100, 30));
+    EXPECT_EQ(0, Simulator::number_of_reads_for_depth(0, 100, 30));
+}
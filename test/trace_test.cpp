@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include "trace.h"
+#include "run_stats.h"
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <set>
+#include <thread>
+
+TEST(TraceTest, addSpan_SpanRecordedOnCallingThread)
+{
+    Tracer tracer("test", 1);
+    tracer.add_span("span", "category", 10, 25, { { "prg_id", "3" } });
+
+    const auto events = tracer.get_events();
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("span", events[0].name);
+    EXPECT_EQ("category", events[0].category);
+    EXPECT_EQ(10, events[0].start_us);
+    EXPECT_EQ(15, events[0].duration_us);
+    EXPECT_EQ(0, events[0].tid);
+    EXPECT_EQ((TraceArgs { { "prg_id", "3" } }), events[0].args);
+}
+
+TEST(TraceTest, addSpan_ParallelLoop_OneSpanPerIterationOnItsThread)
+{
+    const uint32_t threads = 4;
+    Tracer tracer("test", threads);
+#pragma omp parallel for num_threads(threads)
+    for (uint32_t i = 0; i < 100; ++i) {
+        tracer.add_span("task", "test", tracer.now(), tracer.now());
+    }
+
+    const auto events = tracer.get_events();
+    EXPECT_EQ(100, events.size());
+    for (const auto& event : events) {
+        EXPECT_LT(event.tid, threads);
+    }
+}
+
+TEST(TraceTest, traceSpan_NoRunTracer_NothingRecorded)
+{
+    set_run_tracer(nullptr);
+    {
+        TraceSpan span("span", "test");
+        span.add_arg("prg_id", 1);
+    }
+    EXPECT_EQ(0, trace_timestamp());
+}
+
+TEST(TraceTest, traceSpan_RunTracer_SpanWithArgsRecorded)
+{
+    Tracer tracer("test", 1);
+    set_run_tracer(&tracer);
+    {
+        TraceSpan span("span", "test");
+        span.add_arg("prg_id", 1);
+        span.add_arg("node", "gene");
+    }
+    set_run_tracer(nullptr);
+
+    const auto events = tracer.get_events();
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("span", events[0].name);
+    EXPECT_GE(events[0].duration_us, 0);
+    EXPECT_EQ((TraceArgs { { "prg_id", "1" }, { "node", "gene" } }), events[0].args);
+}
+
+TEST(TraceTest, traceLockWait_OnlyWaitsOfAtLeastAMicrosecondRecorded)
+{
+    Tracer tracer("test", 1);
+    set_run_tracer(&tracer);
+    trace_lock_wait("uncontended", trace_timestamp() + 1000);
+    const double wait_start = trace_timestamp();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    trace_lock_wait("contended", wait_start);
+    set_run_tracer(nullptr);
+
+    const auto events = tracer.get_events();
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("wait contended", events[0].name);
+    EXPECT_EQ("lock_wait", events[0].category);
+    EXPECT_GE(events[0].duration_us, 1000);
+}
+
+TEST(TraceTest, endPhase_RunTraced_PhaseIsASpan)
+{
+    Tracer tracer("test", 1);
+    set_run_tracer(&tracer);
+    RunStats run_stats("test");
+    run_stats.start_phase("phase");
+    run_stats.end_phase();
+    set_run_tracer(nullptr);
+
+    const auto events = tracer.get_events();
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("phase", events[0].name);
+    EXPECT_EQ("phase", events[0].category);
+}
+
+TEST(TraceTest, scopedRunTracer_TraceFile_ValidChromeTraceSavedAtEnd)
+{
+    const fs::path filepath = "trace_test.trace.json";
+    fs::remove(filepath);
+    {
+        ScopedRunTracer run_tracer(filepath, "test", 1);
+        ASSERT_NE(nullptr, get_run_tracer());
+        TraceSpan span("span \"quoted\"", "test");
+        get_run_tracer()->add_process_span("worker", "test", 42, 0, 10);
+    }
+    EXPECT_EQ(nullptr, get_run_tracer());
+
+    boost::property_tree::ptree json;
+    boost::property_tree::read_json(filepath.string(), json);
+    std::set<std::string> names;
+    std::set<std::string> phases;
+    for (const auto& event : json.get_child("traceEvents")) {
+        names.insert(event.second.get<std::string>("name"));
+        phases.insert(event.second.get<std::string>("ph"));
+    }
+    EXPECT_EQ((std::set<std::string> { "process_name", "thread_name",
+                  "span \"quoted\"", "worker" }),
+        names);
+    EXPECT_EQ((std::set<std::string> { "M", "X" }), phases);
+}
+
+TEST(TraceTest, scopedRunTracer_NoTraceFile_NotTraced)
+{
+    ScopedRunTracer run_tracer("", "test", 1);
+    EXPECT_EQ(nullptr, get_run_tracer());
+}
@@ -11,6 +11,8 @@
 #include "inthash.h"
 #include "seq.h"
 #include <stdint.h>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <vector>
@@ -148,10 +150,10 @@ TEST(UtilsTest, addReadHits)
 {
     // initialize minihits container
     auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
-    MinimizerHits expected1;
-    MinimizerHits expected2;
-    MinimizerHits expected3;
-    MinimizerHits expected4;
+    MinimizerHitCluster expected1;
+    MinimizerHitCluster expected2;
+    MinimizerHitCluster expected3;
+    MinimizerHitCluster expected4;
 
     // initialize index as we would expect with example prgs 1 and 3 from above
     KmerHash hash;
@@ -168,8 +170,8 @@ TEST(UtilsTest, addReadHits)
     Minimizer min2(0, 1, 4, 0); // kmer, start, end, strand
     MiniRecord mr2(1, p, 0, 1);
     MinimizerHitPtr m2(make_shared<MinimizerHit>(0, min2, mr2));
-    expected1.hits.insert(m1);
-    expected2.hits.insert(m2);
+    expected1.insert(m1);
+    expected2.insert(m2);
     d = { Interval(1, 4) };
     p.initialize(d);
     kh = hash.kmerhash("GCT", 3);
@@ -183,8 +185,8 @@ TEST(UtilsTest, addReadHits)
     MiniRecord mr4(1, p, 0, 1);
     MinimizerHitPtr m4(make_shared<MinimizerHit>(0, min4, mr4));
 
-    expected2.hits.insert(m3);
-    expected1.hits.insert(m4);
+    expected2.insert(m3);
+    expected1.insert(m4);
     d = { Interval(0, 1), Interval(4, 5), Interval(8, 9) };
     p.initialize(d);
     kh = hash.kmerhash("AGC", 3);
@@ -196,8 +198,8 @@ TEST(UtilsTest, addReadHits)
     Minimizer min6(0, 1, 4, 0); // kmer, start, end, strand
     MiniRecord mr6(3, p, 0, 1);
     MinimizerHitPtr m6(make_shared<MinimizerHit>(0, min6, mr6));
-    expected1.hits.insert(m5);
-    expected2.hits.insert(m6);
+    expected1.insert(m5);
+    expected2.insert(m6);
     d = { Interval(0, 1), Interval(4, 5), Interval(12, 13) };
     p.initialize(d);
     kh = hash.kmerhash("AGT", 3);
@@ -206,7 +208,7 @@ TEST(UtilsTest, addReadHits)
     Minimizer min9(0, 0, 3, 1); // kmer, start, end, strand
     MiniRecord mr9(3, p, 0, 1);
     MinimizerHitPtr m9(make_shared<MinimizerHit>(0, min9, mr9));
-    expected3.hits.insert(m9);
+    expected3.insert(m9);
     d = { Interval(0, 1), Interval(19, 20), Interval(23, 24) };
     p.initialize(d);
     index->add_record(min(kh.first, kh.second), 3, p, 0, (kh.first < kh.second));
@@ -214,7 +216,7 @@ TEST(UtilsTest, addReadHits)
     Minimizer min10(0, 0, 3, 1); // kmer, start, end, strand
     MiniRecord mr10(3, p, 0, 1);
     MinimizerHitPtr m10(make_shared<MinimizerHit>(0, min10, mr10));
-    expected3.hits.insert(m10);
+    expected3.insert(m10);
     d = { Interval(4, 5), Interval(8, 9), Interval(16, 16), Interval(23, 24) };
     p.initialize(d);
     kh = hash.kmerhash("GCT", 3);
@@ -227,8 +229,8 @@ TEST(UtilsTest, addReadHits)
     Minimizer min8(0, 0, 3, 0); // kmer, start, end, strand
     MiniRecord mr8(3, p, 0, 1);
     MinimizerHitPtr m8(make_shared<MinimizerHit>(0, min8, mr8));
-    expected2.hits.insert(m7);
-    expected1.hits.insert(m8);
+    expected2.insert(m7);
+    expected1.insert(m8);
     d = { Interval(4, 5), Interval(12, 13), Interval(16, 16), Interval(23, 24) };
     p.initialize(d);
     kh = hash.kmerhash("GTT", 3);
@@ -237,15 +239,15 @@ TEST(UtilsTest, addReadHits)
     Minimizer min11(0, 1, 4, 1); // kmer, start, end, strand
     MiniRecord mr11(3, p, 0, 1);
     MinimizerHitPtr m11(make_shared<MinimizerHit>(0, min11, mr11));
-    expected4.hits.insert(m11);
+    expected4.insert(m11);
 
     Seq s(0, "read1", "AGC", 1, 3);
     add_read_hits(s, minimizer_hits, *index);
-    EXPECT_EQ(expected1.hits.size(), minimizer_hits->hits.size());
-    set<MinimizerHitPtr, pComp>::const_iterator it2 = expected1.hits.begin();
-    for (set<MinimizerHitPtr, pComp>::const_iterator it = minimizer_hits->hits.begin();
-         it != minimizer_hits->hits.end(); ++it) {
-        EXPECT_EQ(**it2, **it);
+    EXPECT_EQ(expected1.size(), minimizer_hits->hits.size());
+    auto it2 = expected1.begin();
+    for (auto it = minimizer_hits->hits.begin(); it != minimizer_hits->hits.end();
+         ++it) {
+        EXPECT_EQ(**it2, *it);
         it2++;
     }
 
@@ -257,26 +259,26 @@ TEST(UtilsTest, addReadHits)
     EXPECT_EQ(j, minimizer_hits->hits.size());
     s = Seq(0, "read2", "AGTT", 2, 3);
     add_read_hits(s, minimizer_hits, *index);
-    EXPECT_EQ(expected4.hits.size(), minimizer_hits->hits.size());
-    it2 = expected4.hits.begin();
-    for (set<MinimizerHitPtr, pComp>::const_iterator it = minimizer_hits->hits.begin();
-         it != minimizer_hits->hits.end(); ++it) {
-        EXPECT_EQ(**it2, **it);
+    EXPECT_EQ(expected4.size(), minimizer_hits->hits.size());
+    it2 = expected4.begin();
+    for (auto it = minimizer_hits->hits.begin(); it != minimizer_hits->hits.end();
+         ++it) {
+        EXPECT_EQ(**it2, *it);
         it2++;
     }
 
     // but for w=1, only add one more hit, for GTT
-    expected3.hits.insert(m11);
+    expected3.insert(m11);
 
     minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
     EXPECT_EQ(j, minimizer_hits->hits.size());
     s = Seq(0, "read2", "AGTT", 1, 3);
     add_read_hits(s, minimizer_hits, *index);
-    EXPECT_EQ(expected3.hits.size(), minimizer_hits->hits.size());
-    it2 = expected3.hits.begin();
-    for (set<MinimizerHitPtr, pComp>::const_iterator it = minimizer_hits->hits.begin();
-         it != minimizer_hits->hits.end(); ++it) {
-        EXPECT_EQ(**it2, **it);
+    EXPECT_EQ(expected3.size(), minimizer_hits->hits.size());
+    it2 = expected3.begin();
+    for (auto it = minimizer_hits->hits.begin(); it != minimizer_hits->hits.end();
+         ++it) {
+        EXPECT_EQ(**it2, *it);
         it2++;
     }
 
@@ -287,12 +289,12 @@ TEST(UtilsTest, addReadHits)
     EXPECT_EQ(j, minimizer_hits->hits.size());
     s = Seq(0, "read3", "AGCT", 1, 3);
     add_read_hits(s, minimizer_hits, *index);
-    expected1.hits.insert(expected2.hits.begin(), expected2.hits.end());
-    EXPECT_EQ(expected1.hits.size(), minimizer_hits->hits.size());
-    it2 = expected1.hits.begin();
+    expected1.insert(expected2.begin(), expected2.end());
+    EXPECT_EQ(expected1.size(), minimizer_hits->hits.size());
+    it2 = expected1.begin();
     for (auto it = minimizer_hits->hits.begin(); it != minimizer_hits->hits.end();
          ++it) {
-        EXPECT_EQ(**it2, **it);
+        EXPECT_EQ(**it2, *it);
         it2++;
     }
 
@@ -303,18 +305,152 @@ TEST(UtilsTest, addReadHits)
     EXPECT_EQ(j, minimizer_hits->hits.size());
     s = Seq(0, "read3", "AGCT", 2, 3);
     add_read_hits(s, minimizer_hits, *index);
-    EXPECT_EQ(expected1.hits.size(), minimizer_hits->hits.size());
-    it2 = expected1.hits.begin();
+    EXPECT_EQ(expected1.size(), minimizer_hits->hits.size());
+    it2 = expected1.begin();
     for (auto it = minimizer_hits->hits.begin(); it != minimizer_hits->hits.end();
          ++it) {
-        EXPECT_EQ(**it2, **it);
+        EXPECT_EQ(**it2, *it);
         it2++;
     }
 
-    expected1.hits.clear();
-    expected2.hits.clear();
-    expected3.hits.clear();
-    expected4.hits.clear();
+    expected1.clear();
+    expected2.clear();
+    expected3.clear();
+    expected4.clear();
+    index->clear();
+}
+
+TEST(UtilsTest, addReadHits_ReadOverLimits_ReadSkippedWithoutHits)
+{
+    // read AGTT with w=1, k=3 has minimizers AGT and GTT: AGT hits prg 1 twice, GTT
+    // hits prg 2 once
+    KmerHash hash;
+    auto index = std::make_shared<Index>();
+    prg::Path p1, p2, p3;
+    p1.initialize({ Interval(0, 3) });
+    p2.initialize({ Interval(5, 8) });
+    p3.initialize({ Interval(1, 4) });
+    auto kh = hash.kmerhash("AGT", 3);
+    index->add_record(min(kh.first, kh.second), 1, p1, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 1, p2, 1, (kh.first < kh.second));
+    kh = hash.kmerhash("GTT", 3);
+    index->add_record(min(kh.first, kh.second), 2, p3, 0, (kh.first < kh.second));
+    const Seq s(0, "read", "AGTT", 1, 3);
+
+    auto minimizer_hits = std::make_shared<MinimizerHits>();
+    EXPECT_EQ(
+        ReadHitsStatus::TooManyHits, add_read_hits(s, minimizer_hits, *index, 1, 2));
+    EXPECT_TRUE(minimizer_hits->hits.empty());
+
+    minimizer_hits->clear();
+    EXPECT_EQ(ReadHitsStatus::TooManyPrgs,
+        add_read_hits(s, minimizer_hits, *index, 1, 3, 1));
+    EXPECT_TRUE(minimizer_hits->hits.empty());
+
+    minimizer_hits->clear();
+    EXPECT_EQ(
+        ReadHitsStatus::Added, add_read_hits(s, minimizer_hits, *index, 1, 3, 2));
+    EXPECT_EQ((size_t)3, minimizer_hits->hits.size());
+
+    index->clear();
+}
+
+TEST(UtilsTest, addReadHits_HistogramsGiven_SketchHitsAndHitsPerPrgAdded)
+{
+    // read AGTT with w=1, k=3 has minimizers AGT and GTT: AGT hits prg 1 twice, GTT
+    // hits prg 2 once
+    KmerHash hash;
+    auto index = std::make_shared<Index>();
+    prg::Path p1, p2, p3;
+    p1.initialize({ Interval(0, 3) });
+    p2.initialize({ Interval(5, 8) });
+    p3.initialize({ Interval(1, 4) });
+    auto kh = hash.kmerhash("AGT", 3);
+    index->add_record(min(kh.first, kh.second), 1, p1, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 1, p2, 1, (kh.first < kh.second));
+    kh = hash.kmerhash("GTT", 3);
+    index->add_record(min(kh.first, kh.second), 2, p3, 0, (kh.first < kh.second));
+    const Seq s(0, "read", "AGTT", 1, 3);
+
+    MappingHistograms histograms;
+    auto minimizer_hits = std::make_shared<MinimizerHits>();
+    EXPECT_EQ(ReadHitsStatus::Added,
+        add_read_hits(s, minimizer_hits, *index, 1, 0, 0, &histograms));
+
+    EXPECT_EQ((uint64_t)1, histograms.sketch_size.get_count());
+    EXPECT_EQ((uint64_t)2, histograms.sketch_size.get_sum());
+    EXPECT_EQ((uint64_t)1, histograms.index_hits.get_count());
+    EXPECT_EQ((uint64_t)3, histograms.index_hits.get_sum());
+    EXPECT_EQ((uint64_t)2, histograms.hits_per_prg.get_count());
+    EXPECT_EQ((uint64_t)1, histograms.hits_per_prg.get_bucket_count(1));
+    EXPECT_EQ((uint64_t)1, histograms.hits_per_prg.get_bucket_count(2));
+
+    index->clear();
+}
+
+TEST(UtilsTest, addReadHits_ScratchReused_SameHitsAsWithoutScratch)
+{
+    // read AGTT with w=1, k=3 has minimizers AGT and GTT: AGT hits prg 1 twice, GTT
+    // hits prg 2 once
+    KmerHash hash;
+    auto index = std::make_shared<Index>();
+    prg::Path p1, p2, p3;
+    p1.initialize({ Interval(0, 3) });
+    p2.initialize({ Interval(5, 8) });
+    p3.initialize({ Interval(1, 4) });
+    auto kh = hash.kmerhash("AGT", 3);
+    index->add_record(min(kh.first, kh.second), 1, p1, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 1, p2, 1, (kh.first < kh.second));
+    kh = hash.kmerhash("GTT", 3);
+    index->add_record(min(kh.first, kh.second), 2, p3, 0, (kh.first < kh.second));
+    const Seq s(0, "read", "AGTT", 1, 3);
+    const Seq other(1, "other read", "AGT", 1, 3);
+
+    auto expected_hits = std::make_shared<MinimizerHits>();
+    add_read_hits(s, expected_hits, *index, 1);
+
+    ReadHitsScratch scratch;
+    auto minimizer_hits = std::make_shared<MinimizerHits>();
+    EXPECT_EQ(ReadHitsStatus::Added,
+        add_read_hits(other, minimizer_hits, *index, 1, 0, 0, nullptr, &scratch));
+    minimizer_hits->clear();
+    EXPECT_EQ(ReadHitsStatus::Added,
+        add_read_hits(s, minimizer_hits, *index, 1, 0, 0, nullptr, &scratch));
+
+    EXPECT_EQ(expected_hits->hits, minimizer_hits->hits);
+
+    index->clear();
+}
+
+TEST(UtilsTest, addReadHits_NoPrgWithEnoughHits_ReadRejectedWithoutHits)
+{
+    // read AGTT with w=1, k=3 has minimizers AGT and GTT: AGT hits prg 1 twice, GTT
+    // hits prg 2 once
+    KmerHash hash;
+    auto index = std::make_shared<Index>();
+    prg::Path p1, p2, p3;
+    p1.initialize({ Interval(0, 3) });
+    p2.initialize({ Interval(5, 8) });
+    p3.initialize({ Interval(1, 4) });
+    auto kh = hash.kmerhash("AGT", 3);
+    index->add_record(min(kh.first, kh.second), 1, p1, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 1, p2, 1, (kh.first < kh.second));
+    kh = hash.kmerhash("GTT", 3);
+    index->add_record(min(kh.first, kh.second), 2, p3, 0, (kh.first < kh.second));
+    const Seq s(0, "read", "AGTT", 1, 3);
+
+    auto minimizer_hits = std::make_shared<MinimizerHits>();
+    EXPECT_EQ(ReadHitsStatus::Added, add_read_hits(s, minimizer_hits, *index, 1));
+    EXPECT_EQ((size_t)3, minimizer_hits->hits.size());
+
+    minimizer_hits->clear();
+    EXPECT_EQ(ReadHitsStatus::TooFewHits, add_read_hits(s, minimizer_hits, *index, 2));
+    EXPECT_TRUE(minimizer_hits->hits.empty());
+
+    minimizer_hits->clear();
+    EXPECT_EQ(ReadHitsStatus::TooFewHits, add_read_hits(s, minimizer_hits, *index, 3));
+    EXPECT_TRUE(minimizer_hits->hits.empty());
+
     index->clear();
 }
 
@@ -323,40 +459,157 @@ TEST(UtilsTest, filter_clusters2)
     deque<Interval> d = { Interval(0, 10) };
     prg::Path p;
     p.initialize(d);
+    MiniRecord mr1(0, p, 0, 0);
+    MiniRecord mr2(1, p, 0, 0);
+    MiniRecord mr3(2, p, 0, 0);
 
-    set<MinimizerHitPtr, pComp> s;
-    set<set<MinimizerHitPtr, pComp>, clusterComp> ss, ss_exp;
-
-    MinimizerHitPtr mh;
+    MinimizerHits mhits;
     for (uint i = 0; i != 6; ++i) {
         Minimizer min1(0, i, i + 10, 0); // kmer, start, end, strand
-        MiniRecord mr1(0, p, 0, 0);
-        mh = make_shared<MinimizerHit>(1, min1, mr1);
-        s.insert(mh);
+        mhits.add_hit(1, min1, mr1);
     }
-    ss.insert(s);
-    ss_exp.insert(s);
-    s.clear();
     for (uint i = 5; i != 15; ++i) {
         Minimizer min2(0, i, i + 10, 0); // kmer, start, end, strand
-        MiniRecord mr2(1, p, 0, 0);
-        mh = make_shared<MinimizerHit>(1, min2, mr2);
-        s.insert(mh);
+        mhits.add_hit(1, min2, mr2);
     }
-    ss.insert(s);
-    ss_exp.insert(s);
-    s.clear();
     for (uint i = 3; i != 7; ++i) {
         Minimizer min3(0, i, i + 10, 0); // kmer, start, end, strand
-        MiniRecord mr3(2, p, 0, 0);
-        mh = make_shared<MinimizerHit>(1, min3, mr3);
-        s.insert(mh);
+        mhits.add_hit(1, min3, mr3);
+    }
+    mhits.sort();
+
+    std::vector<MinimizerHitClusterRange> clusters { { mhits.hits, 0, 6 },
+        { mhits.hits, 6, 16 }, { mhits.hits, 16, 20 } };
+    std::sort(clusters.begin(), clusters.end(), clusterRangeComp { mhits.hits });
+
+    filter_clusters2(clusters, mhits.hits, 20);
+
+    // the cluster on PRG 2 is contained in the cluster on PRG 0
+    EXPECT_EQ(clusters.size(), (uint)2);
+    EXPECT_EQ(clusters[0].prg_id, (uint)0);
+    EXPECT_EQ(clusters[1].prg_id, (uint)1);
+}
+
+TEST(UtilsTest, filter_clusters)
+{
+    deque<Interval> d = { Interval(0, 10) };
+    prg::Path p;
+    p.initialize(d);
+    MiniRecord mr1(0, p, 0, 0);
+    MiniRecord mr2(1, p, 0, 0);
+    MiniRecord mr3(2, p, 0, 0);
+
+    MinimizerHits mhits;
+    for (uint i = 0; i != 10; ++i) {
+        Minimizer min1(0, i, i + 10, 0); // kmer, start, end, strand
+        mhits.add_hit(1, min1, mr1);
+    }
+    for (uint i = 2; i != 6; ++i) {
+        Minimizer min2(0, i, i + 10, 0); // kmer, start, end, strand
+        mhits.add_hit(1, min2, mr2);
+    }
+    for (uint i = 8; i != 20; ++i) {
+        Minimizer min3(0, i, i + 10, 0); // kmer, start, end, strand
+        mhits.add_hit(1, min3, mr3);
+    }
+    mhits.sort();
+
+    std::vector<MinimizerHitClusterRange> clusters { { mhits.hits, 0, 10 },
+        { mhits.hits, 10, 14 }, { mhits.hits, 14, 26 } };
+    std::sort(clusters.begin(), clusters.end(), clusterRangeComp { mhits.hits });
+
+    filter_clusters(clusters);
+
+    // the cluster on PRG 1 is contained in the cluster on PRG 0, the cluster on PRG 2
+    // overlaps it but extends further
+    EXPECT_EQ(clusters.size(), (uint)2);
+    EXPECT_EQ(clusters[0].prg_id, (uint)0);
+    EXPECT_EQ(clusters[1].prg_id, (uint)2);
+}
+
+TEST(UtilsTest, chain_hits_separates_colinear_hits_from_noise)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> read_and_prg_positions { { 0, 100 },
+        { 5, 500 }, { 10, 110 }, { 20, 120 }, { 25, 10 }, { 30, 130 }, { 40, 140 } };
+    std::vector<MiniRecord> records;
+    for (const auto& positions : read_and_prg_positions) {
+        deque<Interval> d = { Interval(positions.second, positions.second + 5) };
+        prg::Path p;
+        p.initialize(d);
+        records.emplace_back(0, p, 0, 0);
+    }
+    MinimizerHits mhits;
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        const uint32_t read_position = read_and_prg_positions[i].first;
+        Minimizer m(0, read_position, read_position + 5, 0);
+        mhits.add_hit(1, m, records[i]);
+    }
+    mhits.sort();
+
+    const auto chains = chain_hits(mhits.hits, 0, mhits.hits.size(), 250);
+
+    EXPECT_EQ(chains.size(), (uint)3);
+    const std::pair<uint32_t, uint32_t> expected_best_chain { 0, 5 };
+    EXPECT_EQ(chains[0], expected_best_chain);
+    uint32_t expected_prg_start = 100;
+    for (uint32_t i = chains[0].first; i < chains[0].second; ++i) {
+        EXPECT_EQ(mhits.hits[i].get_prg_path().get_start(), expected_prg_start);
+        expected_prg_start += 10;
+    }
+    EXPECT_EQ(chains[1].second - chains[1].first, (uint)1);
+    EXPECT_EQ(chains[2].second - chains[2].first, (uint)1);
+}
+
+TEST(UtilsTest, chain_hits_reverse_strand_hits_are_chained_on_decreasing_prg)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> read_and_prg_positions { { 0, 140 },
+        { 10, 130 }, { 20, 120 }, { 30, 110 } };
+    std::vector<MiniRecord> records;
+    for (const auto& positions : read_and_prg_positions) {
+        deque<Interval> d = { Interval(positions.second, positions.second + 5) };
+        prg::Path p;
+        p.initialize(d);
+        records.emplace_back(0, p, 0, 1);
     }
-    ss.insert(s);
+    MinimizerHits mhits;
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        const uint32_t read_position = read_and_prg_positions[i].first;
+        Minimizer m(0, read_position, read_position + 5, 0);
+        mhits.add_hit(1, m, records[i]);
+    }
+    mhits.sort();
 
-    filter_clusters2(ss, 20);
+    const auto chains = chain_hits(mhits.hits, 0, mhits.hits.size(), 250);
 
-    EXPECT_EQ(ss_exp.size(), ss.size());
+    EXPECT_EQ(chains.size(), (uint)1);
+    const std::pair<uint32_t, uint32_t> expected_chain { 0, 4 };
+    EXPECT_EQ(chains[0], expected_chain);
+}
+
+TEST(UtilsTest, chain_hits_does_not_chain_hits_further_than_max_diff)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> read_and_prg_positions { { 0, 100 },
+        { 10, 110 }, { 300, 400 }, { 310, 410 } };
+    std::vector<MiniRecord> records;
+    for (const auto& positions : read_and_prg_positions) {
+        deque<Interval> d = { Interval(positions.second, positions.second + 5) };
+        prg::Path p;
+        p.initialize(d);
+        records.emplace_back(0, p, 0, 0);
+    }
+    MinimizerHits mhits;
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        const uint32_t read_position = read_and_prg_positions[i].first;
+        Minimizer m(0, read_position, read_position + 5, 0);
+        mhits.add_hit(1, m, records[i]);
+    }
+    mhits.sort();
+
+    const auto chains = chain_hits(mhits.hits, 0, mhits.hits.size(), 250);
+
+    EXPECT_EQ(chains.size(), (uint)2);
+    EXPECT_EQ(chains[0].second - chains[0].first, (uint)2);
+    EXPECT_EQ(chains[1].second - chains[1].first, (uint)2);
 }
 
 TEST(UtilsTest, simpleInferLocalPRGOrderForRead)
@@ -963,6 +1216,18 @@ void setup_index(
     lp2->kmer_prg.add_edge(v[24], v[25]);
 }
 
+// the options to map the reads of the test cases to the PRGs of setup_index()
+MappingOptions setup_index_mapping_options()
+{
+    MappingOptions options;
+    options.window_size = 1;
+    options.kmer_size = 3;
+    options.max_diff = 1;
+    options.error_rate = 0.1;
+    options.min_cluster_size = 1;
+    return options;
+}
+
 TEST(UtilsTest, pangraphFromReadFile_Fa)
 {
     std::vector<std::shared_ptr<LocalPRG>> prgs;
@@ -971,8 +1236,8 @@ TEST(UtilsTest, pangraphFromReadFile_Fa)
     setup_index(prgs, index);
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
-    pangraph_from_read_file(
-        TEST_CASE_DIR + "read2.fa", pangraph, index, prgs, 1, 3, 1, 0.1, 1);
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fa", pangraph, index, prgs,
+        setup_index_mapping_options());
 
     // create a pangraph object representing the truth we expect (prg 3 4 2 1)
     // note that prgs 1, 3, 4 share no 3mer, but 2 shares a 3mer with each of 2 other
@@ -988,6 +1253,77 @@ TEST(UtilsTest, pangraphFromReadFile_Fa)
     index->clear();
 }
 
+TEST(UtilsTest, pangraphFromReadFile_MaxCovgExceeded_NoReadIsMapped)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+
+    auto index = std::make_shared<Index>();
+    setup_index(prgs, index);
+
+    // a genome of 1 base and max_covg 0: the first read already exceeds the coverage
+    MappingOptions options = setup_index_mapping_options();
+    options.genome_size = 1;
+    options.max_covg = 0;
+    options.threads = 2;
+    auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    const uint32_t covg = pangraph_from_read_file(
+        TEST_CASE_DIR + "read2.fa", pangraph, index, prgs, options);
+
+    EXPECT_TRUE(pangraph->nodes.empty());
+    EXPECT_GT(covg, (uint)0);
+
+    index->clear();
+}
+
+TEST(UtilsTest, pangraphFromReadFile_SubsampleBelowMaxCovg_AllReadsAreMapped)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+
+    auto index = std::make_shared<Index>();
+    setup_index(prgs, index);
+
+    auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fa", pangraph, index, prgs,
+        setup_index_mapping_options());
+
+    auto subsampled_pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    MappingOptions subsample_options = setup_index_mapping_options();
+    subsample_options.subsample = true;
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fa", subsampled_pangraph, index,
+        prgs, subsample_options);
+
+    EXPECT_EQ(*pangraph, *subsampled_pangraph);
+
+    index->clear();
+}
+
+TEST(UtilsTest, pangraphFromReadFile_MappingHistograms_OnlyFilledIfAsked)
+{
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+
+    auto index = std::make_shared<Index>();
+    setup_index(prgs, index);
+
+    MappingOptions options = setup_index_mapping_options();
+    MappingStats mapping_stats;
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fa",
+        std::make_shared<pangenome::Graph>(), index, prgs, options, &mapping_stats);
+    EXPECT_FALSE(mapping_stats.has_histograms);
+    EXPECT_EQ((uint64_t)0, mapping_stats.histograms.sketch_size.get_count());
+
+    options.mapping_histograms = true;
+    MappingStats mapping_stats_with_histograms;
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fa",
+        std::make_shared<pangenome::Graph>(), index, prgs, options,
+        &mapping_stats_with_histograms);
+    EXPECT_TRUE(mapping_stats_with_histograms.has_histograms);
+    EXPECT_EQ(mapping_stats_with_histograms.nb_reads_sketched,
+        mapping_stats_with_histograms.histograms.sketch_size.get_count());
+    EXPECT_GT(mapping_stats_with_histograms.nb_reads_sketched, (uint64_t)0);
+
+    index->clear();
+}
+
 TEST(UtilsTest, pangraphFromReadFile_Fq)
 {
     std::vector<std::shared_ptr<LocalPRG>> prgs;
@@ -996,8 +1332,8 @@ TEST(UtilsTest, pangraphFromReadFile_Fq)
     setup_index(prgs, index);
 
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
-    pangraph_from_read_file(
-        TEST_CASE_DIR + "read2.fq", pangraph, index, prgs, 1, 3, 1, 0.1, 1);
+    pangraph_from_read_file(TEST_CASE_DIR + "read2.fq", pangraph, index, prgs,
+        setup_index_mapping_options());
 
     // create a pangraph object representing the truth we expect (prg 3 4 2 1)
     // note that prgs 1, 3, 4 share no 3mer, but 2 shares a 3mer with each of 2 other
@@ -1193,12 +1529,12 @@ TEST(load_read_index, read_index_does_not_exist___expects_FatalRuntimeError)
 
 TEST(load_read_index, read_index_has_three_samples)
 {
-    std::vector<std::pair<SampleIdText, SampleFpath>> actual
+    std::vector<std::pair<SampleIdText, SampleFpaths>> actual
         = load_read_index(fs::path("../../test/test_cases/sample_read_index.tsv"));
-    std::vector<std::pair<SampleIdText, SampleFpath>> expected { {
-        std::make_pair("sample_1", "reads_1.fastq"),
-        std::make_pair("sample_2", "reads_2.fastq"),
-        std::make_pair("sample_3", "reads_3.fastq"),
+    std::vector<std::pair<SampleIdText, SampleFpaths>> expected { {
+        std::make_pair("sample_1", SampleFpaths { "reads_1.fastq" }),
+        std::make_pair("sample_2", SampleFpaths { "reads_2.fastq" }),
+        std::make_pair("sample_3", SampleFpaths { "reads_3.fastq" }),
     } };
 
     EXPECT_EQ(actual, expected);
@@ -1206,13 +1542,54 @@ TEST(load_read_index, read_index_has_three_samples)
 
 TEST(load_read_index, read_index_has_three_samples_and_two_are_repeated)
 {
-    std::vector<std::pair<SampleIdText, SampleFpath>> actual = load_read_index(
+    std::vector<std::pair<SampleIdText, SampleFpaths>> actual = load_read_index(
         fs::path("../../test/test_cases/sample_read_index_with_repeated_samples.tsv"));
-    std::vector<std::pair<SampleIdText, SampleFpath>> expected { {
-        std::make_pair("sample_1", "first_reads_1.fastq"),
-        std::make_pair("sample_2", "second_reads_2.fastq"),
-        std::make_pair("sample_3", "fourth_reads_3.fastq"),
+    std::vector<std::pair<SampleIdText, SampleFpaths>> expected { {
+        std::make_pair("sample_1", SampleFpaths { "first_reads_1.fastq" }),
+        std::make_pair("sample_2", SampleFpaths { "second_reads_2.fastq" }),
+        std::make_pair("sample_3", SampleFpaths { "fourth_reads_3.fastq" }),
     } };
 
     EXPECT_EQ(actual, expected);
 }
+
+TEST(load_read_index, read_index_has_samples_with_several_read_files)
+{
+    std::vector<std::pair<SampleIdText, SampleFpaths>> actual = load_read_index(
+        fs::path("../../test/test_cases/sample_read_index_with_several_files.tsv"));
+    std::vector<std::pair<SampleIdText, SampleFpaths>> expected { {
+        std::make_pair("sample_1", SampleFpaths { "reads_1.fastq" }),
+        std::make_pair("sample_2",
+            SampleFpaths { "reads_2_lane_1.fastq", "reads_2_lane_2.fastq" }),
+        std::make_pair("sample_3",
+            SampleFpaths { "reads_3_lane_1.fastq", "reads_3_lane_2.fastq",
+                "reads_3_lane_3.fastq" }),
+    } };
+
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(load_read_index, second_read_file_does_not_exist___expects_FatalRuntimeError)
+{
+    const std::string read_index_filepath = std::string(std::tmpnam(nullptr)) + ".tsv";
+    {
+        std::ofstream read_index(read_index_filepath);
+        read_index << "sample_1\t" << TEST_CASE_DIR << "read2.fa\tmissing_reads.fa\n";
+    }
+    const auto samples = load_read_index(fs::path(read_index_filepath));
+    std::remove(read_index_filepath.c_str());
+    ASSERT_EQ((size_t)1, samples.size());
+
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    auto index = std::make_shared<Index>();
+    setup_index(prgs, index);
+    auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    MappingOptions options = setup_index_mapping_options();
+    options.threads = 2;
+
+    // the error is reported before any read is mapped
+    ASSERT_EXCEPTION(pangraph_from_read_file(
+                         samples[0].second, pangraph, index, prgs, options),
+        FatalRuntimeError, "Unable to open read file missing_reads.fa");
+    EXPECT_TRUE(pangraph->nodes.empty());
+}